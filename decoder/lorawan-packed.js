@@ -0,0 +1,205 @@
+// Copyright (c) 2024 Lars Wessels
+//
+// This file a part of the "RICE-M5Tough-SensorHub" source code.
+// https://github.com/lrswss/rice-m5tough-sensorhub
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// payload decoder for the bit-packed uplink format (see include/lorapack.h)
+// and encoder for downlink commands (see include/lorawan.h), usable as
+// payload formatter on The Things Stack and as ChirpStack codec
+
+var PACKED_MAGIC = 0xA0;
+var PACKED_VERSION = 1;
+var PACKED_BATCH_VERSION = 3;
+var PACKED_MLX = 0x01;
+var PACKED_HUMIDITY = 0x02;
+var PACKED_HCHO = 0x04;
+var PACKED_IAQ = 0x08;
+var PACKED_BATTERY = 0x10;
+var PACKED_TIME = 0x20;
+var PACKED_ACK = 0x40;
+
+var COMMAND_PORT = 10;
+var CMD_READINGS_INTERVAL = 0x01;
+var CMD_UPLINK_INTERVAL = 0x02;
+var CMD_CONFIRM = 0x03;
+var CMD_READ_NOW = 0x04;
+var CMD_SAVE_BSEC = 0x05;
+
+function BitReader(bytes) {
+  this.bytes = bytes;
+  this.pos = 0;
+}
+
+// read unsigned value of given width MSB first
+BitReader.prototype.get = function (bits) {
+  var value = 0;
+  for (var i = 0; i < bits; i++) {
+    var byte = this.bytes[this.pos >> 3];
+    if (byte === undefined)
+      throw new Error("payload truncated");
+    value = value * 2 + ((byte >> (7 - (this.pos & 7))) & 1);
+    this.pos++;
+  }
+  return value;
+};
+
+// read two's complement value of given width
+BitReader.prototype.getSigned = function (bits) {
+  var value = this.get(bits);
+  return (bits > 0 && value >= Math.pow(2, bits - 1)) ? value - Math.pow(2, bits) : value;
+};
+
+// quantized fields sent as deltas in a batch: group flag, scaling and offset
+var DELTA_FIELDS = [
+  { key: "objectTemp", group: PACKED_MLX, scale: 0.1, offset: -20.0, decimals: 1 },
+  { key: "ambientTemp", group: PACKED_MLX, scale: 0.1, offset: -20.0, decimals: 1 },
+  { key: "humidity", group: PACKED_HUMIDITY, scale: 1, offset: 0, decimals: 0 },
+  { key: "hcho", group: PACKED_HCHO, scale: 0.1, offset: 0, decimals: 1 },
+  { key: "iaq", group: PACKED_IAQ, scale: 1, offset: 0, decimals: 0 },
+  { key: "eCO2", group: PACKED_IAQ, scale: 1, offset: 0, decimals: 0 },
+  { key: "VOC", group: PACKED_IAQ, scale: 0.01, offset: 0, decimals: 2 }
+];
+
+// older samples of a batch as list of readings (newest first) with timestamps
+// if the most recent readings have one, deltas are applied to the quantized values
+//
+// older samples are not taken at fixed intervals, since readings only pass
+// the device's deadband filter on significant changes, each sample carries
+// the secs passed until the next newer one, the first gap refers to the
+// most recent readings
+function decodeHistory(bits, present, data) {
+  var count = bits.get(4);
+  var gapBits = bits.get(4);
+  var fields = [], width = [], value = [];
+  var samples = [];
+  var offset = 0;
+
+  for (var i = 0; i < DELTA_FIELDS.length; i++) {
+    var field = DELTA_FIELDS[i];
+    if (present & field.group) {
+      fields.push(field);
+      width.push(bits.get(4));
+      value.push(Math.round((data[field.key] - field.offset) / field.scale));
+    }
+  }
+  for (var s = 0; s < count; s++) {
+    var sample = {};
+    offset += bits.get(gapBits);
+    if (data.ts !== undefined)
+      sample.ts = data.ts - offset * 1000;
+    for (var f = 0; f < fields.length; f++) {
+      value[f] += bits.getSigned(width[f]);
+      sample[fields[f].key] = round(value[f] * fields[f].scale + fields[f].offset, fields[f].decimals);
+    }
+    samples.push(sample);
+  }
+  return samples;
+}
+
+function round(value, decimals) {
+  var scale = Math.pow(10, decimals);
+  return Math.round(value * scale) / scale;
+}
+
+function decodePacked(bytes) {
+  var bits = new BitReader(bytes);
+  var header = bits.get(8);
+  var data = {};
+
+  if ((header & 0xF0) !== PACKED_MAGIC)
+    throw new Error("not a packed payload (CayenneLPP?)");
+  data.version = header & 0x0F;
+  if (data.version !== PACKED_VERSION && data.version !== PACKED_BATCH_VERSION)
+    throw new Error("unsupported payload version " + data.version);
+
+  var present = bits.get(8);
+  if (present & PACKED_MLX) {
+    data.objectTemp = round(bits.get(10) * 0.1 - 20.0, 1);
+    data.ambientTemp = round(bits.get(10) * 0.1 - 20.0, 1);
+  }
+  if (present & PACKED_HUMIDITY)
+    data.humidity = bits.get(7);
+  if (present & PACKED_HCHO)
+    data.hcho = round(bits.get(14) * 0.1, 1);
+  if (present & PACKED_IAQ) {
+    data.iaq = bits.get(10);
+    data.iaqAccuracy = bits.get(2);
+    data.eCO2 = bits.get(11);
+    data.VOC = round(bits.get(10) * 0.01, 2);
+  }
+  if (present & PACKED_BATTERY) {
+    data.batLevel = bits.get(7);
+    data.usbPower = bits.get(1);
+  }
+  if (present & PACKED_TIME)
+    data.ts = bits.get(32) * 1000;
+  data.runtime = bits.get(20);
+  data.seq = bits.get(16);
+  if (present & PACKED_ACK)
+    data.ack = decodeAck(bits.get(8));
+  if (data.version === PACKED_BATCH_VERSION)
+    data.history = decodeHistory(bits, present, data);
+  return data;
+}
+
+// names of the downlink commands acknowledged by the device
+function decodeAck(ack) {
+  var names = ["readingsInterval", "uplinkInterval", "confirm", "readNow", "saveBsec"];
+  var result = { error: (ack & 0x80) !== 0 };
+  for (var i = 0; i < names.length; i++) {
+    if (ack & (1 << i))
+      result[names[i]] = true;
+  }
+  return result;
+}
+
+// downlink commands from an object like { readingsInterval: 10, uplinkInterval: 120,
+// confirm: false, readNow: true, saveBsec: true }, all properties are optional
+function encodeCommands(data) {
+  var bytes = [];
+
+  if (data.readingsInterval !== undefined)
+    bytes.push(CMD_READINGS_INTERVAL, (data.readingsInterval >> 8) & 0xFF, data.readingsInterval & 0xFF);
+  if (data.uplinkInterval !== undefined)
+    bytes.push(CMD_UPLINK_INTERVAL, (data.uplinkInterval >> 8) & 0xFF, data.uplinkInterval & 0xFF);
+  if (data.confirm !== undefined)
+    bytes.push(CMD_CONFIRM, data.confirm ? 1 : 0);
+  if (data.readNow)
+    bytes.push(CMD_READ_NOW);
+  if (data.saveBsec)
+    bytes.push(CMD_SAVE_BSEC);
+  if (bytes.length === 0)
+    throw new Error("no command given");
+  return bytes;
+}
+
+function encodeDownlink(input) {
+  try {
+    return { bytes: encodeCommands(input.data), fPort: COMMAND_PORT, warnings: [], errors: [] };
+  } catch (e) {
+    return { warnings: [], errors: [e.message] };
+  }
+}
+
+function decodeUplink(input) {
+  try {
+    return { data: decodePacked(input.bytes), warnings: [], errors: [] };
+  } catch (e) {
+    return { data: {}, warnings: [], errors: [e.message] };
+  }
+}
+
+if (typeof module !== "undefined")
+  module.exports = { decodeUplink: decodeUplink, encodeDownlink: encodeDownlink };
@@ -0,0 +1,62 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+#ifndef _ACKCLIENT_H
+#define _ACKCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+#define ACK_QUEUE_SIZE 16
+#define ACK_TOPIC_MAX 64
+
+// network client passed to PubSubClient which can send QoS 1 PUBLISH packets
+// and picks up PUBACKs from the byte stream read by PubSubClient, which itself
+// only publishes with QoS 0 and silently discards incoming PUBACKs
+class AckClient : public Client {
+    public:
+        AckClient(Client &client);
+        bool beginPublish(const char *topic, uint16_t packetId, size_t length, bool duplicate);
+        bool nextAck(uint16_t *packetId, uint32_t *ackTime);
+        int connect(IPAddress ip, uint16_t port);
+        int connect(const char *host, uint16_t port);
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t size);
+        int available();
+        int read();
+        int read(uint8_t *buf, size_t size);
+        int peek();
+        void flush();
+        void stop();
+        uint8_t connected();
+        operator bool();
+        using Print::write;
+    private:
+        void reset();
+        void parse(uint8_t c);
+        Client &client;
+        uint8_t state, header, lengthShift;
+        uint32_t remaining;
+        uint16_t packetId;
+        uint16_t ackIds[ACK_QUEUE_SIZE];
+        uint32_t ackTimes[ACK_QUEUE_SIZE];
+        uint8_t ackHead, ackCount;
+};
+
+#endif
\ No newline at end of file
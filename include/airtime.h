@@ -0,0 +1,51 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _AIRTIME_H
+#define _AIRTIME_H
+
+#include <Arduino.h>
+
+#define LORAWAN_PHY_OVERHEAD 13  // MHDR, FHDR without FOpts, FPort and MIC
+#define LORAWAN_MAX_DR 5  // EU868 DR5: SF7/125 kHz
+
+// time on air in ms of an uplink with given application payload size and
+// EU868 data rate (DR0 = SF12 ... DR5 = SF7, 125 kHz, coding rate 4/5)
+uint32_t loraAirtimeMs(uint8_t dataRate, uint8_t payloadLen);
+
+// max. application payload size for EU868 data rate (without FOpts)
+uint8_t loraMaxPayload(uint8_t dataRate);
+
+// token bucket of airtime refilled with the duty cycle's share of elapsed
+// time, uplinks are only allowed while enough airtime is left in the bucket
+class DutyCycle {
+    public:
+        DutyCycle(uint16_t permille, uint32_t capacityMs);
+        bool consume(uint32_t airtimeMs);
+        uint32_t available();
+        uint32_t waitMs(uint32_t airtimeMs);
+    private:
+        void refill();
+        uint16_t permille;
+        uint64_t tokens, capacity;  // ms of airtime * 1000
+        uint32_t lastRefill;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+#ifndef _ATPARSER_H
+#define _ATPARSER_H
+
+#include <Arduino.h>
+
+#define AT_LINE_SIZE 128
+#define AT_PREFIX_SIZE 16
+#define AT_MAX_HANDLERS 8
+#define AT_LOCK_TIMEOUT_MS 2000
+#define AT_RX_WAIT_MS 50  // fallback polling if UART receive events are missed
+
+enum atResult {
+    AT_OK = 0,
+    AT_ERROR,
+    AT_TIMEOUT,
+    AT_BUSY
+};
+
+// called by parser task with each line of an unsolicited result code (URC)
+typedef void (*urcHandler_t)(const char *line, void *arg);
+
+typedef struct {
+    const char *prefix;
+    urcHandler_t handler;
+    void *arg;
+} urcHandlerEntry_t;
+
+// line based AT command engine, a background task splits received data into
+// lines as soon as the UART signals new data, completes the pending command
+// with its final result line ('OK', 'ERROR', ...) and passes all other lines
+// (unsolicited result codes) to the handlers registered for their prefix
+class ATParser {
+    public:
+        ATParser();
+        ~ATParser();
+        bool begin(HardwareSerial *serial);
+        void end();
+        bool onURC(const char *prefix, urcHandler_t handler, void *arg);
+        atResult command(const char *cmd, char *resp, size_t size, uint16_t timeout);
+    private:
+        static void rxTaskWrapper(void *parameter);
+        void rxTask();
+        void parseLine(const char *line);
+        bool finalResult(const char *line, atResult *result);
+        bool responseLine(const char *line);
+        void append(const char *line);
+        HardwareSerial *serial;
+        TaskHandle_t rxTaskHandle;
+        SemaphoreHandle_t cmdLock, stateLock, done;
+        urcHandlerEntry_t handlers[AT_MAX_HANDLERS];
+        uint8_t handlerCount;
+        char line[AT_LINE_SIZE];
+        uint8_t lineLen;
+        bool pending;  // command is waiting for its final result
+        char prefix[AT_PREFIX_SIZE];  // e.g. '+CSTATUS' for 'AT+CSTATUS?'
+        char *resp;
+        size_t respSize, respLen;
+        atResult result;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _BACKLOG_H
+#define _BACKLOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "sensors.h"
+
+#define BACKLOG_DIR "/backlog"
+#define BACKLOG_ACK_FILE BACKLOG_DIR "/ack"
+#define BACKLOG_SEGMENT_RECORDS 256
+#define BACKLOG_MAX_SEGMENTS 32  // ~590 KB flash, oldest segment is dropped if exceeded
+#define BACKLOG_RECORD_MAGIC 0x5253
+
+// fixed size record appended to a segment file
+typedef struct {
+    uint16_t magic;
+    uint16_t length;
+    uint32_t crc;
+    sensorReadings_t data;
+} backlogRecord_t;
+
+// position of oldest readings not yet acknowledged by the receiver
+typedef struct {
+    uint32_t segment;
+    uint32_t record;
+    uint32_t crc;
+} backlogAck_t;
+
+// append-only ring log on the LittleFS partition buffering sensor readings
+// while the uplink is down, survives resets and deep sleep, not thread-safe
+class SampleLog {
+    public:
+        SampleLog();
+        bool begin();
+        bool append(const sensorReadings_t *data);
+        bool read(uint32_t index, sensorReadings_t *data);
+        void release(uint32_t count);
+        uint32_t pending();
+        uint32_t dropped();
+    private:
+        void segmentPath(uint32_t segment, char *path, size_t len);
+        uint32_t segmentRecords(uint32_t segment);
+        void repairSegment(uint32_t segment);
+        bool storeAck();
+        bool loadAck();
+        bool mounted;
+        uint32_t lastSegment, lastRecords;
+        uint32_t droppedRecords;
+        backlogAck_t ack;
+};
+
+extern SampleLog Backlog;
+#endif
@@ -0,0 +1,45 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _BITWRITER_H
+#define _BITWRITER_H
+
+#include <Arduino.h>
+
+// packs unsigned or two's complement values of arbitrary bit width MSB
+// first into a caller supplied buffer, the last byte is padded with zero
+// bits, the output is truncated and flagged as overflowed if the buffer
+// is too small
+class BitWriter {
+    public:
+        BitWriter(uint8_t *buf, size_t size);
+        void reset();
+        void put(uint32_t value, uint8_t bits);
+        void putSigned(int32_t value, uint8_t bits);
+        size_t bits();
+        size_t length();
+        bool overflowed();
+    private:
+        uint8_t *buf;
+        size_t size, bitLen;
+        bool overflow;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "bme680.h"
 #include "sfa30.h"
 #include "mlx90614.h"
+#include "bus.h"
 
 // UUIDs for GATT services
 // https://www.bluetooth.com/specifications/assigned-numbers/
@@ -44,6 +45,7 @@
 // custom UUIDs for characteristic missing in above assigned numbers specs
 #define BLE_IAQ_UUID "3118ab5a-c9e6-48d1-91c2-3ca1652a61c6"  // Air Quality Index
 #define BLE_HCHO_UUID "f202b62d-3794-4388-987c-509780b18326"  // Formaldehyde (ppb)
+#define BLE_SAMPLE_UUID "6e7a3c1d-52b4-4f0e-9d8a-1b2c3d4e5f60"  // UTC timestamp (ms) and sequence number
 
 #define BLE_USER_DESC_UUID (BLEUUID((uint16_t)0x2901))
 #define BLE_PROP_NOTIFY_READ (NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ)
@@ -54,9 +56,13 @@ class GATTServer {
     public:
         GATTServer();
         bool begin();
-        void notify(sensorReadings_t data);
         ~GATTServer();
     private:
+        void notify(sensorReadings_t data);
+        void notifyTask();
+        static void notifyTaskWrapper(void* parameter);
+        int8_t busId;
+        TaskHandle_t notifyTaskHandle;
         char bleServerName[32];
         NimBLEServer *pServer;
         NimBLEService *devInfoService;
@@ -68,6 +74,7 @@ class GATTServer {
         NimBLECharacteristic *iaqCharacteristic;
         NimBLECharacteristic *eco2Characteristic;
         NimBLECharacteristic *vocCharacteristic;
+        NimBLECharacteristic *sampleCharacteristic;
         NimBLECharacteristic *modelCharacteristic;
         NimBLECharacteristic *manufacturerCharacteristic;
         NimBLECharacteristic *firmwareCharacteristic;
@@ -23,10 +23,43 @@
 
 #include <Arduino.h>
 #include <M5Tough.h>
+#include <atomic>
 #include <bsec.h>
 #include "sensors.h"
 
 #define BME680_STATE_SAVE_PERIOD  (120 * 60 * 1000)  // every 2 hours
+#define BME680_STATE_SLOTS 2
+#define BME680_STATE_KEY "bsecState%u"  // NVS key of each slot
+#define BME680_RETRY_MS 3000  // wait after failed BSEC call
+#define BME680_STATS_INTERVAL_SECS 600
+#define BME680_LATENESS_BUCKETS 8
+#define BME680_ULP_BATTERY_LEVEL 50  // use ULP sampling below this level (%)
+#define BME680_ULP_HYSTERESIS 5      // back to LP sampling above level + hysteresis
+
+// BSEC sampling profiles, LP (3 secs) or ULP (300 secs) to save battery
+enum bsecProfile {
+    BSEC_PROFILE_LP = 0,
+    BSEC_PROFILE_ULP
+};
+
+// BSEC calibration state saved to NVS, written alternately to both
+// slots so that an interrupted write never destroys the previous state
+typedef struct {
+    uint32_t counter;  // incremented with each write, newest valid slot wins
+    uint8_t state[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t crc;
+} bsecState_t;
+
+// BSEC outputs copied to the sensor readings by read()
+typedef struct {
+    float temperature;
+    uint8_t humidity;
+    uint16_t iaq;
+    uint8_t iaqAccuracy;
+    uint16_t gasResistance;  // kOhm
+    uint16_t eCO2;
+    float VOC;
+} bsecOutputs_t;
 
 class BME680 : public Sensors {
     public:
@@ -34,18 +67,39 @@ class BME680 : public Sensors {
         bool setup();
         bool read();
         uint8_t status();
-        bool changed();
-        void display();
-        void console();
+        void display(const sensorReadings_t &data);
+        void console(const sensorReadings_t &data);
+        void requestStateSave();
+        void checkPower();
+        static bool importState(const uint8_t *state);
     private:
         Bsec bsec;
         bool ready;
         bool error;
+        std::atomic<uint8_t> state;  // status() of last BSEC call
+        std::atomic<uint8_t> profileRequest;  // set by checkPower()
+        uint8_t profile;  // applied by bsecTask()
+        bsecOutputs_t outputs[2];    // double-buffered like SensorSnapshot
+        std::atomic<uint32_t> sequence;
+        uint32_t lastRead;
+        uint32_t lateness[BME680_LATENESS_BUCKETS];  // histogram of BSEC call delays
+        uint32_t maxLateness;
+        uint32_t violations;
+        TaskHandle_t bsecTaskHandle;
+        uint8_t init(bool restore);
+        bool applyProfile(uint8_t profile);
+        void publish();
+        void recordLateness(int64_t ms);
+        void printLateness();
+        void bsecTask();
+        static void bsecTaskWrapper(void* _this);
         static const char* accuracy(uint8_t data);
         static void dialogResetBSEC();
-        static bool updateState(Bsec bsec);
-        static void loadState(Bsec bsec);
-        static uint8_t status(Bsec bsec);
+        static bool updateState(Bsec &bsec);
+        static bool writeState(const uint8_t *state);
+        static void loadState(Bsec &bsec);
+        static void clearState();
+        static uint8_t status(Bsec &bsec);
         static void eventResetBSEC(Event& e);
 };
 
@@ -0,0 +1,64 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _BUS_H
+#define _BUS_H
+
+#include <Arduino.h>
+#include "sensors.h"
+
+#define BUS_MAX_SUBSCRIBERS 4
+#define BUS_BLOCK_TIMEOUT_MS 250
+#define BUS_STATS_INTERVAL_SECS 600
+
+// what to do if a subscriber's queue is full
+enum dropPolicy {
+    LATEST_ONLY = 0,  // queue holds only the most recent sample
+    DROP_OLDEST,      // discard oldest queued sample
+    BLOCK             // wait up to BUS_BLOCK_TIMEOUT_MS, then drop new sample
+};
+
+typedef struct {
+    const char *name;
+    QueueHandle_t queue;
+    dropPolicy policy;
+    volatile uint32_t delivered;
+    volatile uint32_t dropped;
+} busSubscriber_t;
+
+// fan-out of published sensor readings to all
+// registered transports (MQTT, LoRaWAN, GATT)
+class ReadingsBus {
+    public:
+        ReadingsBus();
+        int8_t subscribe(const char *name, uint8_t depth, dropPolicy policy);
+        void unsubscribe(int8_t id);
+        void publish(const sensorReadings_t *data);
+        bool receive(int8_t id, sensorReadings_t *data, TickType_t ticks);
+        uint32_t delivered(int8_t id);
+        uint32_t dropped(int8_t id);
+        void console();
+    private:
+        busSubscriber_t subscribers[BUS_MAX_SUBSCRIBERS];
+        SemaphoreHandle_t lock;
+};
+
+extern ReadingsBus Bus;
+#endif
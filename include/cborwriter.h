@@ -0,0 +1,59 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _CBORWRITER_H
+#define _CBORWRITER_H
+
+#include <Arduino.h>
+
+#define CBOR_MAX_DEPTH 4
+
+// writes CBOR (RFC 8949) directly to a caller supplied buffer without heap
+// allocations, arrays and maps have definite lengths which are filled in
+// when they are closed, fixed-point numbers are encoded as integer if they
+// have no fraction, as float or double otherwise, the output is truncated
+// and flagged as overflowed if the buffer is too small
+class CborWriter {
+    public:
+        CborWriter(uint8_t *buf, size_t size);
+        void reset();
+        void beginArray();
+        void endArray();
+        void beginMap();
+        void endMap();
+        void addInt(int64_t value);
+        void addNumber(int64_t value, uint8_t decimals = 0);
+        void addString(const char *value);
+        size_t length();
+        bool overflowed();
+    private:
+        void endContainer(uint8_t major, uint16_t count);
+        void item();
+        void putHead(uint8_t major, uint64_t value);
+        void put(uint8_t b);
+        uint8_t *buf;
+        size_t size, len;
+        size_t start[CBOR_MAX_DEPTH];  // offset of container's header
+        uint16_t items[CBOR_MAX_DEPTH];
+        uint8_t depth;
+        bool overflow;
+};
+
+#endif
@@ -21,23 +21,64 @@
 #ifndef _CONFIG_H
 #define _CONFIG_H
 
-#define MQTT_PUBLISH_INTERVAL_SECS 15
+#define MQTT_PUBLISH_INTERVAL_SECS 300  // max. silence, see DEADBAND_CONFIG
 #define MQTT_BROKER_HOST "192.168.10.1"
 #define MQTT_BROKER_PORT 1883
 #define MQTT_TOPIC  "m5tough/state"
 //#define MQTT_USER "username"
 //#define MQTT_PASS "password"
 
+// publish several readings per MQTT message, either as array of samples
+// or columnar (one array per field), incomplete batches are published
+// after MQTT_BATCH_SECS, batch size 1 sends one message per reading
+#define MQTT_BATCH_SIZE 1
+#define MQTT_BATCH_SECS 60
+//#define MQTT_BATCH_COLUMNAR
+
+// QoS 1 keeps readings in the flash backlog until the broker acknowledged
+// them, up to MQTT_INFLIGHT_WINDOW messages are sent without waiting for
+// their acknowledgement, QoS 0 publishes without any delivery guarantee
+#define MQTT_QOS 0
+#define MQTT_INFLIGHT_WINDOW 4
+
+// delta payloads only carry fields which changed beyond their deadband
+// (see DEADBAND_CONFIG) since they were last published, all fields and
+// the device status are sent in keyframes every MQTT_KEYFRAME_SECS
+//#define MQTT_DELTA_PAYLOAD
+#define MQTT_KEYFRAME_SECS 600
+
+// publish each sensor reading to a retained topic '<base topic>/<key>'
+// in addition to the JSON document, optionally announced to Home
+// Assistant (implies field topics), device availability is published
+// to '<base topic>/status' in both cases
+//#define MQTT_FIELD_TOPICS
+//#define MQTT_HA_DISCOVERY
+#define MQTT_DISCOVERY_PREFIX "homeassistant"
+
+// publish readings as Sparkplug B NDATA (protobuf) instead of JSON to
+// 'spBv1.0/<group id>/NDATA/M5Tough_<system id>', metrics are declared
+// with NBIRTH after connecting, NDEATH is registered as last will
+// (disables field topics and Home Assistant discovery)
+//#define MQTT_SPARKPLUG
+#define SPARKPLUG_GROUP_ID "RICE"
+
+// publish readings as SenML pack (RFC 8428) instead of the JSON document,
+// 0 = off, 1 = JSON, 2 = CBOR, base name is the system id, the first
+// sample's timestamp is sent as base time (ignored if Sparkplug is enabled)
+#define MQTT_SENML 0
+
 // uncomment to enable (optional) Bluetooh LE GATT server
 //#define BLE_SERVER
 
 #define SENSOR_READING_INTERVAL_SECS 5
 #define DISPLAY_DIALOG_TIMEOUT_SECS 5
 
-#define HCHO_PUBLISH_TRESHOLD 1.0
-#define TEMP_PUBLISH_THRESHOLD 0.2
-#define HUM_PUBLISH_THRESHOLD 1
-#define GASRESISTANCE_PUBLISH_THRESHOLD 5  // kOhms
+// readings are published if a field has changed by at least its threshold
+// since it was last published (plus hysteresis if the change reverses its
+// direction), but not more often than every minSecs, and at least every
+// MQTT_PUBLISH_INTERVAL_SECS, "key:threshold/hysteresis/minSecs,..."
+// with keys and units as in SensorSchema (see schema.cpp)
+#define DEADBAND_CONFIG "objectTemp:0.2/0.1/0,hcho:1/0.5/0,humidity:1/1/0,gasResistance:5/2/0"
 
 // MLX90614 IR thermometer
 #define TEMP_THRESHOLD_RED 30.0
@@ -51,6 +92,18 @@
 //#define LORAWAN_APPEUI "0000000000000000"
 #define LORAWAN_INTERVAL_SECS 60
 #define LORAWAN_CONFIRM false
+#define LORAWAN_PACKED false  // bit-packed payload instead of CayenneLPP (see lorapack.h)
+#define LORAWAN_BATCH false  // add intermediate samples as deltas (see lorapack.h)
+#define LORAWAN_BATCH_STEP_SECS 60
+
+// LORAWAN_INTERVAL_SECS applies to DR3 (SF9), at other data rates the
+// interval is scaled with the uplink's airtime, uplinks are held back
+// while the duty cycle's airtime budget is used up, readings which have
+// changed by their deadband threshold (see DEADBAND_CONFIG) or entered
+// or left an alarm range are sent early
+#define LORAWAN_DUTY_CYCLE_PERMILLE 10  // EU868 sub-band g1: 1%
+#define LORAWAN_ALARM_HCHO_PPB 80
+#define LORAWAN_ALARM_IAQ 200
 #define LORAWAN_TX_PIN 14
 #define LORAWAN_RX_PIN 13
 
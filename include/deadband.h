@@ -0,0 +1,60 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+#ifndef _DEADBAND_H
+#define _DEADBAND_H
+
+#include <Arduino.h>
+#include "sensors.h"
+#include "schema.h"
+
+#define DEADBAND_MAX_FIELDS 8
+#define DEADBAND_CONFIG_SIZE 128
+
+typedef struct {
+    const sensorField_t *field;
+    int64_t threshold;  // fixed-point with field's number of decimals
+    int64_t hysteresis;
+    uint16_t minIntervalSecs;
+    int64_t published;  // value of last published readings
+    int8_t trend;  // direction of last published change
+    time_t publishedAt;
+    bool valid;
+} deadbandField_t;
+
+// send-on-delta filter deciding whether a set of readings is worth publishing,
+// compares each configured field against its last published value (not the
+// previous reading) so slow drifts are eventually published as well
+class DeadbandFilter {
+    public:
+        DeadbandFilter();
+        bool configure(const char *config);
+        static bool validate(const char *config);
+        bool check(const sensorReadings_t &data);
+        int64_t threshold(const sensorField_t *field);
+    private:
+        static bool parse(const char *config, deadbandField_t *parsed, uint8_t *num);
+        static bool parseField(char *entry, deadbandField_t *f);
+        deadbandField_t fields[DEADBAND_MAX_FIELDS];
+        uint8_t count;
+        time_t lastPublished;
+};
+
+extern DeadbandFilter Deadband;
+#endif
@@ -0,0 +1,56 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _JSONWRITER_H
+#define _JSONWRITER_H
+
+#include <Arduino.h>
+
+#define JSON_MAX_DEPTH 8
+
+// writes JSON directly to a caller supplied buffer without heap allocations,
+// numbers are passed as fixed-point integers and never formatted as float,
+// the output is truncated and flagged as overflowed if the buffer is too small
+class JsonWriter {
+    public:
+        JsonWriter(char *buf, size_t size);
+        void reset();
+        void beginObject(const char *key = NULL);
+        void endObject();
+        void beginArray(const char *key = NULL);
+        void endArray();
+        void addNumber(const char *key, int64_t value, uint8_t decimals = 0);
+        void addString(const char *key, const char *value);
+        void addNull(const char *key = NULL);
+        size_t length();
+        bool overflowed();
+    private:
+        void separator(const char *key);
+        void put(char c);
+        void put(const char *str);
+        void putEscaped(const char *str);
+        char *buf;
+        size_t size, len;
+        uint8_t depth;
+        uint8_t first;  // bit set while no member has been written at depth
+        bool overflow;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _LORAPACK_H
+#define _LORAPACK_H
+
+#include <Arduino.h>
+#include "sensors.h"
+#include "bitwriter.h"
+
+// first byte of a packed payload, CayenneLPP payloads start with a channel (1-11)
+#define PACKED_MAGIC 0xA0
+#define PACKED_VERSION 1
+#define PACKED_BATCH_VERSION 3
+#define PACKED_BATCH_SAMPLES 15
+
+// presence bitmap, a field group is left out if its flag isn't set
+#define PACKED_MLX 0x01
+#define PACKED_HUMIDITY 0x02
+#define PACKED_HCHO 0x04
+#define PACKED_IAQ 0x08
+#define PACKED_BATTERY 0x10
+#define PACKED_TIME 0x20
+#define PACKED_ACK 0x40
+
+// bit-packed uplink payload, version 1 (see decoder/lorawan-packed.js),
+// all fields are unsigned and written MSB first, values out of range are
+// clamped, the last byte is padded with zero bits
+//
+//   8 bits  PACKED_MAGIC | PACKED_VERSION
+//   8 bits  presence bitmap
+//  10 bits  object temperature, 0.1 °C, offset -20.0 °C      PACKED_MLX
+//  10 bits  ambient temperature, 0.1 °C, offset -20.0 °C     PACKED_MLX
+//   7 bits  relative humidity, %                             PACKED_HUMIDITY
+//  14 bits  formaldehyde, 0.1 ppb                            PACKED_HCHO
+//  10 bits  IAQ index                                        PACKED_IAQ
+//   2 bits  IAQ accuracy                                     PACKED_IAQ
+//  11 bits  eCO2, ppm                                        PACKED_IAQ
+//  10 bits  VOC, 0.01 ppm                                    PACKED_IAQ
+//   7 bits  battery level, %                                 PACKED_BATTERY
+//   1 bit   USB powered                                      PACKED_BATTERY
+//  32 bits  timestamp, seconds since epoch                   PACKED_TIME
+//  20 bits  runtime, minutes
+//  16 bits  sequence number, lower 16 bits
+//   8 bits  acknowledged downlink commands (see lorawan.h)  PACKED_ACK
+//
+// a full payload without ack has 167 bits (21 bytes)
+//
+// version 3 (batch) starts with a version 1 payload holding the most recent
+// readings, followed by older samples taken since the last uplink, each
+// sent as signed difference (two's complement) to the next newer sample
+// together with the time passed between both samples, samples are not
+// taken at fixed intervals (see ASR6501::addHistory())
+//
+//   4 bits  number of older samples n (0-15)
+//   4 bits  gap width g
+//   4 bits  delta width w per field in the order below (0: unchanged),
+//           only for fields whose group is present:
+//           object temp., ambient temp., humidity, HCHO, IAQ, eCO2, VOC
+//   n times
+//     g bits  secs between this sample and the next newer one
+//     w bits  delta of each present field
+//
+// older samples are dropped from the end if the buffer is too small
+size_t packReadings(const sensorReadings_t &data, uint8_t sensors, uint8_t *buf, size_t size,
+    uint8_t ack = 0);
+
+enum packedField {
+    PACKED_OBJECT_TEMP = 0,
+    PACKED_AMBIENT_TEMP,
+    PACKED_HUM,
+    PACKED_HCHO_PPB,
+    PACKED_IAQ_INDEX,
+    PACKED_ECO2,
+    PACKED_VOC,
+    PACKED_FIELDS
+};
+
+// quantized readings of a sample as sent in a batch
+typedef struct {
+    uint16_t value[PACKED_FIELDS];
+} packedSample_t;
+
+void packSample(const sensorReadings_t &data, uint8_t sensors, packedSample_t *sample);
+size_t packBatch(const sensorReadings_t &data, uint8_t sensors, const packedSample_t *history,
+    const uint16_t *gaps, uint8_t *count, uint8_t *buf, size_t size, uint8_t ack = 0);
+
+#endif
@@ -28,21 +28,35 @@
 #include "sfa30.h"
 #include "mlx90614.h"
 #include "utils.h"
+#include "bus.h"
+#include "lorapack.h"
+#include "airtime.h"
+#include "atparser.h"
 
 #define LORAWAN_MODULE_TIMEOUT_SECS 5
 #define LORAWAN_COMMAND_TIMEOUT_MS 1000
 #define LORAWAN_JOIN_TIMEOUT_SECS 20
 #define LORAWAN_JOIN_RETRY_SECS 180
 #define LORAWAN_LPP_SIZE 64
+#define LORAWAN_LPP_TRIM_MAX 3  // optional CayenneLPP channels (see fillLPP())
+#define LORAWAN_BATCH_SIZE 128
+#define LORAWAN_BATCH_QUEUE 4
+#define LORAWAN_REFERENCE_DR 3  // data rate 'lorawanIntervalSecs' applies to
+#define LORAWAN_MIN_INTERVAL_SECS 15
+#define LORAWAN_MAX_INTERVAL_SECS 1800
+#define LORAWAN_DUTY_BUCKET_MS 8400  // burst of 3 max. size uplinks at DR0
+#define LORAWAN_LINKCHECK_UPLINKS 10  // request link check with every n-th uplink
+#define LORAWAN_LINKCHECK_FAILURES 3  // rejoin after n link checks without answer
+#define LORAWAN_SETTING_SIZE 48
+#define LORAWAN_FINGERPRINT_KEY "lorawanCfg"
+#define LORAWAN_SESSION_KEY "lorawanSess"
+#define LORAWAN_DOWNLINK_SIZE 32
+#define LORAWAN_DOWNLINK_QUEUE 2
 //#define LORAWAN_DEBUG_SERIAL_CMDS
 
-// ensure exclusive access to serial port
-#define SEMAPHORE_BLOCKTIME_MS 2000/portTICK_PERIOD_MS
-
 enum lorawanState {
     NONE = 0,
     IDLE,
-    COMMAND,
     JOINING,
     JOINFAIL,
     JOINED,
@@ -50,32 +64,107 @@ enum lorawanState {
     ERROR
 };
 
+// downlink commands on LORAWAN_COMMAND_PORT, several commands may be sent
+// in one downlink, multi-byte arguments are big-endian, each command sets
+// bit (opcode - 1) in the ack byte of the next uplink (CayenneLPP channel 12
+// or field PACKED_ACK), bit 7 is set if a command was invalid or failed
+#define LORAWAN_COMMAND_PORT 10
+#define LORAWAN_CMD_READINGS_INTERVAL 0x01  // uint16 secs, 3-60
+#define LORAWAN_CMD_UPLINK_INTERVAL 0x02  // uint16 secs, 30-300
+#define LORAWAN_CMD_CONFIRM 0x03  // uint8, 0: unconfirmed, 1: confirmed uplinks
+#define LORAWAN_CMD_READ_NOW 0x04  // take readings and send them right away
+#define LORAWAN_CMD_SAVE_BSEC 0x05  // save BSEC state to flash
+#define LORAWAN_ACK_ERROR 0x80
+
+typedef struct {
+    uint8_t len;
+    uint8_t data[LORAWAN_DOWNLINK_SIZE];
+} lorawanDownlink_t;
+
+// joined session saved to NVS, reused after a reboot or deep sleep
+// as long as the adapter still reports it as active
+typedef struct {
+    uint32_t fingerprint;  // adapter settings the session was joined with
+    char devAddr[9];
+} lorawanSession_t;
+
+// adapter settings applied by ASR6501::configure()
+enum lorawanSetting {
+    SET_JOINMODE = 0,
+    SET_DEVEUI,
+    SET_APPEUI,
+    SET_APPKEY,
+    SET_CLASS,
+    SET_ADR,
+    SET_WORKMODE,
+    SET_BANDMASK,
+    SET_RX2,
+    SET_CONFIRM,
+    SET_TRIALS,
+    LORAWAN_SETTINGS
+};
+
+// CayenneLPP payload as sent by ASR6501::encodeLPP()
+void fillLPP(CayenneLPP &lpp, const sensorReadings_t &data, uint8_t sensors, uint8_t trim,
+    uint8_t ack = 0);
+
 class ASR6501 {
     public:
         ASR6501();
         ASR6501(HardwareSerial* serialPort, uint8_t rxPin, uint8_t txPin);
         bool begin(HardwareSerial* serialPort, uint8_t rxPin, uint8_t txPin);
-        bool queue(sensorReadings_t data);
         lorawanState status();
         ~ASR6501();
     private:
         bool connected();
         void join();
         bool joined();
+        bool readDevAddr(char *devAddr);
+        void saveSession();
+        bool resumeSession();
         const char* getDevEUI();
-        bool setOTAA(const char* appEUI, const char* appKey);
+        const char* setting(uint8_t index);
+        bool applySettings(uint8_t first, uint8_t last);
+        uint32_t fingerprint();
+        bool configured();
+        bool configure();
         bool setupFailed(const char* msg);
         void joinTask();
         static void joinTaskWrapper(void* parameter);
         void queueTask();
         static void queueTaskWrapper(void* parameter);
-        const char* sendCmd(const char* cmd);
-        const char* sendCmd(const char* cmd, uint16_t timeout);
-        const char* encodeLPP(sensorReadings_t sensors);
+        bool sendCmd(const char* cmd, char* resp = NULL, size_t size = 0,
+            uint16_t timeout = LORAWAN_COMMAND_TIMEOUT_MS);
+        void readDataRate();
+        static void onJoin(const char* line, void* _this);
+        static void onStatus(const char* line, void* _this);
+        static void onSendFailed(const char* line, void* _this);
+        static void onDownlink(const char* line, void* _this);
+        static void onLinkCheck(const char* line, void* _this);
+        uint8_t runCommands(const uint8_t *cmd, uint8_t len);
+        uint32_t uplinkInterval(uint32_t airtime);
+        bool alarm(const sensorReadings_t &data);
+        bool urgent(const sensorReadings_t &data);
+        const char* encodeLPP(sensorReadings_t sensors, uint8_t maxLen);
+        const char* encodePacked(const sensorReadings_t &data, uint8_t maxLen);
+        const char* encodeBatch(const sensorReadings_t &data, time_t receivedAt, uint8_t maxLen);
+        void addHistory(const sensorReadings_t &data, time_t receivedAt);
         HardwareSerial *serial;
         lorawanState deviceState;
-        SemaphoreHandle_t SerialLock;
-        QueueHandle_t msgQueue;
+        DutyCycle dutyCycle;
+        uint8_t dataRate, payloadLen;
+        int16_t linkRssi;
+        int8_t linkSnr;
+        uint8_t linkMargin, linkGateways, linkFailures;
+        sensorReadings_t lastSent;
+        bool lastSentValid;
+        packedSample_t history[PACKED_BATCH_SAMPLES];  // newest first
+        uint8_t historyLen, historyStep;
+        time_t historyAt[PACKED_BATCH_SAMPLES];  // millis() when received
+        ATParser at;
+        QueueHandle_t downlinkQueue;
+        uint8_t ack;
+        int8_t busId;
         TaskHandle_t joinTaskHandle, queueTaskHandle;
 };
 
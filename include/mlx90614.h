@@ -32,9 +32,8 @@ class MLX90614 : public Sensors {
         bool setup();
         bool read();
         uint8_t status();
-        bool changed();
-        void display();
-        void console();
+        void display(const sensorReadings_t &data);
+        void console(const sensorReadings_t &data);
     private:
         Adafruit_MLX90614 mlx;
         bool ready;
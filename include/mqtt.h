@@ -23,35 +23,136 @@
 
 #include <Arduino.h>
 #include <PubSubClient.h>
-#include <ArduinoJson.h>
 #include <WiFi.h>
 #include "bme680.h"
 #include "sfa30.h"
 #include "mlx90614.h"
+#include "bus.h"
+#include "backlog.h"
+#include "ackclient.h"
+#include "jsonwriter.h"
+#include "sparkplug.h"
+#include "senml.h"
+#include "schema.h"
+#include "deadband.h"
+#include "prefs.h"
 #include "config.h"
 
 #define MQTT_RETRY_SECS 10
+#define MQTT_KEEPALIVE_SECS 60
+#define MQTT_LOOP_INTERVAL_MS 250
+#define MQTT_BACKOFF_MIN_MS 2000
+#define MQTT_BACKOFF_MAX_MS 300000
+#define MQTT_DNS_RETRY_FAILS 3  // resolve broker again after consecutive failures
+#define MQTT_QUEUE_DEPTH 8
+#define MQTT_BACKLOG_MESSAGES 10  // messages published from backlog per second
+#define MQTT_BATCH_MAX 20
+#define MQTT_SENML_BATCH_MAX 16  // SenML JSON needs up to 240 bytes per sample
+// fits MQTT_BATCH_MAX samples with all fields as JSON, Sparkplug or SenML CBOR,
+// but only MQTT_SENML_BATCH_MAX samples as SenML JSON
+#define MQTT_PAYLOAD_SIZE 4608
+#define MQTT_INFLIGHT_MAX 8
+#define MQTT_ACK_TIMEOUT_MS 10000  // resend QoS 1 messages without PUBACK
+#define MQTT_TASK_STACK 6144  // encoding a batch takes ~3.6 KB (see native bench)
+#define MQTT_CONN_TASK_STACK 4096
+#define MQTT_STACK_MIN_FREE 768  // warn if less stack is left
+#define MQTT_LOCK_WAIT_MS 100  // publishing gives up while connectionTask connects
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
-extern UBaseType_t stackMqttPublishTask;
+extern UBaseType_t stackMqttPublishTask, stackMqttConnTask;
 #endif
 
+// QoS 1 message awaiting its PUBACK, covers 'records' backlog records
+typedef struct {
+    uint16_t packetId;
+    uint16_t records;
+    uint32_t sentAt;
+    bool acked;
+} inflightMsg_t;
+
+// field values consumers received with the last published message,
+// fields not changed beyond their deadband are left out of delta payloads
+typedef struct {
+    int64_t value[SCHEMA_MAX_FIELDS];
+    uint32_t valid;  // bit set if field's value has been sent
+} deltaState_t;
+
+// Home Assistant sensor metadata for a schema field
+typedef struct {
+    const char *key;
+    const char *name;
+    const char *unit;
+    const char *deviceClass;
+} haSensor_t;
+
 class MQTT {
     public:
         MQTT();
         bool begin();
-        bool queue(sensorReadings_t data);
-        bool schedule();
+        uint32_t connects();
+        uint32_t disconnects();
+        size_t encode(const sensorReadings_t *data, uint8_t count, uint8_t sensors, char *buf, size_t size,
+            deltaState_t *state = NULL);
+        size_t encodeSparkplug(const sensorReadings_t *data, uint8_t count, uint8_t sensors, uint8_t *buf,
+            size_t size, deltaState_t *state = NULL);
+        size_t encodeSenml(const sensorReadings_t *data, uint8_t count, uint8_t sensors, uint8_t *buf,
+            size_t size, bool cbor, deltaState_t *state = NULL);
+        static uint32_t dropInflight(inflightMsg_t *inflight, uint8_t *count, uint32_t records);
         ~MQTT();
     private:
         bool connect(bool startup);
-        bool publish(sensorReadings_t data);
+        bool lockClient();
+        bool resolveBroker();
+        void connectionTask();
+        static void connectionTaskWrapper(void* parameter);
+        bool publish(const sensorReadings_t *data, uint8_t count, uint16_t packetId = 0, bool duplicate = false);
+        uint8_t qos();
+        uint8_t batchLimit();
+        uint32_t readBacklog(uint32_t offset, uint32_t limit, uint8_t *count);
+        bool publishBacklog();
+        bool publishWindow();
+        void matchAcks();
+        void publishFailed();
+        bool retryPending();
+        void flushBatch();
+        bool fieldChanged(uint8_t index, uint8_t sensors, const sensorReadings_t &data, const deltaState_t *state);
+        void addReadings(JsonWriter &json, uint8_t sensors, const sensorReadings_t &data,
+            deltaState_t *state, bool keyframe);
+        void addStatus(JsonWriter &json);
+        size_t encodeDeath(char *buf, size_t size);
+        bool publishBirth();
+        bool publishDiscovery();
+        void publishFields(const sensorReadings_t &data);
         void publishTask();
         static void publishTaskWrapper(void* parameter);
-        time_t lastPublished;
+        time_t retryTime, batchStarted, lastKeyframe;  // retryTime: last failed publish
+        deltaState_t deltaState, fieldsState;
+        uint32_t discoverySession, fieldsSession;
+        char statusTopic[PARAMETER_SIZE+8];
+        sensorReadings_t lastReadings;  // declared with NBIRTH
+        bool lastReadingsValid;
+        uint8_t bdSeq, sparkplugSeq;
+        sensorReadings_t batch[MQTT_BATCH_MAX], resend[MQTT_BATCH_MAX];
+        uint8_t batchCount;
+        bool oversized;  // last publish failed since payload didn't fit
+        char payload[MQTT_PAYLOAD_SIZE];
         PubSubClient mqtt;
         WiFiClient espClient;
-        QueueHandle_t msgQueue;
-        TaskHandle_t publishTaskHandle;
+        AckClient ackClient;
+        inflightMsg_t inflight[MQTT_INFLIGHT_MAX];
+        uint8_t inflightCount;
+        uint32_t inflightRecords, inflightSession;
+        uint32_t backlogDropped;  // Backlog.dropped() already removed from window
+        uint16_t packetId;
+        uint32_t ackCount, ackLatencyMax, resendCount;
+        uint64_t ackLatencySum;
+        IPAddress brokerIP;
+        bool brokerResolved, sessionUp;
+        char clientId[16];
+        uint32_t connectCount, disconnectCount;
+        uint8_t connectFails;
+        SemaphoreHandle_t clientLock;
+        int8_t busId;
+        TaskHandle_t publishTaskHandle, connTaskHandle;
 };
 
 extern MQTT Publisher;
@@ -23,22 +23,35 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
-#include "bsec.h"
+#include "deadband.h"
 
 #define PARAMETER_SIZE 32
+#define PREFS_LAYOUT 1  // saved with settings, increment on any change of appPrefs_t
 
 extern Preferences nvs;
 
 typedef struct {
-    uint8_t bsecState[BSEC_MAX_STATE_BLOB_SIZE+1];
     uint16_t readingsIntervalSecs;
     char mqttBroker[PARAMETER_SIZE+1];
     uint16_t mqttBrokerPort;
     char mqttTopic[PARAMETER_SIZE+1];
     uint16_t mqttIntervalSecs;
+    char deadband[DEADBAND_CONFIG_SIZE+1];
     bool mqttEnableAuth;
     char mqttUsername[PARAMETER_SIZE+1];
     char mqttPassword[PARAMETER_SIZE+1];
+    uint8_t mqttBatchSize;
+    uint16_t mqttBatchSecs;
+    bool mqttBatchColumnar;
+    uint8_t mqttQos;
+    uint8_t mqttInflightWindow;
+    bool mqttDeltaPayload;
+    uint16_t mqttKeyframeSecs;
+    bool mqttFieldTopics;
+    bool mqttDiscovery;
+    bool mqttSparkplug;
+    char sparkplugGroup[PARAMETER_SIZE+1];
+    uint8_t mqttSenml;
     char ntpServer[PARAMETER_SIZE+1];
     bool bleServer;
     bool lorawanEnable;
@@ -46,6 +59,8 @@ typedef struct {
     char lorawanAppKey[33];
     uint16_t lorawanIntervalSecs;
     bool lorawanConfirm;
+    bool lorawanPacked;
+    bool lorawanBatch;
     bool clearNVSUpdate;
     uint8_t sha256[32];
 } appPrefs_t;
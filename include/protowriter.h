@@ -0,0 +1,59 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _PROTOWRITER_H
+#define _PROTOWRITER_H
+
+#include <Arduino.h>
+
+#define PROTO_MAX_DEPTH 4
+
+// protobuf wire types
+#define PROTO_VARINT 0
+#define PROTO_FIXED64 1
+#define PROTO_LENGTH 2
+#define PROTO_FIXED32 5
+
+// writes protobuf messages directly to a caller supplied buffer without heap
+// allocations, embedded messages are length-prefixed when they are closed,
+// the output is truncated and flagged as overflowed if the buffer is too small
+class ProtoWriter {
+    public:
+        ProtoWriter(uint8_t *buf, size_t size);
+        void reset();
+        void beginMessage(uint8_t field);
+        void endMessage();
+        void addVarint(uint8_t field, uint64_t value);
+        void addFloat(uint8_t field, float value);
+        void addString(uint8_t field, const char *value);
+        size_t length();
+        bool overflowed();
+    private:
+        void putTag(uint8_t field, uint8_t wireType);
+        void putVarint(uint64_t value);
+        void put(uint8_t b);
+        uint8_t *buf;
+        size_t size, len;
+        size_t start[PROTO_MAX_DEPTH];  // offset of embedded message's payload
+        uint8_t depth;
+        bool overflow;
+};
+
+#endif
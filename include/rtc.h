@@ -36,6 +36,7 @@ class SystemTime {
         SystemTime();
         void begin();
         uint32_t getRuntimeMinutes();
+        uint64_t getEpochMillis();
         char* getTimeString();
         char* getDateString();
         bool isTimeSet();
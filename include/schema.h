@@ -0,0 +1,62 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _SCHEMA_H
+#define _SCHEMA_H
+
+#include <Arduino.h>
+#include "sensors.h"
+
+#define SCHEMA_MAX_FIELDS 16
+
+enum fieldType {
+    FIELD_FLOAT = 0,
+    FIELD_UINT8,
+    FIELD_UINT16,
+    FIELD_UINT32,
+    FIELD_UINT64
+};
+
+// field is omitted from a sample if...
+enum fieldCondition {
+    ALWAYS = 0,
+    NONZERO,    // ...its value is zero (e.g. timestamp before NTP sync)
+    IAQ_VALID   // ...BSEC hasn't calibrated the IAQ yet (accuracy < 1)
+};
+
+// describes one field of sensorReadings_t for all encoders
+typedef struct {
+    const char *key;
+    fieldType type;
+    uint16_t offset;
+    uint8_t decimals;  // fixed-point precision, floats are truncated
+    uint8_t sensor;  // SENSOR_* flag of required sensor, 0 if none
+    fieldCondition condition;
+} sensorField_t;
+
+extern const sensorField_t SensorSchema[];
+extern const uint8_t SensorSchemaFields;
+
+bool fieldEnabled(const sensorField_t *field, uint8_t sensors);
+bool fieldAvailable(const sensorField_t *field, uint8_t sensors, const sensorReadings_t &data);
+int64_t fieldValue(const sensorField_t *field, const sensorReadings_t &data);
+int32_t fieldScale(const sensorField_t *field);
+
+#endif
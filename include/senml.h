@@ -0,0 +1,56 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _SENML_H
+#define _SENML_H
+
+#include <Arduino.h>
+#include "jsonwriter.h"
+#include "cborwriter.h"
+
+#define SENML_OFF 0
+#define SENML_JSON 1
+#define SENML_CBOR 2
+
+#define SENML_NAME_SIZE 48
+
+// writes a SenML pack (RFC 8428) as JSON or CBOR, base time is added
+// to the first record, times are relative to base time, records of the
+// same field have to be added in a row, the first one carries the full
+// name and unit as base name and base unit, the following ones only
+// value and time, fields without unit have to be added first, since
+// a base unit applies to all following records
+class SenmlWriter {
+    public:
+        SenmlWriter(uint8_t *buf, size_t size, bool cbor);
+        void begin(const char *baseName, uint64_t baseTime);
+        void addRecord(const char *name, int64_t value, uint8_t decimals, int64_t time);
+        size_t end();
+        static const char* unit(const char *name);
+    private:
+        JsonWriter json;
+        CborWriter cbor;
+        bool useCbor;
+        const char *baseName, *field;
+        char name[SENML_NAME_SIZE];
+        uint64_t baseTime;
+};
+
+#endif
@@ -22,6 +22,12 @@
 #define _SENSORS_H
 
 #include <Arduino.h>
+#include <atomic>
+
+// flags for sensors found at startup
+#define SENSOR_MLX90614 0x01
+#define SENSOR_SFA30 0x02
+#define SENSOR_BME680 0x04
 
 typedef struct {
     float mlxObjectTemp;
@@ -36,18 +42,39 @@ typedef struct {
     uint16_t bme680GasResistance; // kOhm
     uint16_t bme680eCO2; // 400–2000 ppm
     float bme680VOC; // 0.13–2.5 ppm
+    uint64_t timestamp; // UTC milliseconds, 0 if system time not set
+    uint32_t sequence; // incremented with each set of readings, restarts at 0 on boot
 } sensorReadings_t;
 
 class Sensors {
     public:
         static void init();
+        static uint8_t available();
+        static void requestReading();
+        static bool readingRequested();
         virtual bool setup() = 0;
         virtual bool read() = 0;
         virtual uint8_t status() = 0;
-        virtual bool changed() = 0;
-        virtual void display() = 0;
-        virtual void console() = 0;
+        virtual void display(const sensorReadings_t &data) = 0;
+        virtual void console(const sensorReadings_t &data) = 0;
+};
+
+// double-buffered snapshot of the last complete set of sensor readings
+// written by loop() and read lock-free (seqlock) by all consumers
+class SensorSnapshot {
+    public:
+        SensorSnapshot();
+        void publish(const sensorReadings_t *data);
+        uint32_t read(sensorReadings_t *data);
+        uint32_t version();
+        time_t age();
+    private:
+        sensorReadings_t buffer[2];
+        time_t published[2];
+        std::atomic<uint32_t> sequence;
 };
 
+// working copy of the sensor readings, only accessed from loop()
 extern sensorReadings_t readings;
+extern SensorSnapshot Snapshot;
 #endif
\ No newline at end of file
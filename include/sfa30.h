@@ -32,9 +32,8 @@ class SFA30 : public Sensors {
         bool setup();
         bool read();
         uint8_t status();
-        bool changed();
-        void display();
-        void console();
+        void display(const sensorReadings_t &data);
+        void console(const sensorReadings_t &data);
     private:
         SensirionI2CSfa3x sfa;
         char errormsg[256];
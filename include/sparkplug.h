@@ -0,0 +1,50 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _SPARKPLUG_H
+#define _SPARKPLUG_H
+
+#include <Arduino.h>
+#include "protowriter.h"
+#include "sensors.h"
+#include "schema.h"
+
+#define SPARKPLUG_NAMESPACE "spBv1.0"
+#define SPARKPLUG_TOPIC_SIZE 80
+#define SPARKPLUG_BIRTH_SIZE 512
+#define SPARKPLUG_DEATH_SIZE 32
+
+// Sparkplug B payload message with metrics taken from SensorSchema, a metric's
+// alias is its field index, names and data types are only sent with NBIRTH
+class SparkplugPayload {
+    public:
+        SparkplugPayload(uint8_t *buf, size_t size, uint64_t timestamp);
+        void addBdSeq(uint8_t bdSeq);
+        void addField(uint8_t index, const sensorReadings_t &data, bool available, bool birth,
+            uint64_t timestamp = 0);
+        size_t finish(int16_t seq);
+    private:
+        ProtoWriter proto;
+};
+
+bool sparkplugMetric(uint8_t index);
+void sparkplugTopic(char *buf, size_t size, const char *group, const char *type, const char *node);
+
+#endif
@@ -41,14 +41,16 @@ extern bool blockScreen;
 extern bool lowBattery;
 
 time_t tsDiff(time_t tsMillis);
-String getSystemID();
+const char* getSystemID();
 void startWatchdog();
 void stopWatchdog();
 void array2string(const byte *arr, int len, char *buf);
+uint32_t calcCRC32(const void *data, size_t len, uint32_t crc = 0);
 void displayPowerStatus(bool fullScreen);
 bool usbPowered();
 void confirmRestart(Event &e);
 void lowBatteryCheck();
+UBaseType_t checkStackWatermark(const char *taskName, UBaseType_t minFree, UBaseType_t *lowest);
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
 void printFreeHeap();
 UBaseType_t printFreeStackWatermark(const char *taskName);
@@ -0,0 +1,143 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// AT command round trips through ATParser and the startup of ASR6501 (setup,
+// join and first uplink) against the simulated adapter in asr6501sim.h, the
+// join hangs once like the M5 unit does in the field and is retried after
+// LORAWAN_JOIN_RETRY_SECS, simulated time runs ASR6501_BENCH_TIME_SCALE faster
+
+#include <map>
+#include "config.h"
+#include "bench.h"
+#include "hal.h"
+#include "asr6501sim.h"
+#include "atparser.h"
+#include "lorawan.h"
+#include "prefs.h"
+
+#define ASR6501_BENCH_COMMANDS 2000
+#define ASR6501_BENCH_TIME_SCALE 100
+#define ASR6501_BENCH_TIMEOUT_SECS 900
+
+// keeps NVS in memory instead of .nvs/
+class MemoryStorage : public hal::Storage {
+    public:
+        bool load(const char *ns, const char *key, std::vector<uint8_t> &value) {
+            auto entry = this->entries.find(std::string(ns) + "/" + key);
+            if (entry == this->entries.end())
+                return false;
+            value = entry->second;
+            return true;
+        }
+        bool store(const char *ns, const char *key, const uint8_t *value, size_t len) {
+            this->entries[std::string(ns) + "/" + key].assign(value, value + len);
+            return true;
+        }
+        bool remove(const char *ns, const char *key) {
+            return this->entries.erase(std::string(ns) + "/" + key) > 0;
+        }
+        bool clear(const char *ns) {
+            this->entries.clear();
+            return true;
+        }
+    private:
+        std::map<std::string, std::vector<uint8_t>> entries;
+};
+
+
+static void roundTrips(hal::ASR6501Simulator *adapter, ATParser *at, uint32_t latency, uint32_t count) {
+    hal::ASR6501Config config;
+    char resp[64];
+    uint32_t errors = 0;
+    double secs;
+
+    config.latencyMs = latency;
+    adapter->configure(config);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        if (at->command("AT+CSTATUS?", resp, sizeof(resp), 1000) != AT_OK)
+            errors++;
+    }
+    secs = secondsSince(start);
+
+    printf("AT+CSTATUS?  %3u ms latency %8.0f cmd/s %8.3f ms/cmd  %u errors\n",
+        latency, count / secs, secs * 1000 / count, errors);
+}
+
+
+// simulated secs until condition is true or ASR6501_BENCH_TIMEOUT_SECS have passed
+static double waitFor(bool (*condition)(hal::ASR6501Simulator*), hal::ASR6501Simulator *adapter,
+        unsigned long start) {
+    while (!condition(adapter) && (millis() - start) < ASR6501_BENCH_TIMEOUT_SECS * 1000)
+        delay(100);
+    return condition(adapter) ? (millis() - start) / 1000.0 : -1;
+}
+
+
+static void startup(hal::ASR6501Simulator *adapter) {
+    static MemoryStorage storage;
+    hal::ASR6501Config config;
+    hal::ASR6501Stats before, stats;
+    sensorReadings_t data;
+    unsigned long start;
+    double joined, sent;
+
+    config.joinHangs = 1;
+    adapter->configure(config);
+    hal::setStorage(&storage);
+    nvs.begin("prefs", false);
+    prefs.lorawanEnable = true;
+    strlcpy(prefs.lorawanAppEUI, "0000000000000000", sizeof(prefs.lorawanAppEUI));
+    strlcpy(prefs.lorawanAppKey, "CEB39FE91A24CB1C0717E2859D2459AA", sizeof(prefs.lorawanAppKey));
+    hal::setTimeScale(ASR6501_BENCH_TIME_SCALE);
+
+    before = adapter->stats();
+    start = millis();
+    LoRaWAN.begin(&Serial2, LORAWAN_RX_PIN, LORAWAN_TX_PIN);
+    joined = waitFor([](hal::ASR6501Simulator*) { return LoRaWAN.status() == JOINED; }, adapter, start);
+    memset(&data, 0, sizeof(data));
+    data.sequence = 1;
+    Bus.publish(&data);
+    sent = waitFor([](hal::ASR6501Simulator *a) { return a->stats().uplinks > 0; }, adapter, start);
+    stats = adapter->stats();
+    hal::setTimeScale(1);
+
+    printf("startup      joined after %.1f secs, first uplink after %.1f secs (simulated)\n", joined, sent);
+    printf("             %u commands, %u errors, %u joins, %u adapter reboots\n",
+        stats.commands - before.commands, stats.errors - before.errors,
+        stats.joins - before.joins, stats.reboots - before.reboots);
+}
+
+
+// adapter and tasks are left running, LoRaWAN can only be started once
+void benchASR6501() {
+    hal::ASR6501Simulator *adapter = new hal::ASR6501Simulator();
+    ATParser *at = new ATParser();
+
+    hal::setSerial2(adapter);
+    Serial2.begin(115200);
+    at->begin(&Serial2);
+    roundTrips(adapter, at, 0, ASR6501_BENCH_COMMANDS);
+    roundTrips(adapter, at, 5, ASR6501_BENCH_COMMANDS / 10);
+    roundTrips(adapter, at, 20, ASR6501_BENCH_COMMANDS / 40);
+    at->end();
+
+    startup(adapter);
+}
@@ -0,0 +1,115 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// append and read rates of the backlog while it fills up until the oldest
+// segment is dropped, with a window of QoS 1 messages in flight spanning the
+// dropped readings, checks that each message still covers its own readings
+// after MQTT::dropInflight() (errors are counted), runs in .littlefs-bench/
+
+#include <unistd.h>
+#include "bench.h"
+#include "backlog.h"
+#include "mqtt.h"
+
+#define BACKLOG_BENCH_DIR ".littlefs-bench"
+#define BACKLOG_BENCH_ACKED 250  // window starts shortly before end of first segment
+#define BACKLOG_BENCH_MESSAGES 5
+#define BACKLOG_BENCH_RECORDS 4  // per message
+
+
+static bool appendSequence(uint32_t sequence) {
+    sensorReadings_t data = {};
+
+    data.sequence = sequence;
+    data.timestamp = 1792195200000ULL + sequence * 5000ULL;
+    return Backlog.append(&data);
+}
+
+
+// check that message readings end with 'lastSeq' and are contiguous
+static uint32_t checkWindow(const inflightMsg_t *inflight, uint8_t count, const uint32_t *lastSeq) {
+    sensorReadings_t data;
+    uint32_t offset = 0, errors = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint16_t r = 0; r < inflight[i].records; r++) {
+            if (!Backlog.read(offset + r, &data) ||
+                    data.sequence != lastSeq[i] - inflight[i].records + 1 + r)
+                errors++;
+        }
+        offset += inflight[i].records;
+    }
+    return errors;
+}
+
+
+void benchBacklog() {
+    inflightMsg_t inflight[BACKLOG_BENCH_MESSAGES];
+    uint32_t lastSeq[BACKLOG_BENCH_MESSAGES];
+    uint32_t sequence = 0, errors = 0, appended, pending, dropped;
+    uint8_t count = BACKLOG_BENCH_MESSAGES;
+    sensorReadings_t data;
+    double secs;
+
+    setenv("NATIVE_FS_DIR", BACKLOG_BENCH_DIR, 1);
+    LittleFS.begin(true);
+    LittleFS.format();
+    if (!Backlog.begin()) {
+        printf("failed to mount %s\n", BACKLOG_BENCH_DIR);
+        return;
+    }
+
+    while (sequence < BACKLOG_BENCH_ACKED + BACKLOG_BENCH_MESSAGES * BACKLOG_BENCH_RECORDS)
+        errors += appendSequence(sequence++) ? 0 : 1;
+    Backlog.release(BACKLOG_BENCH_ACKED);
+    for (uint8_t i = 0; i < count; i++) {
+        inflight[i] = { (uint16_t)(i + 1), BACKLOG_BENCH_RECORDS, 0, false };
+        lastSeq[i] = BACKLOG_BENCH_ACKED + (i + 1) * BACKLOG_BENCH_RECORDS - 1;
+    }
+    errors += checkWindow(inflight, count, lastSeq);
+
+    appended = sequence;
+    auto start = std::chrono::steady_clock::now();
+    while (Backlog.dropped() == 0)
+        errors += appendSequence(sequence++) ? 0 : 1;
+    secs = secondsSince(start);
+    appended = sequence - appended;
+    printf("append   %6u records %9.0f records/s\n", appended, appended / secs);
+
+    dropped = Backlog.dropped();
+    pending = Backlog.pending();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < pending; i++)
+        errors += Backlog.read(i, &data) ? 0 : 1;
+    secs = secondsSince(start);
+    printf("read     %6u records %9.0f records/s\n", pending, pending / secs);
+
+    // messages whose readings were all dropped leave the window
+    MQTT::dropInflight(inflight, &count, dropped);
+    memmove(lastSeq, &lastSeq[BACKLOG_BENCH_MESSAGES - count], count * sizeof(uint32_t));
+    errors += checkWindow(inflight, count, lastSeq);
+    printf("window   %u readings dropped, %u of %u messages left in flight, %u errors\n",
+        dropped, count, BACKLOG_BENCH_MESSAGES, errors);
+
+    Backlog.release(Backlog.pending());
+    LittleFS.format();
+    rmdir(BACKLOG_BENCH_DIR BACKLOG_DIR);
+    rmdir(BACKLOG_BENCH_DIR);
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <pthread.h>
+#include "bench.h"
+
+#define STACK_PAINT 0xA5
+
+static const benchmark_t benchmarks[] = {
+    { "json", benchJson },
+    { "sparkplug", benchSparkplug },
+    { "senml", benchSenml },
+    { "lorawan", benchLoRaWAN },
+    { "asr6501", benchASR6501 },
+    { "backlog", benchBacklog }
+};
+
+
+typedef struct {
+    void (*fn)(void*);
+    void *arg;
+} benchCall_t;
+
+
+static void* benchThread(void *arg) {
+    benchCall_t *call = (benchCall_t*)arg;
+    call->fn(call->arg);
+    return NULL;
+}
+
+
+size_t stackHighWater(void (*fn)(void*), void *arg) {
+    static uint8_t stack[BENCH_STACK_SIZE] __attribute__((aligned(16)));
+    benchCall_t call = { fn, arg };
+    pthread_attr_t attr;
+    pthread_t thread;
+    size_t untouched = 0;
+
+    memset(stack, STACK_PAINT, sizeof(stack));
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, sizeof(stack));
+    if (pthread_create(&thread, &attr, benchThread, &call) != 0) {
+        pthread_attr_destroy(&attr);
+        return 0;
+    }
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    // stack grows downwards, count untouched bytes from lowest address
+    while (untouched < sizeof(stack) && stack[untouched] == STACK_PAINT)
+        untouched++;
+    return sizeof(stack) - untouched;
+}
+
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+// run all benchmarks or only those given on the command line
+int main(int argc, char **argv) {
+    for (const benchmark_t &bench : benchmarks) {
+        bool selected = (argc < 2);
+        for (int i = 1; i < argc; i++)
+            selected |= !strcmp(argv[i], bench.name);
+        if (!selected)
+            continue;
+        printf("== %s\n", bench.name);
+        bench.run();
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// host benchmarks (pio run -e native-bench -t exec), the firmware
+// sources are linked as in the native env, setup() is never called
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <Arduino.h>
+#include <chrono>
+
+#define BENCH_STACK_SIZE (64 * 1024)
+
+typedef struct {
+    const char *name;
+    void (*run)();
+} benchmark_t;
+
+// runs fn(arg) once on a thread with a painted stack,
+// returns number of stack bytes that have been touched
+size_t stackHighWater(void (*fn)(void*), void *arg);
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+
+void benchJson();
+void benchSparkplug();
+void benchSenml();
+void benchLoRaWAN();
+void benchASR6501();
+void benchBacklog();
+
+#endif
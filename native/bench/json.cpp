@@ -0,0 +1,129 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// compares the schema-driven JsonWriter used by MQTT::encode() with
+// the previous ArduinoJson based serialization of a single sample
+
+#include <ArduinoJson.h>
+#include "bench.h"
+#include "mqtt.h"
+#include "wlan.h"
+#include "rtc.h"
+#include "utils.h"
+
+#define JSON_BENCH_ITERATIONS 200000
+#define JSON_BENCH_SENSORS (SENSOR_MLX90614 | SENSOR_SFA30 | SENSOR_BME680)
+
+static const sensorReadings_t sample = {
+    24.13, 22.51,   // MLX90614
+    12.4, 22.6, 45,  // SFA30
+    22.8, 44, 87, 3, 120, 612, 0.83,  // BME680
+    1792195200123ULL, 4711
+};
+
+typedef struct {
+    size_t (*encode)(char *buf, size_t size);
+    size_t len;
+} jsonCall_t;
+
+
+// MQTT::publish() serialization before JsonWriter was introduced
+static size_t encodeArduinoJson(char *buf, size_t size) {
+    StaticJsonDocument<448> JSON;
+    const sensorReadings_t &data = sample;
+
+    JSON["systemId"] = String(getSystemID());
+    if (data.timestamp > 0)
+        JSON["ts"] = data.timestamp; // UTC ms
+    JSON["seq"] = data.sequence;
+    if (JSON_BENCH_SENSORS & SENSOR_MLX90614) {
+        JSON["objectTemp"] = int(data.mlxObjectTemp*10)/10.0;
+        JSON["ambientTemp"] = int(data.mlxAmbientTemp*10)/10.0;
+    }
+    if (JSON_BENCH_SENSORS & SENSOR_SFA30)
+        JSON["hcho"] = int(data.sfa30HCHO*10)/10.0;
+    if (JSON_BENCH_SENSORS & SENSOR_BME680) {
+        JSON["humidity"] = data.bme680Hum;
+        JSON["gasResistance"] = data.bme680GasResistance;
+        JSON["iaqAccuracy"] = data.bme680IaqAccuracy;
+        if (data.bme680IaqAccuracy >= 1) {
+            JSON["iaq"] = data.bme680Iaq;
+            JSON["VOC"] = int(data.bme680VOC*10)/10.0;
+            JSON["eCO2"] = data.bme680eCO2;
+        }
+    }
+    JSON["rssi"] = WiFi.RSSI();
+    JSON["wifiCons"] = WifiUplink.wifiReconnectSuccess + WifiUplink.wifiReconnectFail;
+    if (M5.Axp.GetBatVoltage() >= 1.0) {
+        JSON["batLevel"] = int(M5.Axp.GetBatteryLevel());
+        JSON["usbPower"] = usbPowered() ? 1 : 0;
+    }
+    JSON["runtime"] = SysTime.getRuntimeMinutes();
+    JSON["version"] = FIRMWARE_VERSION;
+
+    return serializeJson(JSON, buf, size);
+}
+
+
+static size_t encodeJsonWriter(char *buf, size_t size) {
+    return Publisher.encode(&sample, 1, JSON_BENCH_SENSORS, buf, size);
+}
+
+
+static void encodeOnce(void *arg) {
+    jsonCall_t *call = (jsonCall_t*)arg;
+    char buf[400];
+
+    call->len = call->encode(buf, sizeof(buf));
+}
+
+
+static void noop(void *arg) {}
+
+
+static void run(const char *name, size_t (*encode)(char*, size_t), size_t baseline) {
+    jsonCall_t call = { encode, 0 };
+    static char buf[400];
+    size_t stack, bytes = 0;
+    double secs;
+
+    stack = stackHighWater(encodeOnce, &call) - baseline;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < JSON_BENCH_ITERATIONS; i++)
+        bytes += encode(buf, sizeof(buf));
+    secs = secondsSince(start);
+
+    printf("%-12s %4zu bytes/msg %8.1f MB/s %9.0f msg/s  stack %5zu bytes\n", name, call.len,
+        bytes / secs / 1e6, JSON_BENCH_ITERATIONS / secs, stack);
+}
+
+
+void benchJson() {
+    static char buf[400];
+    size_t baseline = stackHighWater(noop, NULL);
+
+    encodeArduinoJson(buf, sizeof(buf));
+    printf("ArduinoJson: %s\n", buf);
+    encodeJsonWriter(buf, sizeof(buf));
+    printf("JsonWriter:  %s\n", buf);
+
+    run("ArduinoJson", encodeArduinoJson, baseline);
+    run("JsonWriter", encodeJsonWriter, baseline);
+}
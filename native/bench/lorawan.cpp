@@ -0,0 +1,99 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// compares payload size and encoding time of the bit-packed LoRaWAN
+// codec with CayenneLPP as encoded by ASR6501::encodeLPP(), the batch
+// adds LORAWAN_BENCH_HISTORY older samples with slowly drifting readings
+
+#include <CayenneLPP.h>
+#include "bench.h"
+#include "lorawan.h"
+#include "rtc.h"
+
+#define LORAWAN_BENCH_ITERATIONS 1000000
+#define LORAWAN_BENCH_SENSORS (SENSOR_MLX90614 | SENSOR_SFA30 | SENSOR_BME680)
+#define LORAWAN_BENCH_HISTORY 10
+
+static const sensorReadings_t sample = {
+    24.13, 22.51,   // MLX90614
+    12.4, 22.6, 45,  // SFA30
+    22.8, 44, 87, 3, 120, 612, 0.83,  // BME680
+    1792195200123ULL, 4711
+};
+
+
+static size_t encodeCayenne(uint8_t *buf, size_t size) {
+    static CayenneLPP lpp(LORAWAN_LPP_SIZE);
+
+    fillLPP(lpp, sample, LORAWAN_BENCH_SENSORS, 0);
+    memcpy(buf, lpp.getBuffer(), min((size_t)lpp.getSize(), size));
+    return lpp.getSize();
+}
+
+
+static size_t encodePacked(uint8_t *buf, size_t size) {
+    return packReadings(sample, LORAWAN_BENCH_SENSORS, buf, size);
+}
+
+
+static size_t encodeBatch(uint8_t *buf, size_t size) {
+    static packedSample_t history[LORAWAN_BENCH_HISTORY];
+    static uint16_t gaps[LORAWAN_BENCH_HISTORY];
+    static bool initialized = false;
+    sensorReadings_t older = sample;
+    uint8_t count = LORAWAN_BENCH_HISTORY;
+
+    if (!initialized) {
+        for (uint8_t i = 0; i < LORAWAN_BENCH_HISTORY; i++) {
+            older.mlxObjectTemp -= 0.3;
+            older.sfa30HCHO += (i & 1) ? 0.4 : -0.2;
+            older.bme680Iaq += 2;
+            older.bme680eCO2 -= 7;
+            packSample(older, LORAWAN_BENCH_SENSORS, &history[i]);
+            gaps[i] = (i % 3) ? 60 : 95;  // deadband filter delays some samples
+        }
+        initialized = true;
+    }
+    return packBatch(sample, LORAWAN_BENCH_SENSORS, history, gaps, &count, buf, size);
+}
+
+
+static void run(const char *name, size_t (*encode)(uint8_t*, size_t)) {
+    static uint8_t buf[LORAWAN_LPP_SIZE];
+    static char hex[LORAWAN_LPP_SIZE*2+1];
+    size_t len, bytes = 0;
+    double secs;
+
+    len = encode(buf, sizeof(buf));
+    array2string(buf, len, hex);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LORAWAN_BENCH_ITERATIONS; i++)
+        bytes += encode(buf, sizeof(buf));
+    secs = secondsSince(start);
+
+    printf("%-12s %3zu bytes/uplink %9.0f msg/s  %s\n", name, len, LORAWAN_BENCH_ITERATIONS / secs, hex);
+}
+
+
+void benchLoRaWAN() {
+    run("CayenneLPP", encodeCayenne);
+    run("Packed", encodePacked);
+    run("Batch", encodeBatch);
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// compares size and encoding time of SenML packs (JSON and CBOR)
+// with the JSON document published by MQTT::encode()
+
+#include "bench.h"
+#include "mqtt.h"
+
+#define SENML_BENCH_ITERATIONS 200000
+#define SENML_BENCH_BATCH MQTT_SENML_BATCH_MAX
+#define SENML_BENCH_SENSORS (SENSOR_MLX90614 | SENSOR_SFA30 | SENSOR_BME680)
+
+static sensorReadings_t samples[SENML_BENCH_BATCH];
+
+typedef struct {
+    size_t (*encode)(uint8_t count, uint8_t *buf, size_t size);
+    uint8_t count;
+    size_t len;
+} encodeCall_t;
+
+
+static size_t encodeJson(uint8_t count, uint8_t *buf, size_t size) {
+    return Publisher.encode(samples, count, SENML_BENCH_SENSORS, (char*)buf, size);
+}
+
+
+static size_t encodeSenmlJson(uint8_t count, uint8_t *buf, size_t size) {
+    return Publisher.encodeSenml(samples, count, SENML_BENCH_SENSORS, buf, size, false);
+}
+
+
+static size_t encodeSenmlCbor(uint8_t count, uint8_t *buf, size_t size) {
+    return Publisher.encodeSenml(samples, count, SENML_BENCH_SENSORS, buf, size, true);
+}
+
+
+static void encodeOnce(void *arg) {
+    encodeCall_t *call = (encodeCall_t*)arg;
+    uint8_t buf[MQTT_PAYLOAD_SIZE];
+
+    call->len = call->encode(call->count, buf, sizeof(buf));
+}
+
+
+static void noop(void *arg) {}
+
+
+static void run(const char *name, size_t (*encode)(uint8_t, uint8_t*, size_t), uint8_t count,
+        size_t baseline) {
+    encodeCall_t call = { encode, count, 0 };
+    static uint8_t buf[MQTT_PAYLOAD_SIZE];
+    size_t stack, bytes = 0;
+    double secs;
+
+    stack = stackHighWater(encodeOnce, &call) - baseline;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < SENML_BENCH_ITERATIONS / count; i++)
+        bytes += encode(count, buf, sizeof(buf));
+    secs = secondsSince(start);
+
+    printf("%-12s %2u x %4zu bytes/msg %5zu bytes/sample %9.0f samples/s  stack %5zu bytes\n", name, count,
+        call.len, call.len / count, SENML_BENCH_ITERATIONS / secs, stack);
+}
+
+
+void benchSenml() {
+    static uint8_t buf[MQTT_PAYLOAD_SIZE];
+    size_t baseline = stackHighWater(noop, NULL);
+
+    for (uint8_t i = 0; i < SENML_BENCH_BATCH; i++) {
+        samples[i] = {
+            24.13f + i * 0.1f, 22.51,   // MLX90614
+            12.4, 22.6, 45,  // SFA30
+            22.8, 44, 87, 3, 120, 612, 0.83,  // BME680
+            1792195200123ULL + i * 5007, uint32_t(4711 + i)
+        };
+    }
+
+    buf[encodeSenmlJson(2, buf, sizeof(buf)-1)] = '\0';
+    printf("SenML JSON: %s\n", buf);
+
+    run("JSON", encodeJson, 1, baseline);
+    run("SenML JSON", encodeSenmlJson, 1, baseline);
+    run("SenML CBOR", encodeSenmlCbor, 1, baseline);
+    run("JSON", encodeJson, SENML_BENCH_BATCH, baseline);
+    run("SenML JSON", encodeSenmlJson, SENML_BENCH_BATCH, baseline);
+    run("SenML CBOR", encodeSenmlCbor, SENML_BENCH_BATCH, baseline);
+}
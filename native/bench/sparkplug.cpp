@@ -0,0 +1,109 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// compares size and encoding time of Sparkplug B NDATA payloads
+// (metrics by alias) with the JSON published by MQTT::encode()
+
+#include "bench.h"
+#include "mqtt.h"
+
+#define SPARKPLUG_BENCH_ITERATIONS 200000
+#define SPARKPLUG_BENCH_BATCH 10
+#define SPARKPLUG_BENCH_SENSORS (SENSOR_MLX90614 | SENSOR_SFA30 | SENSOR_BME680)
+
+static sensorReadings_t samples[SPARKPLUG_BENCH_BATCH];
+
+typedef struct {
+    size_t (*encode)(uint8_t count, uint8_t *buf, size_t size);
+    uint8_t count;
+    size_t len;
+} encodeCall_t;
+
+
+static size_t encodeJson(uint8_t count, uint8_t *buf, size_t size) {
+    return Publisher.encode(samples, count, SPARKPLUG_BENCH_SENSORS, (char*)buf, size);
+}
+
+
+static size_t encodeNData(uint8_t count, uint8_t *buf, size_t size) {
+    return Publisher.encodeSparkplug(samples, count, SPARKPLUG_BENCH_SENSORS, buf, size);
+}
+
+
+// metric names and data types as declared once per session
+static size_t encodeNBirth(uint8_t count, uint8_t *buf, size_t size) {
+    SparkplugPayload payload(buf, size, samples[0].timestamp);
+
+    payload.addBdSeq(1);
+    for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+        if (sparkplugMetric(i))
+            payload.addField(i, samples[0], true, true);
+    }
+    return payload.finish(0);
+}
+
+
+static void encodeOnce(void *arg) {
+    encodeCall_t *call = (encodeCall_t*)arg;
+    uint8_t buf[MQTT_PAYLOAD_SIZE];
+
+    call->len = call->encode(call->count, buf, sizeof(buf));
+}
+
+
+static void noop(void *arg) {}
+
+
+static void run(const char *name, size_t (*encode)(uint8_t, uint8_t*, size_t), uint8_t count,
+        size_t baseline) {
+    encodeCall_t call = { encode, count, 0 };
+    static uint8_t buf[MQTT_PAYLOAD_SIZE];
+    size_t stack, bytes = 0;
+    double secs;
+
+    stack = stackHighWater(encodeOnce, &call) - baseline;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < SPARKPLUG_BENCH_ITERATIONS / count; i++)
+        bytes += encode(count, buf, sizeof(buf));
+    secs = secondsSince(start);
+
+    printf("%-12s %2u x %4zu bytes/msg %8.1f MB/s %9.0f samples/s  stack %5zu bytes\n", name, count,
+        call.len, bytes / secs / 1e6, SPARKPLUG_BENCH_ITERATIONS / secs, stack);
+}
+
+
+void benchSparkplug() {
+    size_t baseline = stackHighWater(noop, NULL);
+
+    for (uint8_t i = 0; i < SPARKPLUG_BENCH_BATCH; i++) {
+        samples[i] = {
+            24.13f + i * 0.1f, 22.51,   // MLX90614
+            12.4, 22.6, 45,  // SFA30
+            22.8, 44, 87, 3, 120, 612, 0.83,  // BME680
+            1792195200123ULL + i * 5000, uint32_t(4711 + i)
+        };
+    }
+
+    run("NBIRTH", encodeNBirth, 1, baseline);
+    run("JSON", encodeJson, 1, baseline);
+    run("NDATA", encodeNData, 1, baseline);
+    run("JSON", encodeJson, SPARKPLUG_BENCH_BATCH, baseline);
+    run("NDATA", encodeNData, SPARKPLUG_BENCH_BATCH, baseline);
+}
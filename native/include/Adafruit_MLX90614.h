@@ -0,0 +1,38 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_ADAFRUIT_MLX90614_H
+#define _NATIVE_ADAFRUIT_MLX90614_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define MLX90614_I2CADDR 0x5A
+
+// IR thermometer, readings are taken from hal::sensors()
+class Adafruit_MLX90614 {
+    public:
+        bool begin(uint8_t addr = MLX90614_I2CADDR, TwoWire *wire = &Wire);
+        double readObjectTempC();
+        double readAmbientTempC();
+        double readEmissivity() { return 1.0; }
+};
+
+#endif
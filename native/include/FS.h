@@ -0,0 +1,95 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// Arduino FS/File subset for the host-native build, files are
+// kept below a directory on the host (see LittleFS.h)
+
+#ifndef _NATIVE_FS_H
+#define _NATIVE_FS_H
+
+#include <memory>
+#include <string>
+#include <Arduino.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FileImpl;
+
+class File : public Stream {
+    public:
+        File() {}
+        File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t len);
+        using Print::write;
+        int available();
+        int read();
+        size_t read(uint8_t *buf, size_t len);
+        int peek();
+        void flush();
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
+        size_t position() const;
+        size_t size() const;
+        void close();
+        operator bool() const;
+        const char* path() const;
+        const char* name() const;
+        bool isDirectory() const;
+        File openNextFile(const char *mode = FILE_READ);
+    private:
+        std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+    public:
+        File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+        File open(const String &path, const char *mode = FILE_READ, const bool create = false) {
+            return open(path.c_str(), mode, create);
+        }
+        bool exists(const char *path);
+        bool remove(const char *path);
+        bool rename(const char *pathFrom, const char *pathTo);
+        bool mkdir(const char *path);
+        bool rmdir(const char *path);
+    protected:
+        std::string hostPath(const char *path);
+        std::string root;
+};
+
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
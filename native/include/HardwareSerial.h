@@ -0,0 +1,55 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_HARDWARESERIAL_H
+#define _NATIVE_HARDWARESERIAL_H
+
+#include <functional>
+#include "Stream.h"
+
+#define SERIAL_8N1 0x800001c
+
+typedef std::function<void(void)> OnReceiveCb;
+
+// UART0 (Serial) prints to stdout, UART2 (Serial2) is
+// connected to the device set with hal::setSerial2()
+class HardwareSerial : public Stream {
+    public:
+        HardwareSerial(int uartNum) : uart(uartNum) {}
+        void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+        void end();
+        int available();
+        int read();
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t len);
+        using Print::write;
+        // called after writes the device has answered right away and whenever
+        // a device with asynchronous answers (see hal::SerialDevice) has sent data
+        void onReceive(OnReceiveCb function, bool onlyOnTimeout = false);
+        operator bool() const { return true; }
+    private:
+        int uart;
+        OnReceiveCb onReceiveCb;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+#endif
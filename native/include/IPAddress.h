@@ -0,0 +1,58 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_IPADDRESS_H
+#define _NATIVE_IPADDRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "WString.h"
+
+class IPAddress {
+    public:
+        IPAddress() { addr.dword = 0; }
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+            addr.bytes[0] = a; addr.bytes[1] = b; addr.bytes[2] = c; addr.bytes[3] = d;
+        }
+        IPAddress(uint32_t address) { addr.dword = address; }
+        operator uint32_t() const { return addr.dword; }
+        uint8_t operator[](int i) const { return addr.bytes[i]; }
+        uint8_t& operator[](int i) { return addr.bytes[i]; }
+        bool operator==(const IPAddress &rhs) const { return addr.dword == rhs.addr.dword; }
+        bool fromString(const char *str) {
+            unsigned int a, b, c, d;
+            if (sscanf(str, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+                return false;
+            *this = IPAddress(a, b, c, d);
+            return true;
+        }
+        String toString() const {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%u.%u.%u.%u", addr.bytes[0], addr.bytes[1], addr.bytes[2], addr.bytes[3]);
+            return String(buf);
+        }
+    private:
+        union {
+            uint8_t bytes[4];
+            uint32_t dword;
+        } addr;
+};
+
+#endif
@@ -0,0 +1,47 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// LittleFS for the host-native build, the partition is mapped to
+// the directory NATIVE_FS_DIR (default .littlefs), contents persist
+// across restarts like the flash partition on the device
+
+#ifndef _NATIVE_LITTLEFS_H
+#define _NATIVE_LITTLEFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+    public:
+        LittleFSFS();
+        bool begin(bool formatOnFail = false, const char *basePath = "/littlefs",
+            uint8_t maxOpenFiles = 10, const char *partitionLabel = "spiffs");
+        bool format();
+        size_t totalBytes();
+        size_t usedBytes();
+        void end();
+};
+
+}
+
+extern fs::LittleFSFS LittleFS;
+
+#endif
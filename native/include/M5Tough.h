@@ -0,0 +1,184 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// M5Tough library subset for the host-native build, LCD output is passed
+// to hal::display(), power management and RTC are backed by hal::power()
+// and the host's system clock
+
+#ifndef _NATIVE_M5TOUGH_H
+#define _NATIVE_M5TOUGH_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define BLACK 0x0000
+#define NAVY 0x000F
+#define DARKGREEN 0x03E0
+#define DARKCYAN 0x03EF
+#define BLUE 0x001F
+#define GREEN 0x07E0
+#define RED 0xF800
+#define ORANGE 0xFD20
+#define YELLOW 0xFFE0
+#define WHITE 0xFFFF
+
+#define TL_DATUM 0
+#define MC_DATUM 4
+
+typedef struct {
+    uint8_t *bitmap;
+    void *glyph;
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+} GFXfont;
+
+typedef struct {
+    uint16_t bitmapOffset;
+    uint8_t width;
+    uint8_t height;
+    uint8_t xAdvance;
+    int8_t xOffset;
+    int8_t yOffset;
+} GFXglyph;
+
+extern const GFXfont FreeSans9pt7b;
+extern const GFXfont FreeSans12pt7b;
+extern const GFXfont FreeSansBold12pt7b;
+extern const GFXfont FreeSansBold24pt7b;
+
+typedef enum {
+    kMBusModeOutput = 0,
+    kMBusModeInput = 1
+} mbus_mode_t;
+
+class M5Display : public Print {
+    public:
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t len);
+        using Print::write;
+        void clearDisplay(uint16_t color = BLACK);
+        void clear(uint16_t color = BLACK) { clearDisplay(color); }
+        void fillScreen(uint16_t color) { clearDisplay(color); }
+        void setCursor(int16_t x, int16_t y) { this->x = x; this->y = y; }
+        int16_t getCursorX() { return this->x; }
+        int16_t getCursorY() { return this->y; }
+        void setTextColor(uint16_t color) {}
+        void setTextColor(uint16_t color, uint16_t background) {}
+        void setTextDatum(uint8_t datum) {}
+        void setFreeFont(const GFXfont *font) {}
+        void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {}
+        void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {}
+        void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {}
+        int16_t drawString(const char *str, int32_t x, int32_t y, uint8_t font);
+    private:
+        void flushLine();
+        int16_t x = 0, y = 0;
+        char line[64] = { 0 };
+        uint8_t len = 0;
+};
+
+class AXP192 {
+    public:
+        float GetBatVoltage();
+        float GetBatteryLevel();
+        float GetVinVoltage();
+        bool isCharging();
+        void DeepSleep(uint64_t us);
+};
+
+typedef struct {
+    uint8_t Hours;
+    uint8_t Minutes;
+    uint8_t Seconds;
+} RTC_TimeTypeDef;
+
+typedef struct {
+    uint8_t WeekDay;
+    uint8_t Month;
+    uint8_t Date;
+    uint16_t Year;
+} RTC_DateTypeDef;
+
+class RTC {
+    public:
+        void GetTime(RTC_TimeTypeDef *time);
+        void GetDate(RTC_DateTypeDef *date);
+        void SetTime(RTC_TimeTypeDef *time);
+        void SetDate(RTC_DateTypeDef *date);
+};
+
+// touch buttons and gestures, never triggered in the host-native build
+#define E_TOUCH 0x0001
+#define E_RELEASE 0x0002
+#define E_GESTURE 0x0200
+#define DIR_UP 1
+#define DIR_RIGHT 3
+#define DIR_DOWN 5
+#define DIR_LEFT 7
+
+class Event {
+    public:
+        const char* objName() { return this->name; }
+        const char *name = "";
+};
+
+typedef void (*EventHandler)(Event&);
+
+typedef struct {
+    uint16_t bg;
+    uint16_t text;
+    uint16_t outline;
+} ButtonColors;
+
+class Button {
+    public:
+        Button(int16_t x, int16_t y, int16_t w, int16_t h, bool rot1 = false, const char *name = "",
+            ButtonColors off = { 0, 0, 0 }, ButtonColors on = { 0, 0, 0 }, uint8_t datum = MC_DATUM) {}
+        void addHandler(EventHandler fn, uint16_t eventMask = 0) {}
+};
+
+class Gesture {
+    public:
+        Gesture(const char *name, int16_t minDistance, int16_t direction, uint16_t maxTime,
+            bool rot1 = false) {}
+        void addHandler(EventHandler fn, uint16_t eventMask = E_GESTURE) {}
+};
+
+class M5Buttons {
+    public:
+        void draw() {}
+};
+
+class M5Tough {
+    public:
+        void begin(bool lcdEnable = true, bool sdEnable = true, bool serialEnable = true,
+            bool i2cEnable = false, mbus_mode_t mode = kMBusModeOutput);
+        void update() {}
+        M5Display Lcd;
+        M5Display &lcd = Lcd;
+        AXP192 Axp;
+        RTC Rtc;
+        M5Buttons Buttons;
+};
+
+extern M5Tough M5;
+
+#endif
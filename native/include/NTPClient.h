@@ -0,0 +1,43 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_NTPCLIENT_H
+#define _NATIVE_NTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+// network time is the host's system time
+class NTPClient {
+    public:
+        NTPClient(UDP &udp) {}
+        void setPoolServerName(const char *server) {}
+        void setUpdateInterval(unsigned long interval) {}
+        void begin() { this->started = true; }
+        void end() { this->started = false; }
+        bool update() { return this->started; }
+        bool forceUpdate() { return this->started; }
+        bool isTimeSet() const { return this->started; }
+        unsigned long getEpochTime() const { return (unsigned long)time(NULL); }
+    private:
+        bool started = false;
+};
+
+#endif
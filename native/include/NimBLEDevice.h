@@ -0,0 +1,49 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_NIMBLEDEVICE_H
+#define _NATIVE_NIMBLEDEVICE_H
+
+#include <Arduino.h>
+
+// declarations needed by ble.h, the GATT server itself is
+// replaced by a stub in the host-native build (see native/src/stubs.cpp)
+class NimBLEServer;
+class NimBLEService;
+class NimBLEAdvertising;
+class NimBLECharacteristic;
+class NimBLEServerCallbacks {};
+
+class BLEUUID {
+    public:
+        BLEUUID(uint16_t uuid) : uuid(uuid) {}
+    private:
+        uint16_t uuid;
+};
+
+namespace NIMBLE_PROPERTY {
+    enum {
+        READ = 0x0002,
+        WRITE = 0x0008,
+        NOTIFY = 0x0010
+    };
+}
+
+#endif
@@ -0,0 +1,59 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_PREFERENCES_H
+#define _NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS namespace backed by hal::storage()
+class Preferences {
+    public:
+        bool begin(const char *name, bool readOnly = false, const char *partition = NULL);
+        void end();
+        bool clear();
+        bool remove(const char *key);
+        bool isKey(const char *key);
+        size_t putBool(const char *key, bool value) { return putBytes(key, &value, sizeof(value)); }
+        size_t putUChar(const char *key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+        size_t putUShort(const char *key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+        size_t putUInt(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+        size_t putULong64(const char *key, uint64_t value) { return putBytes(key, &value, sizeof(value)); }
+        size_t putString(const char *key, const char *value) { return putBytes(key, value, strlen(value) + 1); }
+        size_t putBytes(const char *key, const void *value, size_t len);
+        bool getBool(const char *key, bool defaultValue = false) { return get(key, defaultValue); }
+        uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return get(key, defaultValue); }
+        uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return get(key, defaultValue); }
+        uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+        uint64_t getULong64(const char *key, uint64_t defaultValue = 0) { return get(key, defaultValue); }
+        size_t getString(const char *key, char *value, size_t maxLen);
+        size_t getBytesLength(const char *key);
+        size_t getBytes(const char *key, void *buf, size_t maxLen);
+    private:
+        template<typename T> T get(const char *key, T defaultValue) {
+            T value;
+            return (getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T))) ? value : defaultValue;
+        }
+        char name[16] = { 0 };
+        bool readOnly = false;
+        bool started = false;
+};
+
+#endif
@@ -0,0 +1,59 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_PRINT_H
+#define _NATIVE_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buf, size_t len);
+        size_t write(const char *str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+        size_t write(const char *buf, size_t len) { return write((const uint8_t*)buf, len); }
+        size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+        size_t print(const char *str) { return write(str); }
+        size_t print(const String &str) { return write(str.c_str()); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+        size_t print(int n, int base = DEC) { return print((long)n, base); }
+        size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+        size_t print(long n, int base = DEC);
+        size_t print(unsigned long n, int base = DEC);
+        size_t print(long long n, int base = DEC) { return print((long)n, base); }
+        size_t print(unsigned long long n, int base = DEC) { return print((unsigned long)n, base); }
+        size_t print(double n, int digits = 2);
+        size_t println() { return write("\r\n"); }
+        template<typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+        template<typename T> size_t println(T value, int arg) { size_t n = print(value, arg); return n + println(); }
+        virtual void flush() {}
+};
+
+#endif
@@ -0,0 +1,38 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_SENSIRIONI2CSFA3X_H
+#define _NATIVE_SENSIRIONI2CSFA3X_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// formaldehyde sensor, readings are taken from hal::sensors()
+class SensirionI2CSfa3x {
+    public:
+        void begin(TwoWire &i2cBus) {}
+        uint16_t startContinuousMeasurement();
+        uint16_t stopMeasurement() { return 0; }
+        uint16_t readMeasuredValues(int16_t &hcho, int16_t &humidity, int16_t &temperature);
+};
+
+void errorToString(uint16_t error, char errorMessage[], size_t errorMessageSize);
+
+#endif
@@ -0,0 +1,44 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_STREAM_H
+#define _NATIVE_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() { return -1; }
+        size_t readBytes(uint8_t *buf, size_t len) {
+            size_t n = 0;
+            int c;
+            while (n < len && (c = this->read()) >= 0)
+                buf[n++] = (uint8_t)c;
+            return n;
+        }
+        size_t readBytes(char *buf, size_t len) { return readBytes((uint8_t*)buf, len); }
+        void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+    protected:
+        unsigned long timeout = 1000;
+};
+
+#endif
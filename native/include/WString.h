@@ -0,0 +1,69 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// minimal Arduino String on top of std::string
+
+#ifndef _NATIVE_WSTRING_H
+#define _NATIVE_WSTRING_H
+
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+class __FlashStringHelper;
+
+class String {
+    public:
+        String() {}
+        String(const char *str) : s(str ? str : "") {}
+        String(const std::string &str) : s(str) {}
+        String(char c) : s(1, c) {}
+        String(int n) : s(std::to_string(n)) {}
+        String(unsigned int n) : s(std::to_string(n)) {}
+        String(long n) : s(std::to_string(n)) {}
+        String(unsigned long n) : s(std::to_string(n)) {}
+        String(float n, unsigned int decimals = 2) { format(n, decimals); }
+        String(double n, unsigned int decimals = 2) { format(n, decimals); }
+        const char* c_str() const { return s.c_str(); }
+        unsigned int length() const { return s.length(); }
+        bool reserve(unsigned int size) { s.reserve(size); return true; }
+        bool concat(const char *str) { s += str; return true; }
+        bool concat(const char *str, unsigned int len) { s.append(str, len); return true; }
+        bool concat(char c) { s += c; return true; }
+        char operator[](unsigned int i) const { return s[i]; }
+        String& operator+=(const String &rhs) { s += rhs.s; return *this; }
+        String& operator+=(const char *rhs) { s += rhs; return *this; }
+        String& operator+=(char c) { s += c; return *this; }
+        friend String operator+(const String &lhs, const String &rhs) { return String(lhs.s + rhs.s); }
+        bool operator==(const String &rhs) const { return s == rhs.s; }
+        bool operator==(const char *rhs) const { return s == rhs; }
+        bool operator!=(const String &rhs) const { return s != rhs.s; }
+        int toInt() const { return atoi(s.c_str()); }
+        float toFloat() const { return atof(s.c_str()); }
+    private:
+        void format(double n, unsigned int decimals) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.*f", decimals, n);
+            s = buf;
+        }
+        std::string s;
+};
+
+#endif
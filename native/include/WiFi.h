@@ -0,0 +1,84 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// WiFi station state is taken from hal::network(),
+// WiFiClient uses plain TCP sockets of the host
+
+#ifndef _NATIVE_WIFI_H
+#define _NATIVE_WIFI_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA
+} wifi_mode_t;
+
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+class WiFiClass {
+    public:
+        bool isConnected();
+        int8_t RSSI();
+        String SSID();
+        IPAddress localIP();
+        IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+        bool enableSTA(bool enable) { return true; }
+        bool mode(wifi_mode_t mode) { this->wifiMode = mode; return true; }
+        wifi_mode_t getMode() { return this->wifiMode; }
+        int begin(const char *ssid, const char *psk = NULL) { return this->isConnected(); }
+        bool disconnect(bool wifiOff = false, bool eraseAP = false) { return true; }
+        bool setAutoReconnect(bool autoReconnect) { return true; }
+        int hostByName(const char *host, IPAddress &result);
+    private:
+        wifi_mode_t wifiMode = WIFI_MODE_STA;
+};
+
+class WiFiClient : public Client {
+    public:
+        WiFiClient() {}
+        ~WiFiClient() { this->stop(); }
+        int connect(IPAddress ip, uint16_t port);
+        int connect(const char *host, uint16_t port);
+        size_t write(uint8_t c) { return this->write(&c, 1); }
+        size_t write(const uint8_t *buf, size_t size);
+        int available();
+        int read();
+        int read(uint8_t *buf, size_t size);
+        int peek();
+        void flush() {}
+        void stop();
+        uint8_t connected();
+        operator bool() { return this->connected(); }
+        using Print::write;
+    private:
+        int fd = -1;
+};
+
+extern WiFiClass WiFi;
+
+#endif
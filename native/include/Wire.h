@@ -0,0 +1,39 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_WIRE_H
+#define _NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+// I2C bus, sensor drivers read from hal::sensors() instead
+class TwoWire {
+    public:
+        TwoWire(uint8_t busNum) : bus(busNum) {}
+        bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return true; }
+        void end() {}
+    private:
+        uint8_t bus;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -0,0 +1,114 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// In-process stand-in for the M5 LoRaWAN unit (ASR6501) on Serial2, speaks
+// the subset of the AT dialect used by ASR6501 in src/lorawan.cpp. Responses,
+// join results and receive windows are delivered after the configured
+// (simulated) delays by a background thread, which signals new data like
+// the ESP32's UART receive event.
+
+#ifndef _ASR6501SIM_H
+#define _ASR6501SIM_H
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <functional>
+#include <condition_variable>
+#include "hal.h"
+
+namespace hal {
+
+#define ASR6501_JOIN_FOREVER 255  // joinHangs: never report a join result
+
+typedef struct {
+    uint32_t latencyMs = 5;       // until a command is answered
+    uint32_t joinMs = 6000;       // from 'AT+CJOIN' until '+CJOIN:OK'
+    uint32_t rxWindowMs = 2000;   // from 'OK+SEND' until 'OK+SENT' (end of RX2)
+    uint8_t joinFailures = 0;     // number of joins answered with '+CJOIN:FAIL'
+    uint8_t joinHangs = 0;        // joins without result, e.g. ASR6501_JOIN_FOREVER
+    float sendFailRate = 0.0;     // share of uplinks without ack or lost
+    uint8_t dataRate = 3;
+    bool warmBoot = true;         // session saved with 'AT+CSAVE' survives reboot
+    uint32_t seed = 1;            // for send failures
+} ASR6501Config;
+
+typedef struct {
+    uint32_t commands;
+    uint32_t errors;     // commands answered with '+CME ERROR'
+    uint32_t joins;      // 'AT+CJOIN' requests
+    uint32_t uplinks;
+    uint32_t failed;     // uplinks without ack or lost
+    uint32_t downlinks;
+    uint32_t reboots;
+} ASR6501Stats;
+
+class ASR6501Simulator : public SerialDevice {
+    public:
+        ASR6501Simulator(const ASR6501Config &config = ASR6501Config());
+        ~ASR6501Simulator();
+        void begin(uint32_t baud);
+        void end();
+        size_t write(const uint8_t *buf, size_t len);
+        int available();
+        int read();
+        void onReceive(std::function<void()> callback);
+        void configure(const ASR6501Config &config);
+        bool configure(const char *options);
+        void downlink(uint8_t port, const uint8_t *data, size_t len);
+        ASR6501Stats stats();
+    private:
+        typedef struct {
+            bool active;
+            char devAddr[9];
+        } Session;
+        void run();
+        void command(const std::string &cmd);
+        void query(const std::string &name);
+        void transmit(const std::string &args);
+        void join();
+        void reboot();
+        void respond(const std::string &line, uint32_t delayMs = 0);
+        void emit(const std::string &line);
+        void schedule(uint32_t delayMs, std::function<void()> event);
+        ASR6501Config config;
+        ASR6501Stats counters;
+        std::map<std::string, std::string> settings, saved;
+        Session session, savedSession;
+        uint8_t status;
+        uint32_t joinAttempts;
+        uint32_t epoch;  // incremented on reboot, discards scheduled events
+        bool linkCheck;
+        std::deque<std::string> downlinks;  // '<port>,<len>,<data>'
+        std::string input, output;
+        std::multimap<uint64_t, std::function<void()>> events;
+        std::function<void()> callback;
+        std::minstd_rand random;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread worker;
+        bool stopped;
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// BSEC library subset for the host-native build, the precompiled library
+// is only available for the ESP32, so outputs are read from hal::sensors()
+
+#ifndef _NATIVE_BSEC_H
+#define _NATIVE_BSEC_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define BSEC_MAX_STATE_BLOB_SIZE 139
+#define BSEC_SAMPLE_RATE_DISABLED 65535.0f
+#define BSEC_SAMPLE_RATE_ULP 0.0033333f
+#define BSEC_SAMPLE_RATE_LP 0.33333f
+#define BME680_I2C_ADDR_PRIMARY 0x76
+#define BME680_I2C_ADDR_SECONDARY 0x77
+#define BME680_OK 0
+
+typedef enum {
+    BSEC_OK = 0,
+    BSEC_E_CONFIG_FAIL = -38,
+    BSEC_W_SC_CALL_TIMING_VIOLATION = 100
+} bsec_library_return_t;
+
+typedef enum {
+    BSEC_OUTPUT_IAQ = 1,
+    BSEC_OUTPUT_STATIC_IAQ = 2,
+    BSEC_OUTPUT_CO2_EQUIVALENT = 3,
+    BSEC_OUTPUT_BREATH_VOC_EQUIVALENT = 4,
+    BSEC_OUTPUT_RAW_TEMPERATURE = 6,
+    BSEC_OUTPUT_RAW_PRESSURE = 7,
+    BSEC_OUTPUT_RAW_HUMIDITY = 8,
+    BSEC_OUTPUT_RAW_GAS = 9,
+    BSEC_OUTPUT_STABILIZATION_STATUS = 12,
+    BSEC_OUTPUT_RUN_IN_STATUS = 13,
+    BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE = 14,
+    BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY = 15
+} bsec_virtual_sensor_t;
+
+typedef struct {
+    uint8_t major;
+    uint8_t minor;
+    uint8_t major_bugfix;
+    uint8_t minor_bugfix;
+} bsec_version_t;
+
+bsec_library_return_t bsec_get_version(bsec_version_t *version);
+
+class Bsec {
+    public:
+        Bsec();
+        void begin(uint8_t i2cAddr, TwoWire &i2c);
+        void setConfig(const uint8_t *config);
+        void setState(uint8_t *state);
+        void getState(uint8_t *state);
+        void updateSubscription(bsec_virtual_sensor_t sensorList[], uint8_t nSensors,
+            float sampleRate = BSEC_SAMPLE_RATE_ULP);
+        bool run(int64_t timeMilliseconds = -1);
+        int64_t getTimeMs();
+        int64_t nextCall;
+        bsec_library_return_t status;
+        int8_t bme680Status;
+        float iaq, rawTemperature, pressure, rawHumidity, gasResistance, stabStatus, runInStatus,
+            temperature, humidity, staticIaq, co2Equivalent, breathVocEquivalent;
+        uint8_t iaqAccuracy, staticIaqAccuracy, co2Accuracy, breathVocAccuracy;
+        int64_t outputTimestamp;
+    private:
+        uint32_t samplePeriodMs;
+        uint8_t state[BSEC_MAX_STATE_BLOB_SIZE];
+};
+
+#endif
@@ -0,0 +1,33 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#ifndef _NATIVE_ESP_OTA_OPS_H
+#define _NATIVE_ESP_OTA_OPS_H
+
+#include "esp_system.h"
+
+typedef struct {
+    const char *label;
+} esp_partition_t;
+
+const esp_partition_t* esp_ota_get_running_partition();
+esp_err_t esp_partition_get_sha256(const esp_partition_t *partition, uint8_t *sha256);
+
+#endif
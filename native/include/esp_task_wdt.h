@@ -0,0 +1,35 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// task watchdog is a no-op in the host-native build
+
+#ifndef _NATIVE_ESP_TASK_WDT_H
+#define _NATIVE_ESP_TASK_WDT_H
+
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+
+inline esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic) { return ESP_OK; }
+inline esp_err_t esp_task_wdt_deinit() { return ESP_OK; }
+inline esp_err_t esp_task_wdt_add(TaskHandle_t task) { return ESP_OK; }
+inline esp_err_t esp_task_wdt_delete(TaskHandle_t task) { return ESP_OK; }
+inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+
+#endif
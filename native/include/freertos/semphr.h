@@ -0,0 +1,2 @@
+// FreeRTOS compatibility header for the host-native build
+#include "freertos/FreeRTOS.h"
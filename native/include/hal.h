@@ -0,0 +1,147 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// Hardware abstraction layer for the host-native build ([env:native]).
+// The fake Arduino/M5Tough/WiFi/Preferences/sensor headers in this directory
+// forward every hardware access to one of the backends below. Each backend
+// can be replaced at runtime (e.g. by a replay trace or a serial simulator).
+
+#ifndef _HAL_H
+#define _HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace hal {
+
+// monotonic time source for millis()/delay()/vTaskDelay()
+class Clock {
+    public:
+        virtual ~Clock() {}
+        virtual uint64_t micros() = 0;
+        virtual void sleep(uint32_t ms) = 0;
+};
+
+// AXP192 power management (battery, USB power)
+class Power {
+    public:
+        virtual ~Power() {}
+        virtual float batteryVoltage() = 0;
+        virtual float batteryLevel() = 0;
+        virtual float vinVoltage() = 0;
+        virtual bool charging() = 0;
+        virtual void deepSleep(uint64_t us) = 0;
+};
+
+// raw values as returned by the I2C sensors
+typedef struct {
+    bool mlxPresent;
+    float mlxObjectTemp;
+    float mlxAmbientTemp;
+    bool sfaPresent;
+    int16_t sfaHCHO;  // ppb * 5
+    int16_t sfaHum;   // % * 100
+    int16_t sfaTemp;  // C * 200
+    bool bmePresent;
+    float bmeTemp;
+    float bmeHum;
+    float bmeIaq;
+    uint8_t bmeIaqAccuracy;
+    float bmeGasResistance;  // Ohm
+    float bmeCO2;
+    float bmeVOC;
+} SensorValues;
+
+// I2C bus with MLX90614, SFA30 and BME680 attached
+class SensorBus {
+    public:
+        virtual ~SensorBus() {}
+        virtual void sample(SensorValues *values) = 0;
+};
+
+// device attached to a HardwareSerial port (e.g. Serial2)
+class SerialDevice {
+    public:
+        virtual ~SerialDevice() {}
+        virtual void begin(uint32_t baud) = 0;
+        virtual void end() = 0;
+        virtual size_t write(const uint8_t *buf, size_t len) = 0;
+        virtual int available() = 0;
+        virtual int read() = 0;
+        // devices answering asynchronously call it when new data has arrived
+        virtual void onReceive(std::function<void()> callback) {}
+};
+
+// WiFi station state, TCP sockets are real host sockets
+class Network {
+    public:
+        virtual ~Network() {}
+        virtual bool connected() = 0;
+        virtual int8_t rssi() = 0;
+        virtual const char* ssid() = 0;
+};
+
+// NVS key/value storage
+class Storage {
+    public:
+        virtual ~Storage() {}
+        virtual bool load(const char *ns, const char *key, std::vector<uint8_t> &value) = 0;
+        virtual bool store(const char *ns, const char *key, const uint8_t *value, size_t len) = 0;
+        virtual bool remove(const char *ns, const char *key) = 0;
+        virtual bool clear(const char *ns) = 0;
+};
+
+// LCD, text output is optionally echoed to stdout
+class Display {
+    public:
+        virtual ~Display() {}
+        virtual void text(int16_t x, int16_t y, const char *str) = 0;
+        virtual void clear(uint16_t color) = 0;
+};
+
+Clock& clock();
+Power& power();
+SensorBus& sensors();
+SerialDevice& serial2();
+Network& network();
+Storage& storage();
+Display& display();
+
+void setClock(Clock *backend);
+void setPower(Power *backend);
+void setSensors(SensorBus *backend);
+void setSerial2(SerialDevice *backend);
+void setNetwork(Network *backend);
+void setStorage(Storage *backend);
+void setDisplay(Display *backend);
+
+// factor to speed up (>1) or slow down simulated time
+void setTimeScale(float scale);
+float timeScale();
+
+// replay sensor values from CSV file (see README.md, section host build)
+bool loadTrace(const char *path, bool loop);
+
+}
+
+#endif
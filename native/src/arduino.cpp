@@ -0,0 +1,270 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <stdarg.h>
+#include <unistd.h>
+#include <random>
+#include <mutex>
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include "hal.h"
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+EspClass ESP;
+
+namespace {
+    std::mutex randomMutex;
+    std::mt19937 rng(std::random_device{}());
+}
+
+
+unsigned long millis() {
+    return (unsigned long)(hal::clock().micros() / 1000);
+}
+
+
+unsigned long micros() {
+    return (unsigned long)hal::clock().micros();
+}
+
+
+void delay(uint32_t ms) {
+    hal::clock().sleep(ms);
+}
+
+
+void yield() {
+    hal::clock().sleep(0);
+}
+
+
+long random(long max) {
+    return max > 0 ? random(0, max) : 0;
+}
+
+
+long random(long min, long max) {
+    std::lock_guard<std::mutex> lock(randomMutex);
+    if (max <= min)
+        return min;
+    return min + (long)(rng() % (unsigned long)(max - min));
+}
+
+
+void randomSeed(unsigned long seed) {
+    std::lock_guard<std::mutex> lock(randomMutex);
+    rng.seed(seed);
+}
+
+
+char* dtostrf(double val, signed char width, unsigned char prec, char *buf) {
+    sprintf(buf, "%*.*f", width, prec, val);
+    return buf;
+}
+
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len >= size ? size - 1 : len;
+        memcpy(dst, src, n);
+        dst[n] = 0;
+    }
+    return len;
+}
+
+
+size_t strlcat(char *dst, const char *src, size_t size) {
+    size_t len = strnlen(dst, size);
+    if (len == size)
+        return len + strlen(src);
+    return len + strlcpy(dst + len, src, size - len);
+}
+#endif
+
+
+size_t Print::write(const uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (len--)
+        n += this->write(*buf++);
+    return n;
+}
+
+
+size_t Print::printf(const char *format, ...) {
+    char buf[256];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+    if ((size_t)len >= sizeof(buf)) {
+        char *big = new char[len + 1];
+        va_start(args, format);
+        vsnprintf(big, len + 1, format, args);
+        va_end(args);
+        size_t n = this->write((const uint8_t*)big, len);
+        delete[] big;
+        return n;
+    }
+    return this->write((const uint8_t*)buf, len);
+}
+
+
+size_t Print::print(long n, int base) {
+    if (base == DEC) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%ld", n);
+        return this->write(buf);
+    }
+    return this->print((unsigned long)n, base);
+}
+
+
+size_t Print::print(unsigned long n, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    if (base < 2)
+        base = 10;
+    *str = '\0';
+    do {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return this->write(str);
+}
+
+
+size_t Print::print(double n, int digits) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return this->write(buf);
+}
+
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+    if (this->uart == 2)
+        hal::serial2().begin(baud);
+}
+
+
+void HardwareSerial::end() {
+    if (this->uart == 2)
+        hal::serial2().end();
+}
+
+
+int HardwareSerial::available() {
+    return this->uart == 2 ? hal::serial2().available() : 0;
+}
+
+
+int HardwareSerial::read() {
+    return this->uart == 2 ? hal::serial2().read() : -1;
+}
+
+
+void HardwareSerial::onReceive(OnReceiveCb function, bool onlyOnTimeout) {
+    this->onReceiveCb = function;
+    if (this->uart == 2)
+        hal::serial2().onReceive(function);
+}
+
+
+size_t HardwareSerial::write(uint8_t c) {
+    return this->write(&c, 1);
+}
+
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {
+    if (this->uart == 2) {
+        len = hal::serial2().write(buf, len);
+        if (this->onReceiveCb && hal::serial2().available() > 0)
+            this->onReceiveCb();
+        return len;
+    }
+    return fwrite(buf, 1, len, stdout);
+}
+
+
+uint32_t EspClass::getFreeHeap() {
+    return 0;  // not meaningful on the host
+}
+
+
+uint32_t EspClass::getMinFreeHeap() {
+    return 0;
+}
+
+
+uint64_t EspClass::getEfuseMac() {
+    uint8_t mac[6];
+    uint64_t value = 0;
+
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    for (int i = 5; i >= 0; i--)
+        value = (value << 8) | mac[i];
+    return value;
+}
+
+
+void EspClass::restart() {
+    printf("HAL: ESP.restart(), exit\n");
+    fflush(stdout);
+    exit(0);
+}
+
+
+// locally administered MAC address derived from the host id
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+    uint32_t id = (uint32_t)gethostid();
+
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = (id >> 24) & 0xff;
+    mac[3] = (id >> 16) & 0xff;
+    mac[4] = (id >> 8) & 0xff;
+    mac[5] = (id & 0xff) + type;
+    return ESP_OK;
+}
+
+
+uint32_t esp_random() {
+    return (uint32_t)random(0, LONG_MAX);
+}
+
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    static const esp_partition_t partition = { "native" };
+    return &partition;
+}
+
+
+// constant checksum, NVS is only cleared when running a new binary on the device
+esp_err_t esp_partition_get_sha256(const esp_partition_t *partition, uint8_t *sha256) {
+    memset(sha256, 0x5a, 32);
+    return ESP_OK;
+}
@@ -0,0 +1,440 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <chrono>
+#include <Arduino.h>
+#include "asr6501sim.h"
+
+namespace hal {
+
+// status codes reported by 'AT+CSTATUS?'
+#define STATUS_IDLE 0
+#define STATUS_SENDING 1
+#define STATUS_SEND_FAILED 2
+#define STATUS_JOINED 4
+#define STATUS_JOIN_FAILED 5
+#define STATUS_SENT 7
+#define STATUS_SENT_DOWNLINK 8
+
+
+ASR6501Simulator::ASR6501Simulator(const ASR6501Config &config) : config(config), random(config.seed) {
+    memset(&this->counters, 0, sizeof(this->counters));
+    memset(&this->session, 0, sizeof(this->session));
+    memset(&this->savedSession, 0, sizeof(this->savedSession));
+    this->status = STATUS_IDLE;
+    this->joinAttempts = 0;
+    this->epoch = 0;
+    this->linkCheck = false;
+    this->stopped = false;
+    this->worker = std::thread(&ASR6501Simulator::run, this);
+}
+
+
+ASR6501Simulator::~ASR6501Simulator() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopped = true;
+        this->cond.notify_all();
+    }
+    this->worker.join();
+}
+
+
+// the module keeps running while the UART is closed
+void ASR6501Simulator::begin(uint32_t baud) {}
+
+
+void ASR6501Simulator::end() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->input.clear();
+}
+
+
+// commands are executed as soon as their line is complete
+size_t ASR6501Simulator::write(const uint8_t *buf, size_t len) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == '\n') {
+            if (!this->input.empty())
+                this->command(this->input);
+            this->input.clear();
+        } else if (buf[i] != '\r') {
+            this->input += (char)buf[i];
+        }
+    }
+    return len;
+}
+
+
+int ASR6501Simulator::available() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->output.size();
+}
+
+
+int ASR6501Simulator::read() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    int c;
+
+    if (this->output.empty())
+        return -1;
+    c = (uint8_t)this->output[0];
+    this->output.erase(0, 1);
+    return c;
+}
+
+
+void ASR6501Simulator::onReceive(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->callback = callback;
+}
+
+
+void ASR6501Simulator::configure(const ASR6501Config &config) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->config = config;
+    this->random.seed(config.seed);
+}
+
+
+// comma separated options, e.g. 'latency=20,joinfail=1,downlink=10:0104'
+// (see README.md, section host build), returns false on unknown options
+bool ASR6501Simulator::configure(const char *options) {
+    ASR6501Config config = this->config;
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> downlinks;
+    char key[16], value[64];
+    const char *next = options;
+    unsigned int port, byte;
+    int len;
+
+    while (next != NULL && *next != '\0') {
+        value[0] = '\0';
+        if (sscanf(next, "%15[^=,]%n", key, &len) != 1)
+            return false;
+        next += len;
+        if (*next == '=' && sscanf(++next, "%63[^,]%n", value, &len) == 1)
+            next += len;
+        if (*next == ',')
+            next++;
+
+        if (!strcmp(key, "latency")) {
+            config.latencyMs = strtoul(value, NULL, 10);
+        } else if (!strcmp(key, "join")) {
+            config.joinMs = strtoul(value, NULL, 10);
+        } else if (!strcmp(key, "rx")) {
+            config.rxWindowMs = strtoul(value, NULL, 10);
+        } else if (!strcmp(key, "joinfail")) {
+            config.joinFailures = strtoul(value, NULL, 10);
+        } else if (!strcmp(key, "joinhang")) {
+            config.joinHangs = !strcmp(value, "forever") ? ASR6501_JOIN_FOREVER : strtoul(value, NULL, 10);
+        } else if (!strcmp(key, "sendfail")) {
+            config.sendFailRate = atof(value);
+        } else if (!strcmp(key, "dr")) {
+            config.dataRate = min(strtoul(value, NULL, 10), 5UL);
+        } else if (!strcmp(key, "coldboot")) {
+            config.warmBoot = false;
+        } else if (!strcmp(key, "seed")) {
+            config.seed = strtoul(value, NULL, 10);
+        } else if (!strcmp(key, "downlink")) {
+            std::vector<uint8_t> data;
+            if (sscanf(value, "%u:%n", &port, &len) != 1)
+                return false;
+            for (const char *hex = value + len; sscanf(hex, "%2x", &byte) == 1; hex += 2)
+                data.push_back(byte);
+            downlinks.push_back(std::make_pair(port, data));
+        } else {
+            return false;
+        }
+    }
+
+    this->configure(config);
+    for (auto &downlink : downlinks)
+        this->downlink(downlink.first, downlink.second.data(), downlink.second.size());
+    return true;
+}
+
+
+// queue downlink for the receive windows of the next uplink
+void ASR6501Simulator::downlink(uint8_t port, const uint8_t *data, size_t len) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    char hex[3];
+    std::string line;
+
+    snprintf(hex, sizeof(hex), "%02X", port);
+    line = std::string(hex) + ",";
+    snprintf(hex, sizeof(hex), "%02X", (uint8_t)len);
+    line += std::string(hex) + ",";
+    for (size_t i = 0; i < len; i++) {
+        snprintf(hex, sizeof(hex), "%02X", data[i]);
+        line += hex;
+    }
+    this->downlinks.push_back(line);
+}
+
+
+ASR6501Stats ASR6501Simulator::stats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->counters;
+}
+
+
+// delivers scheduled responses and unsolicited results when they are due
+void ASR6501Simulator::run() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    std::function<void()> event, notify;
+    uint64_t now;
+    size_t pending;
+
+    while (!this->stopped) {
+        if (this->events.empty()) {
+            this->cond.wait(lock);
+            continue;
+        }
+        now = millis();
+        if (this->events.begin()->first > now) {
+            this->cond.wait_for(lock, std::chrono::microseconds(
+                (uint64_t)((this->events.begin()->first - now) * 1000 / timeScale())));
+            continue;
+        }
+        event = this->events.begin()->second;
+        this->events.erase(this->events.begin());
+        pending = this->output.size();
+        event();
+        if (this->output.size() > pending && this->callback) {
+            notify = this->callback;
+            lock.unlock();
+            notify();
+            lock.lock();
+        }
+    }
+}
+
+
+// run event after given (simulated) delay unless the module has been rebooted
+void ASR6501Simulator::schedule(uint32_t delayMs, std::function<void()> event) {
+    uint32_t scheduled = this->epoch;
+
+    this->events.emplace(millis() + delayMs, [this, scheduled, event]() {
+        if (scheduled == this->epoch)
+            event();
+    });
+    this->cond.notify_all();
+}
+
+
+void ASR6501Simulator::emit(const std::string &line) {
+    this->output += line + "\r\n";
+}
+
+
+// answer line sent after the command latency (and an optional delay)
+void ASR6501Simulator::respond(const std::string &line, uint32_t delayMs) {
+    this->schedule(this->config.latencyMs + delayMs, [this, line]() { this->emit(line); });
+}
+
+
+// execute a command line, e.g. 'AT+CSTATUS?' or 'AT+CCLASS=2'
+void ASR6501Simulator::command(const std::string &cmd) {
+    size_t end = cmd.find_first_of("=?");
+    std::string name, value;
+
+    this->counters.commands++;
+    if (cmd == "AT") {
+        this->respond("OK");
+        return;
+    } else if (cmd.compare(0, 3, "AT+") != 0) {
+        this->counters.errors++;
+        this->respond("+CME ERROR:1");
+        return;
+    }
+
+    name = cmd.substr(3, end == std::string::npos ? std::string::npos : end - 3);
+    if (end != std::string::npos && cmd[end] == '?') {
+        this->query(name);
+        return;
+    }
+
+    if (end == std::string::npos) {
+        if (name == "CSAVE") {
+            this->saved = this->settings;
+            this->savedSession = this->session;
+        } else if (name == "CRESTORE") {
+            this->settings.clear();
+            this->session.active = false;
+            this->status = STATUS_IDLE;
+        } else {
+            this->counters.errors++;
+            this->respond("+CME ERROR:1");
+            return;
+        }
+        this->respond("OK");
+        return;
+    }
+
+    value = cmd.substr(end + 1);
+    if (name == "DTRX") {
+        this->transmit(value);
+    } else if (name == "CJOIN") {
+        this->respond("OK");
+        if (value.compare(0, 1, "1") == 0)
+            this->join();
+    } else if (name == "CLINKCHECK") {
+        this->linkCheck = (value != "0");
+        this->respond("OK");
+    } else if (name == "IREBOOT") {
+        this->respond("OK");
+        this->schedule(this->config.latencyMs, [this]() { this->reboot(); });
+    } else {
+        this->settings[name] = value;
+        this->respond("OK");
+    }
+}
+
+
+// answer 'AT+<name>?' with '+<name>:<value>' and 'OK'
+void ASR6501Simulator::query(const std::string &name) {
+    char value[16];
+
+    if (name == "CGMI") {
+        strcpy(value, "ASR");
+    } else if (name == "CGMM") {
+        strcpy(value, "ASR6501");
+    } else if (name == "CSTATUS") {
+        snprintf(value, sizeof(value), "%02d", this->status);
+    } else if (name == "CDEVADDR") {
+        strcpy(value, this->session.active ? this->session.devAddr : "00000000");
+    } else if (name == "CDATARATE") {
+        snprintf(value, sizeof(value), "%d", this->config.dataRate);
+    } else if (this->settings.count(name)) {
+        this->respond("+" + name + ":" + this->settings[name]);
+        this->respond("OK");
+        return;
+    } else {
+        this->counters.errors++;
+        this->respond("+CME ERROR:1");
+        return;
+    }
+    this->respond("+" + name + ":" + value);
+    this->respond("OK");
+}
+
+
+// OTAA join, the first 'joinHangs' attempts never finish (like the M5 unit,
+// which keeps trying forever), the next 'joinFailures' ones fail
+void ASR6501Simulator::join() {
+    uint32_t attempt = this->joinAttempts++;
+
+    this->counters.joins++;
+    this->session.active = false;
+    this->status = STATUS_IDLE;
+
+    if (this->config.joinHangs == ASR6501_JOIN_FOREVER || attempt < this->config.joinHangs)
+        return;
+    if (attempt < (uint32_t)this->config.joinHangs + this->config.joinFailures) {
+        this->schedule(this->config.joinMs, [this, attempt]() {
+            if (attempt + 1 != this->joinAttempts)
+                return;  // restarted in the meantime
+            this->status = STATUS_JOIN_FAILED;
+            this->emit("+CJOIN:FAIL");
+        });
+        return;
+    }
+    this->schedule(this->config.joinMs, [this, attempt]() {
+        if (attempt + 1 != this->joinAttempts)
+            return;
+        this->session.active = true;
+        snprintf(this->session.devAddr, sizeof(this->session.devAddr), "26%06X",
+            (unsigned int)(this->random() & 0xFFFFFF));
+        this->status = STATUS_JOINED;
+        this->emit("+CJOIN:OK");
+    });
+}
+
+
+// 'AT+IREBOOT', restores saved settings and with warm boot also the saved session
+void ASR6501Simulator::reboot() {
+    this->counters.reboots++;
+    this->epoch++;
+    this->settings = this->saved;
+    this->session = this->config.warmBoot ? this->savedSession : Session();
+    this->status = this->session.active ? STATUS_JOINED : STATUS_IDLE;
+    this->linkCheck = false;
+}
+
+
+// 'AT+DTRX=<confirm>,<trials>,<len>,<hex data>', 'OK+SEND' is followed by
+// 'OK+SENT' (or 'ERR+SENT' for a confirmed uplink without ack), a link
+// check answer and a downlink ('OK+RECV') after the receive windows
+void ASR6501Simulator::transmit(const std::string &args) {
+    int confirm, trials, len, data = 0;
+    char sent[16];
+
+    if (sscanf(args.c_str(), "%d,%d,%d,%n", &confirm, &trials, &len, &data) != 3 || data == 0 ||
+            len != (int)(args.size() - data) || (len & 1)) {
+        this->counters.errors++;
+        this->respond("+CME ERROR:1");
+        return;
+    }
+    if (!this->session.active) {
+        this->respond("ERR+SEND:00");
+        return;
+    }
+
+    this->counters.uplinks++;
+    this->status = STATUS_SENDING;
+    snprintf(sent, sizeof(sent), "OK+SEND:%02X", len / 2);
+    this->respond(sent);
+    this->schedule(this->config.latencyMs + this->config.rxWindowMs, [this, confirm, trials]() {
+        char line[16];
+        bool received = false;
+
+        if (std::uniform_real_distribution<float>(0, 1)(this->random) < this->config.sendFailRate) {
+            this->counters.failed++;
+            this->linkCheck = false;
+            if (confirm) {
+                snprintf(line, sizeof(line), "ERR+SENT:%02X", trials);
+                this->emit(line);
+                this->status = STATUS_SEND_FAILED;
+            } else {
+                this->emit("OK+SENT:01");  // lost, but the module can't tell
+                this->status = STATUS_SENT;
+            }
+            return;
+        }
+
+        this->emit("OK+SENT:01");
+        if (this->linkCheck) {
+            this->emit("+CLINKCHECK: 0 20 1 -80 7");
+            this->linkCheck = false;
+        }
+        if (!this->downlinks.empty()) {
+            this->emit("OK+RECV:00," + this->downlinks.front());
+            this->downlinks.pop_front();
+            this->counters.downlinks++;
+            received = true;
+        } else if (confirm) {
+            this->emit("OK+RECV:02,00,00");  // bare ack
+        }
+        this->status = received ? STATUS_SENT_DOWNLINK : STATUS_SENT;
+    });
+}
+
+}
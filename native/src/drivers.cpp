@@ -0,0 +1,157 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <Adafruit_MLX90614.h>
+#include <SensirionI2CSfa3x.h>
+#include <bsec.h>
+#include "hal.h"
+
+
+bool Adafruit_MLX90614::begin(uint8_t addr, TwoWire *wire) {
+    hal::SensorValues values;
+    hal::sensors().sample(&values);
+    return values.mlxPresent;
+}
+
+
+double Adafruit_MLX90614::readObjectTempC() {
+    hal::SensorValues values;
+    hal::sensors().sample(&values);
+    return values.mlxPresent ? values.mlxObjectTemp : NAN;
+}
+
+
+double Adafruit_MLX90614::readAmbientTempC() {
+    hal::SensorValues values;
+    hal::sensors().sample(&values);
+    return values.mlxPresent ? values.mlxAmbientTemp : NAN;
+}
+
+
+uint16_t SensirionI2CSfa3x::startContinuousMeasurement() {
+    hal::SensorValues values;
+    hal::sensors().sample(&values);
+    return values.sfaPresent ? 0 : 0x20;  // ReadError
+}
+
+
+uint16_t SensirionI2CSfa3x::readMeasuredValues(int16_t &hcho, int16_t &humidity, int16_t &temperature) {
+    hal::SensorValues values;
+
+    hal::sensors().sample(&values);
+    if (!values.sfaPresent)
+        return 0x20;
+    hcho = values.sfaHCHO;
+    humidity = values.sfaHum;
+    temperature = values.sfaTemp;
+    return 0;
+}
+
+
+void errorToString(uint16_t error, char errorMessage[], size_t errorMessageSize) {
+    snprintf(errorMessage, errorMessageSize, "I2C read error (0x%04x)", error);
+}
+
+
+bsec_library_return_t bsec_get_version(bsec_version_t *version) {
+    version->major = 1;
+    version->minor = 4;
+    version->major_bugfix = 8;
+    version->minor_bugfix = 0;
+    return BSEC_OK;
+}
+
+
+Bsec::Bsec() {
+    this->nextCall = 0;
+    this->status = BSEC_OK;
+    this->bme680Status = BME680_OK;
+    this->iaq = this->rawTemperature = this->pressure = this->rawHumidity = 0.0;
+    this->gasResistance = this->stabStatus = this->runInStatus = this->temperature = 0.0;
+    this->humidity = this->staticIaq = this->co2Equivalent = this->breathVocEquivalent = 0.0;
+    this->iaqAccuracy = this->staticIaqAccuracy = this->co2Accuracy = this->breathVocAccuracy = 0;
+    this->outputTimestamp = 0;
+    this->samplePeriodMs = 3000;
+    memset(this->state, 0, sizeof(this->state));
+}
+
+
+void Bsec::begin(uint8_t i2cAddr, TwoWire &i2c) {
+    hal::SensorValues values;
+
+    hal::sensors().sample(&values);
+    this->bme680Status = values.bmePresent ? BME680_OK : -2;  // BME680_E_DEV_NOT_FOUND
+}
+
+
+void Bsec::setConfig(const uint8_t *config) {
+    this->status = BSEC_OK;
+}
+
+
+void Bsec::setState(uint8_t *state) {
+    memcpy(this->state, state, sizeof(this->state));
+    this->status = BSEC_OK;
+}
+
+
+void Bsec::getState(uint8_t *state) {
+    memcpy(state, this->state, sizeof(this->state));
+    this->status = BSEC_OK;
+}
+
+
+void Bsec::updateSubscription(bsec_virtual_sensor_t sensorList[], uint8_t nSensors, float sampleRate) {
+    this->samplePeriodMs = (uint32_t)(1000 / sampleRate);
+    this->status = BSEC_OK;
+}
+
+
+int64_t Bsec::getTimeMs() {
+    return (int64_t)millis();
+}
+
+
+// delivers new outputs once per sample period like the BSEC library
+bool Bsec::run(int64_t timeMilliseconds) {
+    hal::SensorValues values;
+    int64_t now = timeMilliseconds >= 0 ? timeMilliseconds : this->getTimeMs();
+
+    if (now < this->nextCall || this->bme680Status != BME680_OK)
+        return false;
+    this->nextCall = now + this->samplePeriodMs;
+    this->outputTimestamp = now * 1000000;
+
+    hal::sensors().sample(&values);
+    this->temperature = this->rawTemperature = values.bmeTemp;
+    this->humidity = this->rawHumidity = values.bmeHum;
+    this->iaq = this->staticIaq = values.bmeIaq;
+    this->iaqAccuracy = this->staticIaqAccuracy = values.bmeIaqAccuracy;
+    this->gasResistance = values.bmeGasResistance;
+    this->co2Equivalent = values.bmeCO2;
+    this->breathVocEquivalent = values.bmeVOC;
+    this->runInStatus = this->stabStatus = (values.bmeIaqAccuracy > 0) ? 1.0 : 0.0;
+    this->pressure = 101325.0;
+
+    // fake state blob, changes whenever the accuracy changes
+    this->state[0] = 0x01;
+    this->state[1] = values.bmeIaqAccuracy;
+    return true;
+}
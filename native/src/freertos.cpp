@@ -0,0 +1,343 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <string>
+#include <Arduino.h>
+#include "hal.h"
+
+struct NativeTask {
+    std::string name;
+    uint32_t stackDepth;
+    std::mutex mutex;
+    std::condition_variable cond;
+    uint32_t notifications;
+    bool deleted;
+};
+
+// queues with zero item size serve as (counting) semaphores
+struct NativeQueue {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t count;
+};
+
+namespace {
+
+thread_local NativeTask *currentTask = NULL;
+std::recursive_mutex criticalSection;
+
+typedef struct {
+    TaskFunction_t fn;
+    void *param;
+    NativeTask *task;
+} TaskStart;
+
+// converts ticks of simulated time into a deadline in real time
+std::chrono::steady_clock::time_point deadline(TickType_t ticks) {
+    return std::chrono::steady_clock::now() +
+        std::chrono::microseconds((uint64_t)(ticks * 1000 / hal::timeScale()));
+}
+
+// waits until predicate is true or timeout (ticks) has passed
+template<typename Lock, typename Pred>
+bool waitFor(std::condition_variable &cond, Lock &lock, TickType_t ticks, Pred pred) {
+    if (ticks == portMAX_DELAY) {
+        cond.wait(lock, pred);
+        return true;
+    }
+    return cond.wait_until(lock, deadline(ticks), pred);
+}
+
+// a task deleted by another one exits with its next blocking call
+void exitIfDeleted() {
+    if (currentTask != NULL && currentTask->deleted)
+        pthread_exit(NULL);
+}
+
+void* taskEntry(void *arg) {
+    TaskStart *start = (TaskStart*)arg;
+    currentTask = start->task;
+    start->fn(start->param);
+    delete start;
+    return NULL;
+}
+
+BaseType_t queueSend(QueueHandle_t q, const void *item, TickType_t ticks, bool front) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(q->cond, lock, ticks, [q] { return q->items.size() < q->length; }))
+        return pdFALSE;
+    std::vector<uint8_t> data((const uint8_t*)item, (const uint8_t*)item + q->itemSize);
+    if (front)
+        q->items.push_front(data);
+    else
+        q->items.push_back(data);
+    q->cond.notify_all();
+    return pdTRUE;
+}
+
+}
+
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+        void *param, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+    pthread_t thread;
+    pthread_attr_t attr;
+    NativeTask *task = new NativeTask();
+
+    task->name = name;
+    task->stackDepth = stackDepth;
+    task->notifications = 0;
+    task->deleted = false;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    // stack size of host threads is not comparable to the ESP32
+    if (pthread_create(&thread, &attr, taskEntry, new TaskStart{ fn, param, task }) != 0) {
+        pthread_attr_destroy(&attr);
+        delete task;
+        return pdFAIL;
+    }
+    pthread_attr_destroy(&attr);
+    if (handle != NULL)
+        *handle = task;
+    return pdPASS;
+}
+
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+        void *param, UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+
+// host threads cannot be killed, other tasks exit when they block next
+// (vTaskDelay(), ulTaskNotifyTake()), their handles are never freed
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == currentTask)
+        pthread_exit(NULL);
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->deleted = true;
+    task->cond.notify_all();
+}
+
+
+void vTaskDelay(TickType_t ticks) {
+    exitIfDeleted();
+    hal::clock().sleep(ticks);
+    exitIfDeleted();
+}
+
+
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment) {
+    TickType_t wake = *previousWakeTime + increment;
+    TickType_t now = xTaskGetTickCount();
+
+    if ((int32_t)(wake - now) > 0)
+        vTaskDelay(wake - now);
+    *previousWakeTime = wake;
+}
+
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (currentTask == NULL) {
+        currentTask = new NativeTask();
+        currentTask->name = "main";
+        currentTask->stackDepth = 0;
+        currentTask->notifications = 0;
+        currentTask->deleted = false;
+    }
+    return currentTask;
+}
+
+
+// not tracked for host threads, the whole stack is reported as unused
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (task == NULL)
+        task = currentTask;
+    return task != NULL ? task->stackDepth : 0;
+}
+
+
+BaseType_t xPortGetCoreID() {
+    return sched_getcpu() % 2;
+}
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+    task->cond.notify_all();
+    return pdPASS;
+}
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    NativeTask *task = xTaskGetCurrentTaskHandle();
+    uint32_t value;
+
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        waitFor(task->cond, lock, ticks, [task] { return task->notifications > 0 || task->deleted; });
+        value = task->notifications;
+        if (value > 0)
+            task->notifications = clearOnExit ? 0 : value - 1;
+    }
+    exitIfDeleted();
+    return value;
+}
+
+
+void vPortEnterCritical(portMUX_TYPE *mux) {
+    criticalSection.lock();
+}
+
+
+void vPortExitCritical(portMUX_TYPE *mux) {
+    criticalSection.unlock();
+}
+
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    NativeQueue *q = new NativeQueue();
+    q->length = length;
+    q->itemSize = itemSize;
+    q->count = 0;
+    return q;
+}
+
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queueSend(queue, item, ticks, false);
+}
+
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queueSend(queue, item, ticks, true);
+}
+
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    queue->items.emplace_back((const uint8_t*)item, (const uint8_t*)item + queue->itemSize);
+    queue->cond.notify_all();
+    return pdTRUE;
+}
+
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue->cond, lock, ticks, [queue] { return !queue->items.empty(); }))
+        return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->cond.notify_all();
+    return pdTRUE;
+}
+
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue->cond, lock, ticks, [queue] { return !queue->items.empty(); }))
+        return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    return pdTRUE;
+}
+
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    queue->cond.notify_all();
+    return pdPASS;
+}
+
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->length - queue->items.size();
+}
+
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+    SemaphoreHandle_t sem = xQueueCreate(maxCount, 0);
+    sem->count = initialCount;
+    return sem;
+}
+
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    if (!waitFor(sem->cond, lock, ticks, [sem] { return sem->count > 0; }))
+        return pdFALSE;
+    sem->count--;
+    return pdTRUE;
+}
+
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    std::lock_guard<std::mutex> lock(sem->mutex);
+    if (sem->count >= sem->length)
+        return pdFALSE;
+    sem->count++;
+    sem->cond.notify_all();
+    return pdTRUE;
+}
+
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete sem;
+}
@@ -0,0 +1,277 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <sys/stat.h>
+#include <Arduino.h>
+#include "hal.h"
+
+namespace hal {
+
+namespace {
+
+float scale = 1.0;
+
+// host clock, simulated time runs 'scale' times faster than real time
+class SystemClock : public Clock {
+    public:
+        SystemClock() : start(std::chrono::steady_clock::now()) {}
+        uint64_t micros() {
+            auto elapsed = std::chrono::steady_clock::now() - this->start;
+            return (uint64_t)(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() * scale);
+        }
+        void sleep(uint32_t ms) {
+            std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(ms * 1000 / scale)));
+        }
+    private:
+        std::chrono::steady_clock::time_point start;
+};
+
+// USB powered device with fully charged battery
+class UsbPower : public Power {
+    public:
+        float batteryVoltage() { return 4.1; }
+        float batteryLevel() { return 100.0; }
+        float vinVoltage() { return 5.0; }
+        bool charging() { return false; }
+        void deepSleep(uint64_t us) {
+            printf("HAL: deep sleep for %llu secs, exit\n", (unsigned long long)(us / 1000000));
+            exit(0);
+        }
+};
+
+// synthetic readings slowly drifting around typical indoor values
+class SyntheticSensors : public SensorBus {
+    public:
+        void sample(SensorValues *v) {
+            float t = millis() / 60000.0;  // minutes
+            v->mlxPresent = v->sfaPresent = v->bmePresent = true;
+            v->mlxObjectTemp = 24.0 + 2.0 * sin(t / 10);
+            v->mlxAmbientTemp = 22.5 + 0.5 * sin(t / 30);
+            v->sfaHCHO = (int16_t)((12.0 + 4.0 * sin(t / 20)) * 5);
+            v->sfaHum = (int16_t)((45.0 + 5.0 * sin(t / 40)) * 100);
+            v->sfaTemp = (int16_t)((22.5 + 0.5 * sin(t / 30)) * 200);
+            v->bmeTemp = 22.8 + 0.5 * sin(t / 30);
+            v->bmeHum = 44.0 + 5.0 * sin(t / 40);
+            v->bmeIaq = 60.0 + 25.0 * sin(t / 15);
+            v->bmeIaqAccuracy = t < 5 ? 0 : (t < 30 ? 1 : 3);
+            v->bmeGasResistance = 120000.0 + 20000.0 * sin(t / 15);
+            v->bmeCO2 = 600.0 + 150.0 * sin(t / 15);
+            v->bmeVOC = 0.8 + 0.3 * sin(t / 15);
+        }
+};
+
+// replays sensor values from a CSV trace, first line lists the column names,
+// column 't' holds the offset in seconds since startup
+class TraceSensors : public SensorBus {
+    public:
+        bool load(const char *path, bool loop) {
+            std::ifstream file(path);
+            std::string line, cell;
+            std::vector<std::string> columns;
+
+            if (!file.is_open() || !std::getline(file, line))
+                return false;
+            std::stringstream header(line);
+            while (std::getline(header, cell, ','))
+                columns.push_back(cell);
+            while (std::getline(file, line)) {
+                std::stringstream row(line);
+                std::map<std::string, float> values;
+                for (size_t i = 0; i < columns.size() && std::getline(row, cell, ','); i++) {
+                    if (!cell.empty())
+                        values[columns[i]] = atof(cell.c_str());
+                }
+                if (values.count("t"))
+                    this->rows.push_back(values);
+            }
+            this->loop = loop;
+            return !this->rows.empty();
+        }
+        void sample(SensorValues *v) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            double now = millis() / 1000.0;
+            double duration = this->rows.back().at("t");
+
+            if (this->loop && duration > 0)
+                now = fmod(now, duration);
+            if (now < this->last) {  // trace restarted
+                this->next = 0;
+                this->current.clear();
+            }
+            this->last = now;
+            while (this->next < this->rows.size() && this->rows[this->next].at("t") <= now) {
+                for (auto &col : this->rows[this->next])
+                    this->current[col.first] = col.second;
+                this->next++;
+            }
+            v->mlxPresent = this->current.count("mlxObjectTemp") > 0;
+            v->mlxObjectTemp = this->value("mlxObjectTemp");
+            v->mlxAmbientTemp = this->value("mlxAmbientTemp");
+            v->sfaPresent = this->current.count("hcho") > 0;
+            v->sfaHCHO = (int16_t)(this->value("hcho") * 5);
+            v->sfaHum = (int16_t)(this->value("sfaHum") * 100);
+            v->sfaTemp = (int16_t)(this->value("sfaTemp") * 200);
+            v->bmePresent = this->current.count("bmeTemp") > 0;
+            v->bmeTemp = this->value("bmeTemp");
+            v->bmeHum = this->value("bmeHum");
+            v->bmeIaq = this->value("iaq");
+            v->bmeIaqAccuracy = (uint8_t)this->value("iaqAccuracy");
+            v->bmeGasResistance = this->value("gasResistance") * 1000;  // kOhm in trace
+            v->bmeCO2 = this->value("eCO2");
+            v->bmeVOC = this->value("VOC");
+        }
+    private:
+        float value(const char *name) {
+            auto it = this->current.find(name);
+            return it != this->current.end() ? it->second : 0.0;
+        }
+        std::vector<std::map<std::string, float>> rows;
+        std::map<std::string, float> current;
+        size_t next = 0;
+        double last = 0;
+        bool loop = false;
+        std::mutex mutex;
+};
+
+// nothing attached to the serial port
+class NoSerialDevice : public SerialDevice {
+    public:
+        void begin(uint32_t baud) {}
+        void end() {}
+        size_t write(const uint8_t *buf, size_t len) { return len; }
+        int available() { return 0; }
+        int read() { return -1; }
+};
+
+// WiFi is always connected
+class HostNetwork : public Network {
+    public:
+        bool connected() { return true; }
+        int8_t rssi() { return -55; }
+        const char* ssid() { return "native"; }
+};
+
+// one file per NVS key below directory NATIVE_NVS_DIR (default .nvs)
+class FileStorage : public Storage {
+    public:
+        bool load(const char *ns, const char *key, std::vector<uint8_t> &value) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            std::ifstream file(this->path(ns, key), std::ios::binary);
+            if (!file.is_open())
+                return false;
+            value.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return true;
+        }
+        bool store(const char *ns, const char *key, const uint8_t *value, size_t len) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            mkdir(this->dir().c_str(), 0755);
+            mkdir((this->dir() + "/" + ns).c_str(), 0755);
+            std::ofstream file(this->path(ns, key), std::ios::binary | std::ios::trunc);
+            file.write((const char*)value, len);
+            return file.good();
+        }
+        bool remove(const char *ns, const char *key) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            return ::remove(this->path(ns, key).c_str()) == 0;
+        }
+        bool clear(const char *ns) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            std::string cmd = "rm -rf '" + this->dir() + "/" + ns + "'";
+            return system(cmd.c_str()) == 0;
+        }
+    private:
+        std::string dir() {
+            const char *dir = getenv("NATIVE_NVS_DIR");
+            return dir ? dir : ".nvs";
+        }
+        std::string path(const char *ns, const char *key) {
+            return this->dir() + "/" + ns + "/" + key;
+        }
+        std::mutex mutex;
+};
+
+// prints text drawn on the LCD if NATIVE_DISPLAY is set
+class ConsoleDisplay : public Display {
+    public:
+        void text(int16_t x, int16_t y, const char *str) {
+            if (getenv("NATIVE_DISPLAY"))
+                printf("LCD[%3d,%3d]: %s\n", x, y, str);
+        }
+        void clear(uint16_t color) {}
+};
+
+SystemClock defaultClock;
+UsbPower defaultPower;
+SyntheticSensors defaultSensors;
+TraceSensors traceSensors;
+NoSerialDevice defaultSerial2;
+HostNetwork defaultNetwork;
+FileStorage defaultStorage;
+ConsoleDisplay defaultDisplay;
+
+Clock *clockBackend = &defaultClock;
+Power *powerBackend = &defaultPower;
+SensorBus *sensorBackend = &defaultSensors;
+SerialDevice *serial2Backend = &defaultSerial2;
+Network *networkBackend = &defaultNetwork;
+Storage *storageBackend = &defaultStorage;
+Display *displayBackend = &defaultDisplay;
+
+}
+
+Clock& clock() { return *clockBackend; }
+Power& power() { return *powerBackend; }
+SensorBus& sensors() { return *sensorBackend; }
+SerialDevice& serial2() { return *serial2Backend; }
+Network& network() { return *networkBackend; }
+Storage& storage() { return *storageBackend; }
+Display& display() { return *displayBackend; }
+
+void setClock(Clock *backend) { clockBackend = backend; }
+void setPower(Power *backend) { powerBackend = backend; }
+void setSensors(SensorBus *backend) { sensorBackend = backend; }
+void setSerial2(SerialDevice *backend) { serial2Backend = backend; }
+void setNetwork(Network *backend) { networkBackend = backend; }
+void setStorage(Storage *backend) { storageBackend = backend; }
+void setDisplay(Display *backend) { displayBackend = backend; }
+
+void setTimeScale(float s) {
+    if (s > 0)
+        scale = s;
+}
+
+float timeScale() {
+    return scale;
+}
+
+bool loadTrace(const char *path, bool loop) {
+    if (!traceSensors.load(path, loop))
+        return false;
+    sensorBackend = &traceSensors;
+    return true;
+}
+
+}
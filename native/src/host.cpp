@@ -0,0 +1,74 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// entry point of the host-native build, runs the firmware's setup() once
+// and loop() until the optional run time has passed, options:
+//   -t <file>  replay sensor trace (CSV, see README.md)
+//   -l         loop trace
+//   -s <x>     time scale factor (e.g. 10 runs ten times faster)
+//   -r <secs>  exit after given number of (simulated) seconds
+//   -a <opts>  attach simulated LoRaWAN adapter (ASR6501) to Serial2
+
+#include <unistd.h>
+#include <Arduino.h>
+#include "hal.h"
+#include "asr6501sim.h"
+
+
+int main(int argc, char **argv) {
+    const char *trace = NULL, *adapter = NULL;
+    unsigned long runSecs = 0;
+    bool loopTrace = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:ls:r:a:")) != -1) {
+        switch (opt) {
+            case 't': trace = optarg; break;
+            case 'l': loopTrace = true; break;
+            case 's': hal::setTimeScale(atof(optarg)); break;
+            case 'r': runSecs = strtoul(optarg, NULL, 10); break;
+            case 'a': adapter = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-t trace.csv] [-l] [-s scale] [-r secs] [-a options]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (trace != NULL && !hal::loadTrace(trace, loopTrace)) {
+        fprintf(stderr, "failed to load trace %s\n", trace);
+        return 1;
+    }
+
+    if (adapter != NULL) {
+        static hal::ASR6501Simulator asr6501;
+        if (!asr6501.configure(adapter)) {
+            fprintf(stderr, "invalid adapter options %s\n", adapter);
+            return 1;
+        }
+        hal::setSerial2(&asr6501);
+    }
+
+    setup();
+    while (runSecs == 0 || millis() < runSecs * 1000) {
+        loop();
+        delay(1);  // loop() is called back-to-back on the ESP32, avoid busy loop
+    }
+    return 0;
+}
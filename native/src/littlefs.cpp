@@ -0,0 +1,279 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <LittleFS.h>
+
+#define LITTLEFS_SIZE (1536 * 1024)
+
+fs::LittleFSFS LittleFS;
+
+namespace fs {
+
+struct FileImpl {
+    ~FileImpl() { this->close(); }
+    void close() {
+        if (this->file != NULL)
+            fclose(this->file);
+        if (this->dir != NULL)
+            closedir(this->dir);
+        this->file = NULL;
+        this->dir = NULL;
+    }
+    FILE *file = NULL;
+    DIR *dir = NULL;
+    std::string path;  // path on LittleFS
+    std::string host;  // path on host
+    std::string name;
+};
+
+
+static std::shared_ptr<FileImpl> openImpl(const std::string &path, const std::string &host, const char *mode) {
+    auto impl = std::make_shared<FileImpl>();
+    struct stat st;
+
+    impl->path = path;
+    impl->host = host;
+    impl->name = path.substr(path.find_last_of('/') + 1);
+    if (stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(host.c_str());
+        if (impl->dir == NULL)
+            return NULL;
+    } else {
+        std::string m = mode;
+        if (m.find('b') == std::string::npos)
+            m += "b";
+        impl->file = fopen(host.c_str(), m.c_str());
+        if (impl->file == NULL)
+            return NULL;
+    }
+    return impl;
+}
+
+
+size_t File::write(uint8_t c) {
+    return this->write(&c, 1);
+}
+
+
+size_t File::write(const uint8_t *buf, size_t len) {
+    if (!this->impl || this->impl->file == NULL)
+        return 0;
+    return fwrite(buf, 1, len, this->impl->file);
+}
+
+
+int File::available() {
+    if (!this->impl || this->impl->file == NULL)
+        return 0;
+    return this->size() - this->position();
+}
+
+
+int File::read() {
+    uint8_t c;
+    return this->read(&c, 1) == 1 ? c : -1;
+}
+
+
+size_t File::read(uint8_t *buf, size_t len) {
+    if (!this->impl || this->impl->file == NULL)
+        return 0;
+    return fread(buf, 1, len, this->impl->file);
+}
+
+
+int File::peek() {
+    int c;
+
+    if (!this->impl || this->impl->file == NULL)
+        return -1;
+    c = fgetc(this->impl->file);
+    if (c != EOF)
+        ungetc(c, this->impl->file);
+    return c == EOF ? -1 : c;
+}
+
+
+void File::flush() {
+    if (this->impl && this->impl->file != NULL)
+        fflush(this->impl->file);
+}
+
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!this->impl || this->impl->file == NULL)
+        return false;
+    return fseek(this->impl->file, pos, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+}
+
+
+size_t File::position() const {
+    if (!this->impl || this->impl->file == NULL)
+        return 0;
+    return ftell(this->impl->file);
+}
+
+
+size_t File::size() const {
+    struct stat st;
+
+    if (!this->impl || this->impl->file == NULL)
+        return 0;
+    fflush(this->impl->file);
+    if (fstat(fileno(this->impl->file), &st) != 0)
+        return 0;
+    return st.st_size;
+}
+
+
+void File::close() {
+    if (this->impl)
+        this->impl->close();
+    this->impl.reset();
+}
+
+
+File::operator bool() const {
+    return this->impl && (this->impl->file != NULL || this->impl->dir != NULL);
+}
+
+
+const char* File::path() const {
+    return this->impl ? this->impl->path.c_str() : NULL;
+}
+
+
+const char* File::name() const {
+    return this->impl ? this->impl->name.c_str() : NULL;
+}
+
+
+bool File::isDirectory() const {
+    return this->impl && this->impl->dir != NULL;
+}
+
+
+File File::openNextFile(const char *mode) {
+    struct dirent *entry;
+    std::string path;
+
+    if (!this->impl || this->impl->dir == NULL)
+        return File();
+    while ((entry = readdir(this->impl->dir)) != NULL) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+        path = this->impl->path;
+        if (path.empty() || path.back() != '/')
+            path += "/";
+        return File(openImpl(path + entry->d_name, this->impl->host + "/" + entry->d_name, mode));
+    }
+    return File();
+}
+
+
+std::string FS::hostPath(const char *path) {
+    return this->root + (path[0] == '/' ? "" : "/") + path;
+}
+
+
+File FS::open(const char *path, const char *mode, const bool create) {
+    if (this->root.empty())
+        return File();
+    return File(openImpl(path, this->hostPath(path), mode));
+}
+
+
+bool FS::exists(const char *path) {
+    struct stat st;
+    return !this->root.empty() && stat(this->hostPath(path).c_str(), &st) == 0;
+}
+
+
+bool FS::remove(const char *path) {
+    return !this->root.empty() && ::unlink(this->hostPath(path).c_str()) == 0;
+}
+
+
+// replaces an existing target atomically like lfs_rename()
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+    return !this->root.empty() &&
+        ::rename(this->hostPath(pathFrom).c_str(), this->hostPath(pathTo).c_str()) == 0;
+}
+
+
+bool FS::mkdir(const char *path) {
+    return !this->root.empty() && (::mkdir(this->hostPath(path).c_str(), 0755) == 0 || errno == EEXIST);
+}
+
+
+bool FS::rmdir(const char *path) {
+    return !this->root.empty() && ::rmdir(this->hostPath(path).c_str()) == 0;
+}
+
+
+LittleFSFS::LittleFSFS() {}
+
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel) {
+    const char *dir = getenv("NATIVE_FS_DIR");
+
+    this->root = dir ? dir : ".littlefs";
+    if (::mkdir(this->root.c_str(), 0755) != 0 && errno != EEXIST) {
+        this->root.clear();
+        return false;
+    }
+    return true;
+}
+
+
+bool LittleFSFS::format() {
+    std::string cmd = "rm -rf '" + this->root + "'/*";
+    return !this->root.empty() && system(cmd.c_str()) == 0;
+}
+
+
+size_t LittleFSFS::totalBytes() {
+    return LITTLEFS_SIZE;
+}
+
+
+size_t LittleFSFS::usedBytes() {
+    std::string cmd = "du -sb '" + this->root + "' 2>/dev/null";
+    unsigned long used = 0;
+    FILE *p;
+
+    if (this->root.empty() || (p = popen(cmd.c_str(), "r")) == NULL)
+        return 0;
+    if (fscanf(p, "%lu", &used) != 1)
+        used = 0;
+    pclose(p);
+    return used;
+}
+
+
+void LittleFSFS::end() {
+    this->root.clear();
+}
+
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <M5Tough.h>
+#include "hal.h"
+
+M5Tough M5;
+TwoWire Wire(0);
+TwoWire Wire1(1);
+
+const GFXfont FreeSans9pt7b = { NULL, NULL, 0x20, 0x7E, 22 };
+const GFXfont FreeSans12pt7b = { NULL, NULL, 0x20, 0x7E, 29 };
+const GFXfont FreeSansBold12pt7b = { NULL, NULL, 0x20, 0x7E, 29 };
+const GFXfont FreeSansBold24pt7b = { NULL, NULL, 0x20, 0x7E, 56 };
+
+
+void M5Tough::begin(bool lcdEnable, bool sdEnable, bool serialEnable, bool i2cEnable, mbus_mode_t mode) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+
+// collects printed text until the cursor is moved or a line break is written
+size_t M5Display::write(uint8_t c) {
+    if (c == '\n' || c == '\r') {
+        this->flushLine();
+    } else if (this->len < sizeof(this->line) - 1) {
+        this->line[this->len++] = c;
+        this->line[this->len] = 0;
+    }
+    return 1;
+}
+
+
+size_t M5Display::write(const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        this->write(buf[i]);
+    this->flushLine();
+    return len;
+}
+
+
+void M5Display::flushLine() {
+    if (this->len > 0)
+        hal::display().text(this->x, this->y, this->line);
+    this->x += this->len * 12;  // rough estimate for getCursorX()
+    this->len = 0;
+    this->line[0] = 0;
+}
+
+
+void M5Display::clearDisplay(uint16_t color) {
+    this->x = this->y = 0;
+    hal::display().clear(color);
+}
+
+
+int16_t M5Display::drawString(const char *str, int32_t x, int32_t y, uint8_t font) {
+    hal::display().text(x, y, str);
+    return strlen(str) * 12;
+}
+
+
+float AXP192::GetBatVoltage() {
+    return hal::power().batteryVoltage();
+}
+
+
+float AXP192::GetBatteryLevel() {
+    return hal::power().batteryLevel();
+}
+
+
+float AXP192::GetVinVoltage() {
+    return hal::power().vinVoltage();
+}
+
+
+bool AXP192::isCharging() {
+    return hal::power().charging();
+}
+
+
+void AXP192::DeepSleep(uint64_t us) {
+    hal::power().deepSleep(us);
+}
+
+
+// the RTC keeps the host's UTC time
+void RTC::GetTime(RTC_TimeTypeDef *rtcTime) {
+    time_t now = time(NULL);
+    struct tm *tm = gmtime(&now);
+    rtcTime->Hours = tm->tm_hour;
+    rtcTime->Minutes = tm->tm_min;
+    rtcTime->Seconds = tm->tm_sec;
+}
+
+
+void RTC::GetDate(RTC_DateTypeDef *rtcDate) {
+    time_t now = time(NULL);
+    struct tm *tm = gmtime(&now);
+    rtcDate->WeekDay = tm->tm_wday;
+    rtcDate->Month = tm->tm_mon + 1;
+    rtcDate->Date = tm->tm_mday;
+    rtcDate->Year = tm->tm_year + 1900;
+}
+
+
+void RTC::SetTime(RTC_TimeTypeDef *rtcTime) {}
+
+
+void RTC::SetDate(RTC_DateTypeDef *rtcDate) {}
+
+
+// SystemTime::set() must not change the host's clock
+extern "C" int settimeofday(const struct timeval *tv, const void *tz) {
+    return 0;
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <vector>
+#include <Preferences.h>
+#include "hal.h"
+
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition) {
+    strlcpy(this->name, name, sizeof(this->name));
+    this->readOnly = readOnly;
+    this->started = true;
+    return true;
+}
+
+
+void Preferences::end() {
+    this->started = false;
+}
+
+
+bool Preferences::clear() {
+    if (!this->started || this->readOnly)
+        return false;
+    return hal::storage().clear(this->name);
+}
+
+
+bool Preferences::remove(const char *key) {
+    if (!this->started || this->readOnly)
+        return false;
+    return hal::storage().remove(this->name, key);
+}
+
+
+bool Preferences::isKey(const char *key) {
+    std::vector<uint8_t> value;
+    return this->started && hal::storage().load(this->name, key, value);
+}
+
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+    if (!this->started || this->readOnly)
+        return 0;
+    return hal::storage().store(this->name, key, (const uint8_t*)value, len) ? len : 0;
+}
+
+
+size_t Preferences::getBytesLength(const char *key) {
+    std::vector<uint8_t> value;
+
+    if (!this->started || !hal::storage().load(this->name, key, value))
+        return 0;
+    return value.size();
+}
+
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+    std::vector<uint8_t> value;
+
+    if (!this->started || !hal::storage().load(this->name, key, value) || value.size() > maxLen)
+        return 0;
+    memcpy(buf, value.data(), value.size());
+    return value.size();
+}
+
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen) {
+    size_t len = this->getBytes(key, value, maxLen);
+    if (len == 0 && maxLen > 0)
+        value[0] = 0;
+    return len;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+// WiFiManager/WiFi station handling (wlan.cpp) and the NimBLE GATT
+// server (ble.cpp) depend on the ESP32 radio stack and are replaced
+// by these stubs in the host-native build
+
+#include "wlan.h"
+#include "ble.h"
+
+WLAN WifiUplink;
+GATTServer GATT;
+
+
+void WLAN::begin() {
+    this->wifiReconnectSuccess = 0;
+    this->wifiReconnectFail = 0;
+    this->connectionTaskHandle = NULL;
+    Serial.printf("WiFi: connected to SSID %s (RSSI %d dbm)\n", WiFi.SSID().c_str(), WiFi.RSSI());
+}
+
+
+WLAN::~WLAN() {}
+
+
+GATTServer::GATTServer() {
+    this->pServer = NULL;
+    this->busId = -1;
+    this->notifyTaskHandle = NULL;
+}
+
+
+GATTServer::~GATTServer() {}
+
+
+bool GATTServer::begin() {
+    Serial.println("BLE: not available in native build");
+    return false;
+}
+
+
+void GATTServer::notify(sensorReadings_t data) {}
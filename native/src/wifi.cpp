@@ -0,0 +1,173 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+#include <WiFi.h>
+#include "hal.h"
+
+WiFiClass WiFi;
+
+
+bool WiFiClass::isConnected() {
+    return hal::network().connected();
+}
+
+
+int8_t WiFiClass::RSSI() {
+    return hal::network().rssi();
+}
+
+
+String WiFiClass::SSID() {
+    return String(hal::network().ssid());
+}
+
+
+IPAddress WiFiClass::localIP() {
+    return this->isConnected() ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+
+int WiFiClass::hostByName(const char *host, IPAddress &result) {
+    struct addrinfo hints, *res;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0)
+        return 0;
+    result = IPAddress(((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(res);
+    return 1;
+}
+
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    struct sockaddr_in addr;
+    int flag = 1;
+
+    if (!WiFi.isConnected())
+        return 0;
+    this->stop();
+    if ((this->fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+        return 0;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    if (::connect(this->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        this->stop();
+        return 0;
+    }
+    setsockopt(this->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    return 1;
+}
+
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+    IPAddress ip;
+
+    if (!WiFi.hostByName(host, ip))
+        return 0;
+    return this->connect(ip, port);
+}
+
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size) {
+    ssize_t n;
+
+    if (this->fd < 0)
+        return 0;
+    if ((n = send(this->fd, buf, size, MSG_NOSIGNAL)) < 0) {
+        this->stop();
+        return 0;
+    }
+    return n;
+}
+
+
+int WiFiClient::available() {
+    int n = 0;
+
+    if (this->fd < 0 || ioctl(this->fd, FIONREAD, &n) < 0)
+        return 0;
+    return n;
+}
+
+
+int WiFiClient::read() {
+    uint8_t c;
+    return this->read(&c, 1) == 1 ? c : -1;
+}
+
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+    ssize_t n;
+
+    if (this->fd < 0 || !this->available())
+        return -1;
+    if ((n = recv(this->fd, buf, size, MSG_DONTWAIT)) <= 0) {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            this->stop();
+        return -1;
+    }
+    return n;
+}
+
+
+int WiFiClient::peek() {
+    uint8_t c;
+
+    if (this->fd < 0 || recv(this->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1)
+        return -1;
+    return c;
+}
+
+
+void WiFiClient::stop() {
+    if (this->fd >= 0)
+        close(this->fd);
+    this->fd = -1;
+}
+
+
+// connection is alive if the peer hasn't closed the socket
+uint8_t WiFiClient::connected() {
+    uint8_t c;
+    ssize_t n;
+
+    if (this->fd < 0)
+        return 0;
+    if (!WiFi.isConnected()) {
+        this->stop();
+        return 0;
+    }
+    n = recv(this->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        this->stop();
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,191 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+#include "ackclient.h"
+
+#define MQTT_PUBLISH_QOS1 0x32
+#define MQTT_PUBLISH_DUP 0x08
+#define MQTT_PUBACK 0x40
+
+enum { PARSE_HEADER, PARSE_LENGTH, PARSE_BODY };
+
+
+AckClient::AckClient(Client &client) : client(client) {
+    this->reset();
+}
+
+
+void AckClient::reset() {
+    this->state = PARSE_HEADER;
+    this->header = 0;
+    this->lengthShift = 0;
+    this->remaining = 0;
+    this->packetId = 0;
+    this->ackHead = 0;
+    this->ackCount = 0;
+}
+
+
+// follow MQTT packet boundaries of received data and queue
+// packet ids of PUBACKs along with the time of arrival
+void AckClient::parse(uint8_t c) {
+    switch (this->state) {
+        case PARSE_HEADER:
+            this->header = c;
+            this->remaining = 0;
+            this->lengthShift = 0;
+            this->packetId = 0;
+            this->state = PARSE_LENGTH;
+            break;
+        case PARSE_LENGTH:
+            this->remaining |= (uint32_t)(c & 0x7F) << this->lengthShift;
+            this->lengthShift += 7;
+            if (!(c & 0x80))
+                this->state = this->remaining > 0 ? PARSE_BODY : PARSE_HEADER;
+            break;
+        case PARSE_BODY:
+            if ((this->header & 0xF0) == MQTT_PUBACK)
+                this->packetId = (this->packetId << 8) | c;
+            if (--this->remaining > 0)
+                break;
+            this->state = PARSE_HEADER;
+            if ((this->header & 0xF0) != MQTT_PUBACK)
+                break;
+            if (this->ackCount == ACK_QUEUE_SIZE) {  // overwrite oldest
+                this->ackHead = (this->ackHead + 1) % ACK_QUEUE_SIZE;
+                this->ackCount--;
+            }
+            this->ackIds[(this->ackHead + this->ackCount) % ACK_QUEUE_SIZE] = this->packetId;
+            this->ackTimes[(this->ackHead + this->ackCount) % ACK_QUEUE_SIZE] = millis();
+            this->ackCount++;
+            break;
+    }
+}
+
+
+// send fixed and variable header of a QoS 1 PUBLISH packet,
+// payload with given length has to be written afterwards
+bool AckClient::beginPublish(const char *topic, uint16_t packetId, size_t length, bool duplicate) {
+    uint8_t header[5 + 2 + ACK_TOPIC_MAX + 2];
+    size_t topicLen = strlen(topic);
+    uint32_t remaining = 2 + topicLen + 2 + length;
+    uint8_t pos = 0;
+
+    if (topicLen > ACK_TOPIC_MAX || packetId == 0)
+        return false;
+
+    header[pos++] = MQTT_PUBLISH_QOS1 | (duplicate ? MQTT_PUBLISH_DUP : 0);
+    do {
+        header[pos] = remaining & 0x7F;
+        remaining >>= 7;
+        if (remaining > 0)
+            header[pos] |= 0x80;
+        pos++;
+    } while (remaining > 0);
+    header[pos++] = topicLen >> 8;
+    header[pos++] = topicLen & 0xFF;
+    memcpy(header + pos, topic, topicLen);
+    pos += topicLen;
+    header[pos++] = packetId >> 8;
+    header[pos++] = packetId & 0xFF;
+
+    return this->client.write(header, pos) == pos;
+}
+
+
+// returns true and oldest received acknowledgement if available
+bool AckClient::nextAck(uint16_t *packetId, uint32_t *ackTime) {
+    if (this->ackCount == 0)
+        return false;
+    *packetId = this->ackIds[this->ackHead];
+    *ackTime = this->ackTimes[this->ackHead];
+    this->ackHead = (this->ackHead + 1) % ACK_QUEUE_SIZE;
+    this->ackCount--;
+    return true;
+}
+
+
+int AckClient::connect(IPAddress ip, uint16_t port) {
+    this->reset();
+    return this->client.connect(ip, port);
+}
+
+
+int AckClient::connect(const char *host, uint16_t port) {
+    this->reset();
+    return this->client.connect(host, port);
+}
+
+
+size_t AckClient::write(uint8_t c) {
+    return this->client.write(c);
+}
+
+
+size_t AckClient::write(const uint8_t *buf, size_t size) {
+    return this->client.write(buf, size);
+}
+
+
+int AckClient::available() {
+    return this->client.available();
+}
+
+
+int AckClient::read() {
+    int c = this->client.read();
+
+    if (c >= 0)
+        this->parse(c);
+    return c;
+}
+
+
+int AckClient::read(uint8_t *buf, size_t size) {
+    int len = this->client.read(buf, size);
+
+    for (int i = 0; i < len; i++)
+        this->parse(buf[i]);
+    return len;
+}
+
+
+int AckClient::peek() {
+    return this->client.peek();
+}
+
+
+void AckClient::flush() {
+    this->client.flush();
+}
+
+
+void AckClient::stop() {
+    this->client.stop();
+}
+
+
+uint8_t AckClient::connected() {
+    return this->client.connected();
+}
+
+
+AckClient::operator bool() {
+    return this->client;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "airtime.h"
+
+#define LORA_PREAMBLE_SYMBOLS 8
+#define LORA_CODING_RATE 1  // 4/5
+
+static const uint8_t maxPayload[] = { 51, 51, 51, 115, 222, 222 };
+
+
+// see Semtech AN1200.13 "LoRa Modem Designer's Guide", explicit header and
+// CRC enabled, low data rate optimization is mandatory for SF11 and SF12
+uint32_t loraAirtimeMs(uint8_t dataRate, uint8_t payloadLen) {
+    uint8_t sf = 12 - min(dataRate, (uint8_t)LORAWAN_MAX_DR);
+    uint8_t de = (sf >= 11) ? 1 : 0;
+    uint32_t symbolUs = (1UL << sf) * 8;  // 2^SF / 125 kHz
+    int32_t bits = 8 * (payloadLen + LORAWAN_PHY_OVERHEAD) - 4 * sf + 28 + 16;
+    uint32_t denom = 4 * (sf - 2 * de);
+    uint32_t symbols = 8;
+
+    if (bits > 0)
+        symbols += ((bits + denom - 1) / denom) * (LORA_CODING_RATE + 4);
+    // preamble plus 4.25 symbols sync word
+    return (symbols * symbolUs + (LORA_PREAMBLE_SYMBOLS * 4 + 17) * symbolUs / 4 + 999) / 1000;
+}
+
+
+uint8_t loraMaxPayload(uint8_t dataRate) {
+    return maxPayload[min(dataRate, (uint8_t)LORAWAN_MAX_DR)];
+}
+
+
+// bucket starts full, i.e. the device is assumed to have been silent before
+DutyCycle::DutyCycle(uint16_t permille, uint32_t capacityMs) {
+    this->permille = permille;
+    this->capacity = (uint64_t)capacityMs * 1000;
+    this->tokens = this->capacity;
+    this->lastRefill = 0;
+}
+
+
+// returns true and takes airtime from bucket if enough is left
+bool DutyCycle::consume(uint32_t airtimeMs) {
+    this->refill();
+    if (this->tokens < (uint64_t)airtimeMs * 1000)
+        return false;
+    this->tokens -= (uint64_t)airtimeMs * 1000;
+    return true;
+}
+
+
+// returns airtime in ms currently left in bucket
+uint32_t DutyCycle::available() {
+    this->refill();
+    return this->tokens / 1000;
+}
+
+
+// returns ms until bucket holds enough airtime for an uplink
+uint32_t DutyCycle::waitMs(uint32_t airtimeMs) {
+    uint64_t needed = (uint64_t)airtimeMs * 1000;
+
+    this->refill();
+    if (this->tokens >= needed)
+        return 0;
+    return (needed - this->tokens + this->permille - 1) / this->permille;
+}
+
+
+void DutyCycle::refill() {
+    uint32_t now = millis();
+
+    this->tokens = min(this->tokens + (uint64_t)(now - this->lastRefill) * this->permille, this->capacity);
+    this->lastRefill = now;
+}
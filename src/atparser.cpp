@@ -0,0 +1,222 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+#include "atparser.h"
+
+
+ATParser::ATParser() {
+    this->serial = NULL;
+    this->rxTaskHandle = NULL;
+    this->cmdLock = NULL;
+    this->stateLock = NULL;
+    this->done = NULL;
+    this->handlerCount = 0;
+    this->lineLen = 0;
+    this->pending = false;
+    this->resp = NULL;
+}
+
+
+ATParser::~ATParser() {
+    this->end();
+}
+
+
+// start parser task, which is woken up by the UART's receive events
+bool ATParser::begin(HardwareSerial *serial) {
+    if (this->rxTaskHandle != NULL)
+        return true;
+
+    this->serial = serial;
+    this->cmdLock = xSemaphoreCreateMutex();
+    this->stateLock = xSemaphoreCreateMutex();
+    this->done = xSemaphoreCreateBinary();
+    if (this->cmdLock == NULL || this->stateLock == NULL || this->done == NULL)
+        return false;
+
+    xTaskCreatePinnedToCore(this->rxTaskWrapper, "atTask", 3072, this, 11, &this->rxTaskHandle, 1);
+    if (this->rxTaskHandle == NULL)
+        return false;
+    this->serial->onReceive([this]() { xTaskNotifyGive(this->rxTaskHandle); });
+    return true;
+}
+
+
+void ATParser::end() {
+    if (this->serial != NULL)
+        this->serial->onReceive(NULL);
+    if (this->rxTaskHandle != NULL)
+        vTaskDelete(this->rxTaskHandle);
+    if (this->cmdLock != NULL)
+        vSemaphoreDelete(this->cmdLock);
+    if (this->stateLock != NULL)
+        vSemaphoreDelete(this->stateLock);
+    if (this->done != NULL)
+        vSemaphoreDelete(this->done);
+    this->rxTaskHandle = NULL;
+    this->cmdLock = this->stateLock = this->done = NULL;
+    this->serial = NULL;
+}
+
+
+// register handler for unsolicited lines starting with given prefix,
+// handlers are called from the parser task and should return quickly
+bool ATParser::onURC(const char *prefix, urcHandler_t handler, void *arg) {
+    if (this->handlerCount >= AT_MAX_HANDLERS)
+        return false;
+    this->handlers[this->handlerCount].prefix = prefix;
+    this->handlers[this->handlerCount].handler = handler;
+    this->handlers[this->handlerCount].arg = arg;
+    this->handlerCount++;
+    return true;
+}
+
+
+// send command and wait for its final result, response lines (including
+// the final one) are copied space separated to 'resp' if not NULL
+atResult ATParser::command(const char *cmd, char *resp, size_t size, uint16_t timeout) {
+    atResult result;
+    size_t len = 0;
+
+    if (this->rxTaskHandle == NULL)
+        return AT_ERROR;
+    if (xSemaphoreTake(this->cmdLock, AT_LOCK_TIMEOUT_MS/portTICK_PERIOD_MS) != pdTRUE)
+        return AT_BUSY;
+
+    xSemaphoreTake(this->stateLock, portMAX_DELAY);
+    // response lines start with the command's name, e.g. '+CGMI' for 'AT+CGMI?'
+    if (!strncmp(cmd, "AT+", 3))
+        len = min(strcspn(cmd + 2, "=?"), sizeof(this->prefix) - 1);
+    memcpy(this->prefix, cmd + 2, len);
+    this->prefix[len] = '\0';
+    this->resp = (size > 0) ? resp : NULL;
+    this->respSize = size;
+    this->respLen = 0;
+    if (this->resp != NULL)
+        this->resp[0] = '\0';
+    this->result = AT_TIMEOUT;
+    this->pending = true;
+    xSemaphoreTake(this->done, 0);  // clear completion of a timed out command
+    xSemaphoreGive(this->stateLock);
+
+    this->serial->print(cmd);
+    this->serial->print("\r\n");
+    xSemaphoreTake(this->done, timeout/portTICK_PERIOD_MS);
+
+    xSemaphoreTake(this->stateLock, portMAX_DELAY);
+    this->pending = false;
+    this->resp = NULL;
+    result = this->result;
+    xSemaphoreGive(this->stateLock);
+    xSemaphoreGive(this->cmdLock);
+
+    return result;
+}
+
+
+// 'OK+SEND' completes AT+DTRX, whereas 'OK+SENT' and 'OK+RECV'
+// are sent unsolicited after the uplink's receive windows
+bool ATParser::finalResult(const char *line, atResult *result) {
+    if (!strcmp(line, "OK") || !strncmp(line, "OK+SEND", 7)) {
+        *result = AT_OK;
+        return true;
+    } else if (!strcmp(line, "ERROR") || !strncmp(line, "+CME ERROR", 10) ||
+            !strncmp(line, "ERR+SEND", 8)) {
+        *result = AT_ERROR;
+        return true;
+    }
+    return false;
+}
+
+
+// lines starting with the pending command's name and plain text (e.g. version
+// strings) belong to its response, URCs start with '+', 'OK+' or 'ERR+'
+bool ATParser::responseLine(const char *line) {
+    if (this->prefix[0] != '\0' && !strncmp(line, this->prefix, strlen(this->prefix)))
+        return true;
+    return line[0] != '+' && strncmp(line, "OK+", 3) && strncmp(line, "ERR+", 4);
+}
+
+
+void ATParser::append(const char *line) {
+    if (this->resp == NULL)
+        return;
+    if (this->respLen > 0 && this->respLen < this->respSize - 1)
+        this->resp[this->respLen++] = ' ';
+    this->respLen += strlcpy(this->resp + this->respLen, line, this->respSize - this->respLen);
+    this->respLen = min(this->respLen, this->respSize - 1);
+}
+
+
+void ATParser::parseLine(const char *line) {
+    atResult result;
+
+    xSemaphoreTake(this->stateLock, portMAX_DELAY);
+    if (this->pending) {
+        if (!strncmp(line, "AT", 2)) {  // echo
+            xSemaphoreGive(this->stateLock);
+            return;
+        } else if (this->finalResult(line, &result)) {
+            this->append(line);
+            this->result = result;
+            this->pending = false;
+            xSemaphoreGive(this->stateLock);
+            xSemaphoreGive(this->done);
+            return;
+        } else if (this->responseLine(line)) {
+            this->append(line);
+            xSemaphoreGive(this->stateLock);
+            return;
+        }
+    }
+    xSemaphoreGive(this->stateLock);
+
+    for (uint8_t i = 0; i < this->handlerCount; i++) {
+        if (!strncmp(line, this->handlers[i].prefix, strlen(this->handlers[i].prefix)))
+            this->handlers[i].handler(line, this->handlers[i].arg);
+    }
+}
+
+
+// collects received chars into lines, waits for UART receive events
+// with a short timeout in case an event has been missed
+void ATParser::rxTask() {
+    char c;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, AT_RX_WAIT_MS/portTICK_PERIOD_MS);
+        while (this->serial->available() > 0) {
+            c = this->serial->read();
+            if (c == 10 || c == 13) {  // end of line
+                if (this->lineLen > 0) {
+                    this->line[this->lineLen] = '\0';
+                    this->parseLine(this->line);
+                    this->lineLen = 0;
+                }
+            } else if (c >= 32 && c <= 126 && this->lineLen < sizeof(this->line)-1) {  // only printable chars
+                this->line[this->lineLen++] = c;
+            }
+        }
+    }
+}
+
+
+void ATParser::rxTaskWrapper(void* _this) {
+    static_cast<ATParser*>(_this)->rxTask();
+}
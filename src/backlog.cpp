@@ -0,0 +1,303 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "backlog.h"
+#include "utils.h"
+
+SampleLog Backlog;
+
+
+SampleLog::SampleLog() {
+    this->mounted = false;
+    this->lastSegment = 1;
+    this->lastRecords = 0;
+    this->droppedRecords = 0;
+    this->ack.segment = 1;
+    this->ack.record = 0;
+}
+
+
+// mount LittleFS and restore read and write position of ring log,
+// segments are named after their ascending hex sequence number
+bool SampleLog::begin() {
+    uint32_t segment, minSegment = UINT32_MAX, maxSegment = 0;
+    char path[32], *end;
+    File dir, file;
+
+    if (!LittleFS.begin(true)) {
+        Serial.println("BACKLOG: failed to mount LittleFS, disabled");
+        return false;
+    }
+    LittleFS.mkdir(BACKLOG_DIR);
+
+    dir = LittleFS.open(BACKLOG_DIR);
+    while (dir && (file = dir.openNextFile())) {
+        segment = strtoul(file.name(), &end, 16);
+        if (end != file.name() && !strcmp(end, ".seg")) {
+            minSegment = min(minSegment, segment);
+            maxSegment = max(maxSegment, segment);
+        }
+        file.close();
+    }
+    dir.close();
+
+    if (!this->loadAck()) {
+        this->ack.segment = maxSegment > 0 ? minSegment : 1;
+        this->ack.record = 0;
+    }
+
+    if (maxSegment == 0 || this->ack.segment > maxSegment) {
+        // no readings pending
+        for (segment = minSegment; segment <= maxSegment; segment++) {
+            this->segmentPath(segment, path, sizeof(path));
+            LittleFS.remove(path);
+        }
+        this->ack.record = 0;
+        this->lastSegment = this->ack.segment;
+        this->lastRecords = 0;
+    } else {
+        // remove segments acknowledged before last reset
+        for (segment = minSegment; segment < this->ack.segment; segment++) {
+            this->segmentPath(segment, path, sizeof(path));
+            LittleFS.remove(path);
+        }
+        if (this->ack.segment < minSegment) {
+            this->ack.segment = minSegment;
+            this->ack.record = 0;
+        }
+        this->lastSegment = maxSegment;
+        this->repairSegment(maxSegment);
+        this->lastRecords = this->segmentRecords(maxSegment);
+        if (this->ack.segment == this->lastSegment && this->ack.record > this->lastRecords)
+            this->ack.record = this->lastRecords;
+    }
+
+    this->mounted = true;
+    Serial.printf("BACKLOG: %u readings pending (%u/%u KB used)\n", this->pending(),
+        (uint32_t)(LittleFS.usedBytes()/1024), (uint32_t)(LittleFS.totalBytes()/1024));
+    return true;
+}
+
+
+// append readings to most recent segment, starts a new segment if full
+// and drops the oldest one if the maximum number of segments is exceeded
+bool SampleLog::append(const sensorReadings_t *data) {
+    backlogRecord_t record;
+    char path[32];
+    bool success;
+    File file;
+
+    if (!this->mounted)
+        return false;
+
+    if (this->lastRecords >= BACKLOG_SEGMENT_RECORDS) {
+        this->lastSegment++;
+        this->lastRecords = 0;
+        if ((this->lastSegment - this->ack.segment) >= BACKLOG_MAX_SEGMENTS) {
+            this->droppedRecords += BACKLOG_SEGMENT_RECORDS - this->ack.record;
+            Serial.printf("BACKLOG: full, dropped %u readings\n", BACKLOG_SEGMENT_RECORDS - this->ack.record);
+            this->segmentPath(this->ack.segment, path, sizeof(path));
+            this->ack.segment++;
+            this->ack.record = 0;
+            this->storeAck();
+            LittleFS.remove(path);
+        }
+    }
+
+    record.magic = BACKLOG_RECORD_MAGIC;
+    record.length = sizeof(sensorReadings_t);
+    record.data = *data;
+    record.crc = calcCRC32(&record.data, sizeof(sensorReadings_t));
+
+    this->segmentPath(this->lastSegment, path, sizeof(path));
+    file = LittleFS.open(path, FILE_APPEND);
+    if (!file)
+        return false;
+    success = (file.write((uint8_t*)&record, sizeof(record)) == sizeof(record));
+    file.close();
+
+    if (success)
+        this->lastRecords++;
+    else
+        this->repairSegment(this->lastSegment);
+    return success;
+}
+
+
+// read pending readings at given index (0 is oldest), returns
+// false if out of range or if record is corrupted
+bool SampleLog::read(uint32_t index, sensorReadings_t *data) {
+    backlogRecord_t record;
+    uint32_t pos;
+    char path[32];
+    size_t len = 0;
+    File file;
+
+    if (!this->mounted || index >= this->pending())
+        return false;
+
+    pos = this->ack.record + index;
+    this->segmentPath(this->ack.segment + pos / BACKLOG_SEGMENT_RECORDS, path, sizeof(path));
+    file = LittleFS.open(path, FILE_READ);
+    if (file) {
+        if (file.seek((pos % BACKLOG_SEGMENT_RECORDS) * sizeof(record)))
+            len = file.read((uint8_t*)&record, sizeof(record));
+        file.close();
+    }
+
+    if (len != sizeof(record) || record.magic != BACKLOG_RECORD_MAGIC ||
+            record.length != sizeof(sensorReadings_t) ||
+            record.crc != calcCRC32(&record.data, sizeof(sensorReadings_t))) {
+        Serial.printf("BACKLOG: skipping corrupted record in %s\n", path);
+        return false;
+    }
+    *data = record.data;
+    return true;
+}
+
+
+// mark oldest readings as acknowledged, segments are
+// deleted after the new position has been stored
+void SampleLog::release(uint32_t count) {
+    uint32_t segment = this->ack.segment;
+    char path[32];
+
+    if (!this->mounted || count == 0)
+        return;
+
+    count = min(count, this->pending());
+    this->ack.record += count;
+    this->ack.segment += this->ack.record / BACKLOG_SEGMENT_RECORDS;
+    this->ack.record %= BACKLOG_SEGMENT_RECORDS;
+    if (this->ack.segment > this->lastSegment) {
+        this->lastSegment = this->ack.segment;
+        this->lastRecords = 0;
+    }
+    this->storeAck();
+
+    for (; segment < this->ack.segment; segment++) {
+        this->segmentPath(segment, path, sizeof(path));
+        LittleFS.remove(path);
+    }
+}
+
+
+// returns number of readings not acknowledged yet
+uint32_t SampleLog::pending() {
+    if (!this->mounted)
+        return 0;
+    return (this->lastSegment - this->ack.segment) * BACKLOG_SEGMENT_RECORDS
+        + this->lastRecords - this->ack.record;
+}
+
+
+// returns number of readings lost since the log was full
+uint32_t SampleLog::dropped() {
+    return this->droppedRecords;
+}
+
+
+void SampleLog::segmentPath(uint32_t segment, char *path, size_t len) {
+    snprintf(path, len, "%s/%08x.seg", BACKLOG_DIR, segment);
+}
+
+
+uint32_t SampleLog::segmentRecords(uint32_t segment) {
+    uint32_t records = 0;
+    char path[32];
+    File file;
+
+    this->segmentPath(segment, path, sizeof(path));
+    file = LittleFS.open(path, FILE_READ);
+    if (file) {
+        records = file.size() / sizeof(backlogRecord_t);
+        file.close();
+    }
+    return records;
+}
+
+
+// remove incomplete record at the end of a segment (power loss
+// or reset while writing) by copying all complete records
+void SampleLog::repairSegment(uint32_t segment) {
+    backlogRecord_t record;
+    char path[32], tmpPath[36];
+    uint32_t records;
+    File src, dst;
+
+    this->segmentPath(segment, path, sizeof(path));
+    src = LittleFS.open(path, FILE_READ);
+    if (!src)
+        return;
+    if ((src.size() % sizeof(record)) == 0) {
+        src.close();
+        return;
+    }
+
+    Serial.printf("BACKLOG: removing incomplete record from %s\n", path);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    records = src.size() / sizeof(record);
+    dst = LittleFS.open(tmpPath, FILE_WRITE);
+    while (dst && records--) {
+        if (src.read((uint8_t*)&record, sizeof(record)) != sizeof(record) ||
+                dst.write((uint8_t*)&record, sizeof(record)) != sizeof(record))
+            break;
+    }
+    src.close();
+    if (dst) {
+        dst.close();
+        LittleFS.rename(tmpPath, path);
+    }
+}
+
+
+// write acknowledged position to temporary file and replace the
+// previous one, rename is atomic on LittleFS
+bool SampleLog::storeAck() {
+    bool success;
+    File file;
+
+    this->ack.crc = calcCRC32(&this->ack, offsetof(backlogAck_t, crc));
+    file = LittleFS.open(BACKLOG_ACK_FILE ".tmp", FILE_WRITE);
+    if (!file)
+        return false;
+    success = (file.write((uint8_t*)&this->ack, sizeof(this->ack)) == sizeof(this->ack));
+    file.close();
+    return success && LittleFS.rename(BACKLOG_ACK_FILE ".tmp", BACKLOG_ACK_FILE);
+}
+
+
+bool SampleLog::loadAck() {
+    backlogAck_t stored;
+    size_t len = 0;
+    File file;
+
+    if (!LittleFS.exists(BACKLOG_ACK_FILE))
+        return false;
+    file = LittleFS.open(BACKLOG_ACK_FILE, FILE_READ);
+    if (file) {
+        len = file.read((uint8_t*)&stored, sizeof(stored));
+        file.close();
+    }
+    if (len != sizeof(stored) || stored.crc != calcCRC32(&stored, offsetof(backlogAck_t, crc)))
+        return false;
+    this->ack = stored;
+    return true;
+}
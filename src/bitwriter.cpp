@@ -0,0 +1,76 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "bitwriter.h"
+
+
+BitWriter::BitWriter(uint8_t *buf, size_t size) {
+    this->buf = buf;
+    this->size = size;
+    this->reset();
+}
+
+
+void BitWriter::reset() {
+    this->bitLen = 0;
+    this->overflow = false;
+}
+
+
+// write the lower 'bits' bits of value (up to 32)
+void BitWriter::put(uint32_t value, uint8_t bits) {
+    size_t pos;
+
+    while (bits-- > 0) {
+        pos = this->bitLen >> 3;
+        if (pos >= this->size) {
+            this->overflow = true;
+            return;
+        }
+        if ((this->bitLen & 7) == 0)
+            this->buf[pos] = 0;
+        if ((value >> bits) & 1)
+            this->buf[pos] |= 0x80 >> (this->bitLen & 7);
+        this->bitLen++;
+    }
+}
+
+
+// write value as two's complement, value must fit into 'bits' bits
+void BitWriter::putSigned(int32_t value, uint8_t bits) {
+    this->put((uint32_t)value, bits);
+}
+
+
+// returns number of bits written so far
+size_t BitWriter::bits() {
+    return this->bitLen;
+}
+
+
+// returns number of bytes written so far, including a partial last byte
+size_t BitWriter::length() {
+    return (this->bitLen + 7) >> 3;
+}
+
+
+bool BitWriter::overflowed() {
+    return this->overflow;
+}
@@ -31,12 +31,18 @@ GATTServer GATT;
 
 GATTServer::GATTServer() {
     this->pServer = NULL;
+    this->busId = -1;
+    this->notifyTaskHandle = NULL;
     snprintf(this->bleServerName, sizeof(this->bleServerName),
-        "%s-%s", WIFI_PORTAL_SSID, getSystemID().c_str());
+        "%s-%s", WIFI_PORTAL_SSID, getSystemID());
 }
 
 
 GATTServer::~GATTServer() {
+    if (this->notifyTaskHandle != NULL)
+        vTaskDelete(this->notifyTaskHandle);
+    Bus.unsubscribe(this->busId);
+    this->busId = -1;
     if (this->pServer != NULL) {
         this->pServer->stopAdvertising();
         this->pServer->removeService(this->environmentalService);
@@ -112,6 +118,9 @@ bool GATTServer::begin() {
 
     // environmental service
     this->environmentalService = this->pServer->createService(BLE_ENVIRONMENTAL_SERVICE_UUID);
+    this->sampleCharacteristic = this->environmentalService->createCharacteristic(BLE_SAMPLE_UUID, BLE_PROP_NOTIFY_READ);
+    desc = this->sampleCharacteristic->createDescriptor(BLE_USER_DESC_UUID, BLE_PROP_READ, 48);
+    desc->setValue("Timestamp (UTC ms, uint64) and sequence (uint32)");
     if (mlx90614.status() || bme680.status()) {
         this->tempCharacteristic = this->environmentalService->createCharacteristic(BLE_TEMPERATURE_UUID, BLE_PROP_NOTIFY_READ);
         desc = this->tempCharacteristic->createDescriptor(BLE_USER_DESC_UUID, BLE_PROP_READ, 32);
@@ -154,6 +163,12 @@ bool GATTServer::begin() {
     this->pAdvertising->setScanResponse(true);
     this->pAdvertising->setMinPreferred(0x06); // iPhone fix?
     this->pServer->getAdvertising()->start();
+
+    // notifications are sent from a separate task to keep the main loop responsive
+    this->busId = Bus.subscribe("gatt", 1, LATEST_ONLY);
+    if (this->busId >= 0)
+        xTaskCreatePinnedToCore(this->notifyTaskWrapper,
+            "gattTask", 2048, this, 5, &this->notifyTaskHandle, 1);
     M5.Lcd.print("OK");
     Serial.println("BLE: GATT server ready, waiting for clients to connect");
     delay(1500);
@@ -164,6 +179,7 @@ bool GATTServer::begin() {
 void GATTServer::notify(sensorReadings_t data) {
     uint16_t hum;
     uint32_t runtime = SysTime.getRuntimeMinutes();
+    uint8_t sample[12];
 
     if (!prefs.bleServer || !this->pServer->getConnectedCount())
         return;
@@ -199,6 +215,33 @@ void GATTServer::notify(sensorReadings_t data) {
         delay(10);
         this->iaqCharacteristic->setValue(data.bme680Iaq);
         this->iaqCharacteristic->notify();
+        delay(10);
     }
+
+    // sent last, clients can assign the preceding notifications to this sample
+    for (uint8_t i = 0; i < 8; i++)
+        sample[i] = (data.timestamp >> (i * 8)) & 0xFF;  // little endian
+    for (uint8_t i = 0; i < 4; i++)
+        sample[8 + i] = (data.sequence >> (i * 8)) & 0xFF;
+    this->sampleCharacteristic->setValue(sample, sizeof(sample));
+    this->sampleCharacteristic->notify();
     Serial.println("BLE: sending sensor readings");
+}
+
+
+// background task waiting for new sensor readings to notify connected clients
+void GATTServer::notifyTask() {
+    sensorReadings_t data;
+
+    while (true) {
+        if (Bus.receive(this->busId, &data, 1000/portTICK_PERIOD_MS))
+            this->notify(data);
+        if (lowBattery)
+            vTaskDelete(NULL);
+    }
+}
+
+
+void GATTServer::notifyTaskWrapper(void* _this) {
+    static_cast<GATTServer*>(_this)->notifyTask();
 }
\ No newline at end of file
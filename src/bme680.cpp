@@ -54,10 +54,27 @@ static bsec_virtual_sensor_t sensorList[7] = {
     generic_33v_300s_4d
     generic_33v_300s_28d
 */
-static const uint8_t bsec_config_iaq[] = {
+static const uint8_t bsec_config_lp[] = {
 #include "config/generic_33v_3s_4d/bsec_iaq.txt"  // LP sample rate, 4 days calibration backlog
 };
+static const uint8_t bsec_config_ulp[] = {
+#include "config/generic_33v_300s_4d/bsec_iaq.txt"  // ULP sample rate, 4 days calibration backlog
+};
+static const struct {
+    const char *name;
+    const uint8_t *config;
+    float sampleRate;
+    uint16_t periodSecs;
+} bsecProfiles[2] = {
+    { "LP", bsec_config_lp, BSEC_SAMPLE_RATE_LP, 3 },
+    { "ULP", bsec_config_ulp, BSEC_SAMPLE_RATE_ULP, 300 }
+};
 static bool endButtonWaitLoop = false;
+static bool resetBSEC = false;  // set by eventResetBSEC()
+static std::atomic<bool> stateSaveRequest(false);
+static bsecState_t savedState;  // last state read from or written to NVS
+// upper bounds (ms) of the lateness histogram buckets, last one is open
+static const uint16_t latenessBounds[BME680_LATENESS_BUCKETS-1] = { 1, 5, 10, 50, 100, 500, 1000 };
 
 
 // constructor for BME680 sensor
@@ -65,62 +82,178 @@ BME680::BME680() {
     this->bsec = Bsec();
     this->ready = false;
     this->error = true;
+    this->state = 0;
+    this->profileRequest = BSEC_PROFILE_LP;
+    this->profile = BSEC_PROFILE_LP;
+    memset(this->outputs, 0, sizeof(this->outputs));
+    this->sequence = 0;
+    this->lastRead = 0;
+    memset(this->lateness, 0, sizeof(this->lateness));
+    this->maxLateness = 0;
+    this->violations = 0;
+    this->bsecTaskHandle = NULL;
+}
+
+
+// read BSEC state from NVS slot, false if missing or corrupted
+static bool readStateSlot(uint8_t slot, bsecState_t *record) {
+    char key[16];
+
+    snprintf(key, sizeof(key), BME680_STATE_KEY, slot);
+    if (nvs.getBytesLength(key) != sizeof(bsecState_t) ||
+            nvs.getBytes(key, record, sizeof(bsecState_t)) != sizeof(bsecState_t))
+        return false;
+    return record->crc == calcCRC32(record, offsetof(bsecState_t, crc));
 }
 
 
-void BME680::loadState(Bsec bsec) {
-    uint8_t newState[BSEC_MAX_STATE_BLOB_SIZE] = { 0 };
+// restore most recent valid BSEC state from NVS
+void BME680::loadState(Bsec &bsec) {
+    bsecState_t record;
+    int8_t slot = -1;
 
-    if (prefs.bsecState[0] == BSEC_MAX_STATE_BLOB_SIZE) {
-        Serial.print("BME680: restore BSEC state (");
-        for (uint8_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++) {
-            newState[i] = prefs.bsecState[i+1];
-            Serial.print(newState[i], HEX);
+    memset(&savedState, 0, sizeof(savedState));
+    for (uint8_t i = 0; i < BME680_STATE_SLOTS; i++) {
+        if (readStateSlot(i, &record) && record.counter > savedState.counter) {
+            savedState = record;
+            slot = i;
         }
-        Serial.print(")...");
-        bsec.setState(newState);
+    }
+
+    if (slot >= 0) {
+        Serial.printf("BME680: restore BSEC state (slot %d, write %u, CRC %08X)...",
+            slot, savedState.counter, savedState.crc);
+        bsec.setState(savedState.state);
         if (status(bsec) > 0)
             Serial.println("OK");
     } else {
         Serial.println("BME680: no previously saved BSEC state found");
-        memset(prefs.bsecState, 0, BSEC_MAX_STATE_BLOB_SIZE+1);
-        savePrefs(false);
     }
 }
 
 
+// remove saved BSEC state from all NVS slots, only
+// called from setup() before bsecTask() is started
+void BME680::clearState() {
+    char key[16];
+
+    for (uint8_t i = 0; i < BME680_STATE_SLOTS; i++) {
+        snprintf(key, sizeof(key), BME680_STATE_KEY, i);
+        nvs.remove(key);
+    }
+    memset(&savedState, 0, sizeof(savedState));
+}
+
+
 // Save current BSEC state to flash if IAQ accuracy
-// reaches 3 for the first time or peridically if
-// BME680_STATE_SAVE_PERIOD has passed
-bool BME680::updateState(Bsec bsec) {
-    uint8_t currentState[BSEC_MAX_STATE_BLOB_SIZE] = { 0 };
+// reaches 3 for the first time, peridically if
+// BME680_STATE_SAVE_PERIOD has passed or on request,
+// skipped if unchanged, called from bsecTask() only
+bool BME680::updateState(Bsec &bsec) {
     static time_t lastStateUpdate = 0;
+    bool requested = stateSaveRequest.exchange(false);
+    bsecState_t record;
 
-    if ((lastStateUpdate == 0 && readings.bme680IaqAccuracy >= 3) ||
+    if (requested || (lastStateUpdate == 0 && bsec.iaqAccuracy >= 3) ||
         tsDiff(lastStateUpdate) >= BME680_STATE_SAVE_PERIOD) {
 
-        bsec.getState(currentState);
-        if (status(bsec)) {
-            Serial.print("BME680: writing BSEC state to flash (");
-            prefs.bsecState[0] = BSEC_MAX_STATE_BLOB_SIZE;
-            for (uint8_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++) {
-                Serial.print(currentState[i], HEX);
-                prefs.bsecState[i+1] = currentState[i];
-            }
-            Serial.print(")...");
-            savePrefs(false);
-            Serial.println("OK");
-            lastStateUpdate = millis();
-            return true;
-        } else {
+        lastStateUpdate = millis();
+        bsec.getState(record.state);
+        if (!status(bsec)) {
             Serial.println("BME680: failed to read BSEC state");
             return false;
         }
+        if (savedState.counter > 0 && !memcmp(record.state, savedState.state, sizeof(record.state))) {
+            Serial.println("BME680: BSEC state unchanged");
+            return false;
+        }
+        return writeState(record.state);
     }
     return false;
 }
 
 
+// write BSEC state to the older NVS slot, keeps the
+// current one if writing fails
+bool BME680::writeState(const uint8_t *state) {
+    bsecState_t record;
+    uint8_t slot;
+    char key[16];
+
+    memcpy(record.state, state, sizeof(record.state));
+    record.counter = savedState.counter + 1;
+    record.crc = calcCRC32(&record, offsetof(bsecState_t, crc));
+    slot = record.counter % BME680_STATE_SLOTS;
+    snprintf(key, sizeof(key), BME680_STATE_KEY, slot);
+    Serial.printf("BME680: writing BSEC state to flash (slot %u, write %u, CRC %08X)...",
+        slot, record.counter, record.crc);
+    if (nvs.putBytes(key, &record, sizeof(record)) != sizeof(record)) {
+        Serial.println("failed");
+        return false;
+    }
+    savedState = record;
+    Serial.println("OK");
+    return true;
+}
+
+
+// take over BSEC state saved with the settings by an older firmware,
+// called from startPrefs() before setup()
+bool BME680::importState(const uint8_t *state) {
+    memset(&savedState, 0, sizeof(savedState));
+    return writeState(state);
+}
+
+
+// save BSEC state with the next readings, e.g. before a planned
+// power cut, may be called from any task
+void BME680::requestStateSave() {
+    stateSaveRequest = true;
+}
+
+
+// select ULP sampling on battery power or if the battery level is low,
+// LP sampling again on USB power with a recovered battery, called from loop()
+void BME680::checkPower() {
+    float level = 100.0;
+    uint8_t profile = this->profileRequest;
+
+    if (M5.Axp.GetBatVoltage() >= 1.0)  // battery available
+        level = M5.Axp.GetBatteryLevel();
+    if (!usbPowered() || level <= BME680_ULP_BATTERY_LEVEL)
+        profile = BSEC_PROFILE_ULP;
+    else if (level > (BME680_ULP_BATTERY_LEVEL + BME680_ULP_HYSTERESIS))
+        profile = BSEC_PROFILE_LP;
+
+    if (profile != this->profileRequest.exchange(profile) && this->bsecTaskHandle != NULL)
+        xTaskNotifyGive(this->bsecTaskHandle);  // wake up early when leaving ULP
+}
+
+
+// switch BSEC configuration and sample rate, calibration state is
+// carried over, called from setup() or bsecTask() only
+bool BME680::applyProfile(uint8_t profile) {
+    uint8_t currentState[BSEC_MAX_STATE_BLOB_SIZE] = { 0 };
+
+    this->bsec.getState(currentState);
+    if (!status(this->bsec))
+        return false;
+    this->bsec.setConfig(bsecProfiles[profile].config);
+    if (!status(this->bsec))
+        return false;
+    this->bsec.setState(currentState);
+    if (!status(this->bsec))
+        return false;
+    this->bsec.updateSubscription(sensorList, 7, bsecProfiles[profile].sampleRate);
+    if (!status(this->bsec))
+        return false;
+    this->profile = profile;
+    if (profile == BSEC_PROFILE_LP)
+        this->bsec.nextCall = 0;  // don't wait for the rest of a ULP period
+    return true;
+}
+
+
 // catch 'yes' event from dialogResetBSEC()
 void BME680::eventResetBSEC(Event& e) {
     endButtonWaitLoop = true;
@@ -131,8 +264,8 @@ void BME680::eventResetBSEC(Event& e) {
         M5.Lcd.setCursor(20, 40);
         Serial.println("BME680: forcing reset of BSEC calibration data");
         M5.Lcd.print("Reset BSEC data...");
-        prefs.bsecState[0] = 0; // invalidate bsec settings
-        loadState(bme680.bsec);
+        clearState();
+        resetBSEC = true;
         M5.Lcd.print("OK");
         delay(1500);
     }
@@ -143,7 +276,7 @@ void BME680::eventResetBSEC(Event& e) {
 void BME680::dialogResetBSEC() {
     uint16_t timeout = 0;
 
-    if (!prefs.bsecState[0]) // no bsec state data saved so far
+    if (!savedState.counter) // no bsec state data saved so far
         return;
 
     ButtonColors onColor = {RED, WHITE, WHITE};
@@ -170,7 +303,7 @@ void BME680::dialogResetBSEC() {
 
 
 // 0: error, 1: gas sensor warmup, 2: all sensor readings available
-uint8_t BME680::status(Bsec bsec) {
+uint8_t BME680::status(Bsec &bsec) {
     if (bsec.status < BSEC_OK) {
         Serial.printf("BME680: BSEC library error (%d)\n", bsec.status);
         return 0;
@@ -192,9 +325,9 @@ uint8_t BME680::status(Bsec bsec) {
 }
 
 
-// public method for static status() function call
+// status of the last BSEC call, may be called from any task
 uint8_t BME680::status() {
-    return status(this->bsec);
+    return this->state;
 }
 
 
@@ -204,24 +337,35 @@ const char* BME680::accuracy(uint8_t data) {
 }
 
 
-// initialize BME680 sensor (Temp, Hum, Pres, eCO2, VOC) on I2C bus
-bool BME680::setup() {
-    bsec_version_t bsec_version;
-    char statusMsg[64];
-
+// (re)initialize BSEC library with configuration of current profile,
+// optionally restore saved state, returns status(bsec)
+uint8_t BME680::init(bool restore) {
     this->bsec.begin(BME680_I2C_ADDR_PRIMARY, Wire);
-    if (this->status()) {
-        this->bsec.setConfig(bsec_config_iaq);
-        if (!this->status()) {
+    if (status(this->bsec)) {
+        this->bsec.setConfig(bsecProfiles[this->profile].config);
+        if (!status(this->bsec)) {
             Serial.println("ERROR: Failed to set BME680 configuration");
         } else {
-            this->loadState(this->bsec);
-            this->bsec.updateSubscription(sensorList, 7, BSEC_SAMPLE_RATE_LP); // see bsec_config_iaq[]
-            if (!this->status())
+            if (restore)
+                this->loadState(this->bsec);
+            this->bsec.updateSubscription(sensorList, 7, bsecProfiles[this->profile].sampleRate);
+            if (!status(this->bsec))
                 Serial.println("ERROR: Failed to subscribe to BME680 sensors");
         }
     }
-    if (!this->status()) {
+    return status(this->bsec);
+}
+
+
+// initialize BME680 sensor (Temp, Hum, Pres, eCO2, VOC) on I2C bus
+bool BME680::setup() {
+    bsec_version_t bsec_version;
+    char statusMsg[64];
+
+    this->checkPower();
+    this->profile = this->profileRequest;
+    this->state = this->init(true);
+    if (!this->state) {
         snprintf(statusMsg, sizeof(statusMsg), "BME680 failed, error %d", this->bsec.bme680Status);
         displayStatusMsg(statusMsg, 40, false, WHITE, RED);
         Serial.printf("BME680: failed to initialize sensor");
@@ -230,71 +374,166 @@ bool BME680::setup() {
     } else {
         displayStatusMsg("Sensor BME680 ready", 40, false, WHITE, DARKGREEN);
         bsec_get_version(&bsec_version);
-        Serial.printf("BME680: sensor ready, sample rate 3s, BSEC v%d.%d.%d.%d\n", bsec_version.major,
+        Serial.printf("BME680: sensor ready, sample rate %us (%s), BSEC v%d.%d.%d.%d\n",
+            bsecProfiles[this->profile].periodSecs, bsecProfiles[this->profile].name, bsec_version.major,
             bsec_version.minor, bsec_version.major_bugfix, bsec_version.minor_bugfix);
         delay(1500);
+
+        // bsecTask is started afterwards, it owns the library and the saved state
         this->dialogResetBSEC();
-        return true;
+        if (resetBSEC)  // drop calibration already loaded into the library
+            this->state = this->init(false);
+
+        xTaskCreatePinnedToCore(this->bsecTaskWrapper, "bsecTask", 4096,
+            this, 12, &this->bsecTaskHandle, 1);
+        if (this->bsecTaskHandle == NULL) {
+            Serial.println("BME680: failed to start BSEC task");
+            this->state = 0;
+        }
+        return this->state > 0;
     }
 }
 
 
-// get current readings from BME680 and copy them to sensor struct 
-bool BME680::read() {
-    if (this->bsec.run() && this->status()) {
-        readings.bme680Temp = this->bsec.temperature;
-        readings.bme680Hum = int(this->bsec.humidity);
-        readings.bme680Iaq = int(this->bsec.iaq);
-        readings.bme680IaqAccuracy = int(this->bsec.iaqAccuracy);
-        readings.bme680GasResistance = int(this->bsec.gasResistance/1000); // kOhm
-        readings.bme680eCO2 = int(this->bsec.co2Equivalent);
-        readings.bme680VOC = this->bsec.breathVocEquivalent;
-        return true;
-    } else {
-        return false;
+// copy outputs of last BSEC call to the inactive buffer and make it the current one
+void BME680::publish() {
+    uint32_t seq = this->sequence.load(std::memory_order_relaxed);
+    bsecOutputs_t *out = &this->outputs[((seq >> 1) + 1) & 1];
+
+    this->sequence.store(seq + 1, std::memory_order_relaxed);  // odd while writing
+    std::atomic_thread_fence(std::memory_order_release);
+    out->temperature = this->bsec.temperature;
+    out->humidity = int(this->bsec.humidity);
+    out->iaq = int(this->bsec.iaq);
+    out->iaqAccuracy = int(this->bsec.iaqAccuracy);
+    out->gasResistance = int(this->bsec.gasResistance/1000); // kOhm
+    out->eCO2 = int(this->bsec.co2Equivalent);
+    out->VOC = this->bsec.breathVocEquivalent;
+    this->sequence.store(seq + 2, std::memory_order_release);
+}
+
+
+// count delay of a BSEC call after its scheduled time (bsec.nextCall)
+void BME680::recordLateness(int64_t ms) {
+    uint8_t i = 0;
+
+    while (i < BME680_LATENESS_BUCKETS-1 && ms >= latenessBounds[i])
+        i++;
+    this->lateness[i]++;
+    if (ms > this->maxLateness)
+        this->maxLateness = ms;
+}
+
+
+// print lateness histogram of BSEC calls every BME680_STATS_INTERVAL_SECS
+void BME680::printLateness() {
+    static time_t lastStats = 0;
+
+    if (tsDiff(lastStats) < (BME680_STATS_INTERVAL_SECS * 1000))
+        return;
+    lastStats = millis();
+    Serial.print("BME680: BSEC call lateness");
+    for (uint8_t i = 0; i < BME680_LATENESS_BUCKETS-1; i++)
+        Serial.printf(" <%ums %u,", latenessBounds[i], this->lateness[i]);
+    Serial.printf(" >=%ums %u, max %u ms, %u timing violations\n", latenessBounds[BME680_LATENESS_BUCKETS-2],
+        this->lateness[BME680_LATENESS_BUCKETS-1], this->maxLateness, this->violations);
+}
+
+
+// calls BSEC library when it asks for it (bsec.nextCall) independent
+// of any blocking in loop(), BSEC requires calls every 3 secs (LP) with
+// little jitter, otherwise IAQ accuracy drops
+void BME680::bsecTask() {
+    uint8_t profile;
+    int64_t wait;
+
+    while (true) {
+        profile = this->profileRequest;
+        if (profile != this->profile) {
+            Serial.printf("BME680: switching to %s sampling (%u secs)...", bsecProfiles[profile].name,
+                bsecProfiles[profile].periodSecs);
+            if (this->applyProfile(profile))
+                Serial.println("OK");
+            else
+                Serial.println("failed");
+        }
+
+        wait = this->bsec.nextCall - this->bsec.getTimeMs();
+        if (wait > 0) {
+            ulTaskNotifyTake(pdTRUE, wait / portTICK_PERIOD_MS);  // woken up by checkPower()
+            continue;
+        }
+        if (this->bsec.nextCall > 0)
+            this->recordLateness(-wait);
+
+        if (this->bsec.run()) {
+            if (this->bsec.status == BSEC_W_SC_CALL_TIMING_VIOLATION)
+                this->violations++;
+            this->state = status(this->bsec);
+            if (this->state > 0) {
+                this->publish();
+                updateState(this->bsec);
+            }
+        } else {
+            this->state = status(this->bsec);
+            if (this->bsec.nextCall <= this->bsec.getTimeMs())  // no new schedule on errors
+                vTaskDelay(BME680_RETRY_MS / portTICK_PERIOD_MS);
+        }
+        this->printLateness();
     }
 }
 
 
-// returns true if either BME680's temperature or gas 
-// resistance readings have changed significantly
-bool BME680::changed() {
-    static float lastGasRes = 0.0, lastTemp = 0.0;
-    static uint8_t lastHum;
-    bool changed = false;
+void BME680::bsecTaskWrapper(void* _this) {
+    static_cast<BME680*>(_this)->bsecTask();
+}
+
+
+// copy latest BSEC outputs published by bsecTask() to sensor struct,
+// returns false if there are no new outputs since the last call
+bool BME680::read() {
+    bsecOutputs_t out;
+    uint32_t seq;
 
     if (!this->status())
         return false;
-    if (abs(lastGasRes - readings.bme680GasResistance) >= GASRESISTANCE_PUBLISH_THRESHOLD) // kOhm
-        changed = true;
-    if (abs(lastTemp - readings.bme680Temp) >= TEMP_PUBLISH_THRESHOLD)
-        changed = true;
-    if (abs(lastHum - readings.bme680Hum) >= HUM_PUBLISH_THRESHOLD)
-        changed = true;
-
-    lastHum = readings.bme680Hum;
-    lastTemp = readings.bme680Temp;
-    lastGasRes = readings.bme680GasResistance;
-
-    return changed;
+
+    do {
+        seq = this->sequence.load(std::memory_order_acquire);
+        out = this->outputs[(seq >> 1) & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq != this->sequence.load(std::memory_order_relaxed));
+
+    seq >>= 1;
+    if (seq == 0 || seq == this->lastRead)
+        return false;
+    this->lastRead = seq;
+    readings.bme680Temp = out.temperature;
+    readings.bme680Hum = out.humidity;
+    readings.bme680Iaq = out.iaq;
+    readings.bme680IaqAccuracy = out.iaqAccuracy;
+    readings.bme680GasResistance = out.gasResistance;
+    readings.bme680eCO2 = out.eCO2;
+    readings.bme680VOC = out.VOC;
+    return true;
 }
 
 
 // display BME680 readings an M5 Tough's OLED display if available
-void BME680::display() {
+void BME680::display(const sensorReadings_t &data) {
     if (this->status() > 0) {
-        if (this->bsec.runInStatus > 0) {
+        if (this->status() > 1) {
             M5.Lcd.setCursor(175, 150);
             M5.Lcd.print("VOC: ");  // shown right after HCHO on display
-            M5.Lcd.print(readings.bme680VOC, 1);
+            M5.Lcd.print(data.bme680VOC, 1);
             M5.Lcd.setCursor(15, 180); // new line on display with IAQ/eCO2 readings
             M5.Lcd.print("IAQ: ");
-            M5.Lcd.print(readings.bme680Iaq);
+            M5.Lcd.print(data.bme680Iaq);
             M5.Lcd.print("/");
-            M5.Lcd.print(readings.bme680IaqAccuracy);
+            M5.Lcd.print(data.bme680IaqAccuracy);
             M5.Lcd.setCursor(175, 180);
             M5.Lcd.print("eCO2: ");
-            M5.Lcd.print(readings.bme680eCO2);
+            M5.Lcd.print(data.bme680eCO2);
         } else {
             M5.Lcd.setCursor(175, 150);
             M5.Lcd.print("VOC: --.-"); // placed on display after HCHO reading
@@ -303,7 +542,6 @@ void BME680::display() {
             M5.Lcd.setCursor(175, 180);
             M5.Lcd.print("eCO2: ---");
         }
-        updateState(this->bsec);
     } else {
         M5.Lcd.setCursor(175, 150);
         M5.Lcd.print("VOC: n/a"); // first row after HCHO
@@ -316,20 +554,20 @@ void BME680::display() {
 
 
 // print sensor status/readings on serial console
-void BME680::console() {
+void BME680::console(const sensorReadings_t &data) {
     Serial.print("BME680: ");
     if (this->status() > 0) {
         if (this->status() > 1) {
             Serial.printf("IAQ(%d, %s), eCO2(%d ppm), VOC(", 
-                readings.bme680Iaq, accuracy(readings.bme680IaqAccuracy), readings.bme680eCO2);
-            Serial.print(readings.bme680VOC, 1);
+                data.bme680Iaq, accuracy(data.bme680IaqAccuracy), data.bme680eCO2);
+            Serial.print(data.bme680VOC, 1);
             Serial.print(" ppm), ");
         } else {
             Serial.print("gas sensor warmup, ");
         }
         Serial.printf("Gas(%d kOhm), Humdity(%d %%), Temperature(",
-            readings.bme680GasResistance, readings.bme680Hum);
-        Serial.print(readings.bme680Temp, 1);
+            data.bme680GasResistance, data.bme680Hum);
+        Serial.print(data.bme680Temp, 1);
         Serial.println(" C)");
     } else {
         Serial.println("sensor not ready!");
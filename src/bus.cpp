@@ -0,0 +1,148 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "bus.h"
+#include "utils.h"
+
+ReadingsBus Bus;
+
+
+ReadingsBus::ReadingsBus() {
+    memset(this->subscribers, 0, sizeof(this->subscribers));
+    this->lock = xSemaphoreCreateMutex();
+}
+
+
+// register a new transport with its own queue of given depth,
+// returns subscriber id or -1 if no more subscribers are allowed
+int8_t ReadingsBus::subscribe(const char *name, uint8_t depth, dropPolicy policy) {
+    int8_t id = -1;
+
+    if (policy == LATEST_ONLY)
+        depth = 1;
+    xSemaphoreTake(this->lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < BUS_MAX_SUBSCRIBERS; i++) {
+        if (this->subscribers[i].queue == NULL) {
+            this->subscribers[i].queue = xQueueCreate(depth, sizeof(sensorReadings_t));
+            if (this->subscribers[i].queue != NULL) {
+                this->subscribers[i].name = name;
+                this->subscribers[i].policy = policy;
+                this->subscribers[i].delivered = 0;
+                this->subscribers[i].dropped = 0;
+                id = i;
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(this->lock);
+
+    if (id < 0)
+        Serial.printf("BUS: failed to subscribe %s\n", name);
+    else
+        Serial.printf("BUS: %s subscribed (queue %d)\n", name, depth);
+    return id;
+}
+
+
+void ReadingsBus::unsubscribe(int8_t id) {
+    if (id < 0 || id >= BUS_MAX_SUBSCRIBERS)
+        return;
+    xSemaphoreTake(this->lock, portMAX_DELAY);
+    if (this->subscribers[id].queue != NULL)
+        vQueueDelete(this->subscribers[id].queue);
+    this->subscribers[id].queue = NULL;
+    xSemaphoreGive(this->lock);
+}
+
+
+// place a copy of the readings in each subscriber's queue,
+// the subscriber's drop policy applies if its queue is full
+void ReadingsBus::publish(const sensorReadings_t *data) {
+    sensorReadings_t oldest;
+    busSubscriber_t *sub;
+
+    xSemaphoreTake(this->lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < BUS_MAX_SUBSCRIBERS; i++) {
+        sub = &this->subscribers[i];
+        if (sub->queue == NULL)
+            continue;
+        switch (sub->policy) {
+            case LATEST_ONLY:
+                if (uxQueueMessagesWaiting(sub->queue) > 0)
+                    sub->dropped++;
+                xQueueOverwrite(sub->queue, data);
+                break;
+            case DROP_OLDEST:
+                if (xQueueSendToBack(sub->queue, data, 0) != pdTRUE) {
+                    if (xQueueReceive(sub->queue, &oldest, 0) == pdTRUE)
+                        sub->dropped++;
+                    if (xQueueSendToBack(sub->queue, data, 0) != pdTRUE)
+                        sub->dropped++;
+                }
+                break;
+            case BLOCK:
+                if (xQueueSendToBack(sub->queue, data, BUS_BLOCK_TIMEOUT_MS/portTICK_PERIOD_MS) != pdTRUE)
+                    sub->dropped++;
+                break;
+        }
+    }
+    xSemaphoreGive(this->lock);
+}
+
+
+// wait for up to given ticks for new readings in subscriber's queue
+bool ReadingsBus::receive(int8_t id, sensorReadings_t *data, TickType_t ticks) {
+    if (id < 0 || id >= BUS_MAX_SUBSCRIBERS || this->subscribers[id].queue == NULL)
+        return false;
+    if (xQueueReceive(this->subscribers[id].queue, data, ticks) != pdTRUE)
+        return false;
+    this->subscribers[id].delivered++;
+    return true;
+}
+
+
+uint32_t ReadingsBus::delivered(int8_t id) {
+    if (id < 0 || id >= BUS_MAX_SUBSCRIBERS)
+        return 0;
+    return this->subscribers[id].delivered;
+}
+
+
+uint32_t ReadingsBus::dropped(int8_t id) {
+    if (id < 0 || id >= BUS_MAX_SUBSCRIBERS)
+        return 0;
+    return this->subscribers[id].dropped;
+}
+
+
+// print delivered/dropped counters for all subscribers every BUS_STATS_INTERVAL_SECS
+void ReadingsBus::console() {
+    static time_t lastStats = 0;
+
+    if (tsDiff(lastStats) < (BUS_STATS_INTERVAL_SECS * 1000))
+        return;
+    lastStats = millis();
+    for (uint8_t i = 0; i < BUS_MAX_SUBSCRIBERS; i++) {
+        if (this->subscribers[i].queue != NULL)
+            Serial.printf("BUS: %s, %u delivered, %u dropped, %d queued\n", this->subscribers[i].name,
+                this->subscribers[i].delivered, this->subscribers[i].dropped,
+                uxQueueMessagesWaiting(this->subscribers[i].queue));
+    }
+}
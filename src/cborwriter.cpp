@@ -0,0 +1,207 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "cborwriter.h"
+
+// major types
+#define CBOR_UINT 0
+#define CBOR_NEGINT 1
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_FLOAT32 0xFA
+#define CBOR_FLOAT64 0xFB
+
+static const int32_t decimalScale[] = { 1, 10, 100, 1000, 10000 };
+
+
+CborWriter::CborWriter(uint8_t *buf, size_t size) {
+    this->buf = buf;
+    this->size = size;
+    this->reset();
+}
+
+
+void CborWriter::reset() {
+    this->len = 0;
+    this->depth = 0;
+    this->overflow = false;
+}
+
+
+void CborWriter::beginArray() {
+    this->item();
+    if (this->depth < CBOR_MAX_DEPTH) {
+        this->start[this->depth] = this->len;
+        this->items[this->depth++] = 0;
+    } else {
+        this->overflow = true;
+    }
+    this->put(CBOR_ARRAY << 5);
+}
+
+
+void CborWriter::endArray() {
+    if (this->depth > 0) {
+        this->depth--;
+        this->endContainer(CBOR_ARRAY, this->items[this->depth]);
+    }
+}
+
+
+void CborWriter::beginMap() {
+    this->item();
+    if (this->depth < CBOR_MAX_DEPTH) {
+        this->start[this->depth] = this->len;
+        this->items[this->depth++] = 0;
+    } else {
+        this->overflow = true;
+    }
+    this->put(CBOR_MAP << 5);
+}
+
+
+// keys and values are counted as items, a map's length is number of pairs
+void CborWriter::endMap() {
+    if (this->depth > 0) {
+        this->depth--;
+        this->endContainer(CBOR_MAP, this->items[this->depth] / 2);
+    }
+}
+
+
+void CborWriter::addInt(int64_t value) {
+    this->item();
+    if (value < 0)
+        this->putHead(CBOR_NEGINT, -1 - value);
+    else
+        this->putHead(CBOR_UINT, value);
+}
+
+
+// write fixed-point number, e.g. value 241 with 1 decimal as 24.1, single
+// precision is used as long as value has no more than 24 significant bits
+void CborWriter::addNumber(int64_t value, uint8_t decimals) {
+    uint32_t bits32;
+    uint64_t bits64;
+    float f;
+    double d;
+
+    if (decimals == 0 || value % decimalScale[decimals] == 0) {
+        this->addInt(value / decimalScale[decimals]);
+        return;
+    }
+    this->item();
+    d = (double)value / decimalScale[decimals];
+    if (value > -(1 << 24) && value < (1 << 24)) {
+        f = d;
+        memcpy(&bits32, &f, sizeof(bits32));
+        this->put(CBOR_FLOAT32);
+        for (int8_t i = 3; i >= 0; i--)
+            this->put((bits32 >> (i * 8)) & 0xFF);
+    } else {
+        memcpy(&bits64, &d, sizeof(bits64));
+        this->put(CBOR_FLOAT64);
+        for (int8_t i = 7; i >= 0; i--)
+            this->put((bits64 >> (i * 8)) & 0xFF);
+    }
+}
+
+
+void CborWriter::addString(const char *value) {
+    size_t n = strlen(value);
+
+    this->item();
+    this->putHead(CBOR_TEXT, n);
+    while (n-- > 0)
+        this->put(*value++);
+}
+
+
+// returns length of CBOR written so far
+size_t CborWriter::length() {
+    return this->len;
+}
+
+
+bool CborWriter::overflowed() {
+    return this->overflow || this->depth > 0;
+}
+
+
+// a single header byte has been reserved, move container's
+// items if its length doesn't fit and update the header
+void CborWriter::endContainer(uint8_t major, uint16_t count) {
+    size_t headStart = this->start[this->depth], end = this->len;
+    size_t headLen = count < 24 ? 1 : (count < 256 ? 2 : 3);
+
+    if (this->overflow)
+        return;
+    if (headLen > 1) {
+        if (this->len + headLen - 1 > this->size) {
+            this->overflow = true;
+            return;
+        }
+        memmove(this->buf + headStart + headLen, this->buf + headStart + 1, end - headStart - 1);
+    }
+    this->len = headStart;
+    this->putHead(major, count);
+    this->len = end + headLen - 1;
+}
+
+
+// count item in enclosing array or map
+void CborWriter::item() {
+    if (this->depth > 0)
+        this->items[this->depth-1]++;
+}
+
+
+void CborWriter::putHead(uint8_t major, uint64_t value) {
+    uint8_t bytes;
+
+    if (value < 24) {
+        this->put((major << 5) | value);
+        return;
+    } else if (value < 0x100) {
+        this->put((major << 5) | 24);
+        bytes = 1;
+    } else if (value < 0x10000) {
+        this->put((major << 5) | 25);
+        bytes = 2;
+    } else if (value < 0x100000000ULL) {
+        this->put((major << 5) | 26);
+        bytes = 4;
+    } else {
+        this->put((major << 5) | 27);
+        bytes = 8;
+    }
+    while (bytes-- > 0)
+        this->put((value >> (bytes * 8)) & 0xFF);
+}
+
+
+void CborWriter::put(uint8_t b) {
+    if (this->len < this->size) {
+        this->buf[this->len++] = b;
+    } else {
+        this->overflow = true;
+    }
+}
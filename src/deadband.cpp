@@ -0,0 +1,160 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+#include "deadband.h"
+#include "prefs.h"
+#include "utils.h"
+
+DeadbandFilter Deadband;
+
+
+DeadbandFilter::DeadbandFilter() {
+    this->count = 0;
+    this->lastPublished = 0;
+}
+
+
+// parse a single "key:threshold/hysteresis/minSecs" setting
+bool DeadbandFilter::parseField(char *entry, deadbandField_t *f) {
+    char *value;
+    int32_t scale;
+
+    while (*entry == ' ')
+        entry++;
+    if ((value = strchr(entry, ':')) == NULL)
+        return false;
+    *value++ = '\0';
+
+    memset(f, 0, sizeof(deadbandField_t));
+    for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+        if (!strcmp(SensorSchema[i].key, entry))
+            f->field = &SensorSchema[i];
+    }
+    if (f->field == NULL)
+        return false;
+
+    scale = fieldScale(f->field);
+    f->threshold = lround(strtod(value, &value) * scale);
+    if (*value == '/')
+        f->hysteresis = lround(strtod(value+1, &value) * scale);
+    if (*value == '/')
+        f->minIntervalSecs = strtoul(value+1, &value, 10);
+    return (*value == '\0' && f->threshold >= 0 && f->hysteresis >= 0);
+}
+
+
+// parse comma separated list of settings (e.g. "hcho:1/0.5/10,humidity:2/1/30")
+bool DeadbandFilter::parse(const char *config, deadbandField_t *parsed, uint8_t *num) {
+    char buf[DEADBAND_CONFIG_SIZE+1], *entry, *saveptr;
+
+    *num = 0;
+    strlcpy(buf, config, sizeof(buf));
+    for (entry = strtok_r(buf, ",", &saveptr); entry != NULL; entry = strtok_r(NULL, ",", &saveptr)) {
+        if (*num >= DEADBAND_MAX_FIELDS || !parseField(entry, &parsed[*num])) {
+            Serial.printf("DEADBAND: invalid setting '%s'\n", config);
+            return false;
+        }
+        (*num)++;
+    }
+    return true;
+}
+
+
+// set fields to watch from list of settings, returns false and keeps
+// current settings if list is invalid, resets all published values,
+// only call from loop() or before it runs
+bool DeadbandFilter::configure(const char *config) {
+    deadbandField_t parsed[DEADBAND_MAX_FIELDS];
+    uint8_t num;
+
+    if (!parse(config, parsed, &num))
+        return false;
+    memcpy(this->fields, parsed, num * sizeof(deadbandField_t));
+    this->count = num;
+    return true;
+}
+
+
+// check list of settings without applying it, may be called from any task
+bool DeadbandFilter::validate(const char *config) {
+    deadbandField_t parsed[DEADBAND_MAX_FIELDS];
+    uint8_t num;
+
+    return parse(config, parsed, &num);
+}
+
+
+// returns true if readings should be published, i.e. a field has changed by
+// at least its threshold (plus hysteresis if the change reverses direction
+// of the last published change) and its minimum interval has passed or if
+// nothing has been published for 'mqttIntervalSecs' (heartbeat)
+bool DeadbandFilter::check(const sensorReadings_t &data) {
+    uint8_t sensors = Sensors::available();
+    const char *trigger = NULL;
+    deadbandField_t *f;
+    int64_t value, delta, required;
+    int8_t direction;
+
+    for (uint8_t i = 0; i < this->count && trigger == NULL; i++) {
+        f = &this->fields[i];
+        if (!fieldAvailable(f->field, sensors, data))
+            continue;
+        if (!f->valid) {
+            trigger = f->field->key;
+            break;
+        }
+        delta = fieldValue(f->field, data) - f->published;
+        direction = (delta > 0) - (delta < 0);
+        required = f->threshold + (direction == -f->trend ? f->hysteresis : 0);
+        if (delta != 0 && abs(delta) >= required && tsDiff(f->publishedAt) >= (f->minIntervalSecs * 1000))
+            trigger = f->field->key;
+    }
+
+    if (trigger == NULL) {
+        if (this->lastPublished > 0 && tsDiff(this->lastPublished) < (prefs.mqttIntervalSecs * 1000))
+            return false;
+        trigger = "heartbeat";
+    }
+
+    // all fields are published with this set of readings
+    for (uint8_t i = 0; i < this->count; i++) {
+        f = &this->fields[i];
+        if (!fieldAvailable(f->field, sensors, data))
+            continue;
+        value = fieldValue(f->field, data);
+        if (f->valid && value != f->published)
+            f->trend = (value > f->published) ? 1 : -1;
+        f->published = value;
+        f->publishedAt = millis();
+        f->valid = true;
+    }
+    this->lastPublished = millis();
+    Serial.printf("DEADBAND: publishing readings (%s)\n", trigger);
+    return true;
+}
+
+
+// returns configured threshold for given field, 0 if not watched
+int64_t DeadbandFilter::threshold(const sensorField_t *field) {
+    for (uint8_t i = 0; i < this->count; i++) {
+        if (this->fields[i].field == field)
+            return this->fields[i].threshold;
+    }
+    return 0;
+}
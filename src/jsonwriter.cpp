@@ -0,0 +1,174 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "jsonwriter.h"
+
+
+JsonWriter::JsonWriter(char *buf, size_t size) {
+    this->buf = buf;
+    this->size = size;
+    this->reset();
+}
+
+
+void JsonWriter::reset() {
+    this->len = 0;
+    this->depth = 0;
+    this->first = 1;
+    this->overflow = (this->size == 0);
+    if (this->size > 0)
+        this->buf[0] = '\0';
+}
+
+
+void JsonWriter::beginObject(const char *key) {
+    this->separator(key);
+    this->put('{');
+    if (this->depth < JSON_MAX_DEPTH-1) {
+        this->depth++;
+        this->first |= (1 << this->depth);
+    } else {
+        this->overflow = true;
+    }
+}
+
+
+void JsonWriter::endObject() {
+    this->put('}');
+    if (this->depth > 0)
+        this->depth--;
+}
+
+
+void JsonWriter::beginArray(const char *key) {
+    this->separator(key);
+    this->put('[');
+    if (this->depth < JSON_MAX_DEPTH-1) {
+        this->depth++;
+        this->first |= (1 << this->depth);
+    } else {
+        this->overflow = true;
+    }
+}
+
+
+void JsonWriter::endArray() {
+    this->put(']');
+    if (this->depth > 0)
+        this->depth--;
+}
+
+
+// write fixed-point number, e.g. value 241 with 1 decimal as 24.1
+void JsonWriter::addNumber(const char *key, int64_t value, uint8_t decimals) {
+    char digits[24];
+    uint64_t n;
+    uint8_t i = 0;
+
+    this->separator(key);
+    if (value < 0) {
+        this->put('-');
+        n = -(uint64_t)value;
+    } else {
+        n = value;
+    }
+    do {
+        digits[i++] = '0' + (n % 10);
+        n /= 10;
+    } while (n > 0 || i <= decimals);  // leading zero for values < 1
+    while (i > 0) {
+        if (i == decimals)
+            this->put('.');
+        this->put(digits[--i]);
+    }
+}
+
+
+void JsonWriter::addString(const char *key, const char *value) {
+    this->separator(key);
+    this->put('"');
+    this->putEscaped(value);
+    this->put('"');
+}
+
+
+void JsonWriter::addNull(const char *key) {
+    this->separator(key);
+    this->put("null");
+}
+
+
+// returns length of JSON written so far (without terminating zero)
+size_t JsonWriter::length() {
+    return this->len;
+}
+
+
+bool JsonWriter::overflowed() {
+    return this->overflow;
+}
+
+
+// add comma if this isn't the first member of an object/array and write key
+void JsonWriter::separator(const char *key) {
+    if (this->first & (1 << this->depth))
+        this->first &= ~(1 << this->depth);
+    else
+        this->put(',');
+    if (key != NULL) {
+        this->put('"');
+        this->putEscaped(key);
+        this->put("\":");
+    }
+}
+
+
+void JsonWriter::put(char c) {
+    if (this->len + 1 < this->size) {
+        this->buf[this->len++] = c;
+        this->buf[this->len] = '\0';
+    } else {
+        this->overflow = true;
+    }
+}
+
+
+void JsonWriter::put(const char *str) {
+    while (*str)
+        this->put(*str++);
+}
+
+
+void JsonWriter::putEscaped(const char *str) {
+    static const char hex[] = "0123456789abcdef";
+
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            this->put('\\');
+            this->put(*str);
+        } else if ((uint8_t)*str < 0x20) {
+            this->put("\\u00");
+            this->put(hex[(*str >> 4) & 0x0F]);
+            this->put(hex[*str & 0x0F]);
+        } else {
+            this->put(*str);
+        }
+    }
+}
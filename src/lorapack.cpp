@@ -0,0 +1,186 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "lorapack.h"
+#include "utils.h"
+#include "rtc.h"
+
+#define PACKED_TEMP_OFFSET -20.0
+
+
+// returns value as number of steps above offset clamped to given bit width
+static uint32_t quantize(float value, float resolution, float offset, uint8_t bits) {
+    float steps = roundf((value - offset) / resolution);
+    uint32_t maxSteps = (1UL << bits) - 1;
+
+    if (steps <= 0)
+        return 0;
+    return steps >= maxSteps ? maxSteps : (uint32_t)steps;
+}
+
+
+// field group and bit width of quantized fields
+static const uint8_t fieldGroup[PACKED_FIELDS] = {
+    PACKED_MLX, PACKED_MLX, PACKED_HUMIDITY, PACKED_HCHO, PACKED_IAQ, PACKED_IAQ, PACKED_IAQ
+};
+static const uint8_t fieldBits[PACKED_FIELDS] = { 10, 10, 7, 14, 10, 11, 10 };
+
+
+static uint8_t presence(const sensorReadings_t &data, uint8_t sensors, uint8_t ack) {
+    uint8_t present = 0;
+
+    if (sensors & SENSOR_MLX90614)
+        present |= PACKED_MLX;
+    if (sensors & (SENSOR_BME680 | SENSOR_SFA30))
+        present |= PACKED_HUMIDITY;
+    if (sensors & SENSOR_SFA30)
+        present |= PACKED_HCHO;
+    if ((sensors & SENSOR_BME680) && data.bme680IaqAccuracy >= 1)
+        present |= PACKED_IAQ;
+    if (M5.Axp.GetBatVoltage() >= 1.0)
+        present |= PACKED_BATTERY;
+    if (data.timestamp > 0)
+        present |= PACKED_TIME;
+    if (ack != 0)
+        present |= PACKED_ACK;
+    return present;
+}
+
+
+// quantize readings as they are packed
+void packSample(const sensorReadings_t &data, uint8_t sensors, packedSample_t *sample) {
+    sample->value[PACKED_OBJECT_TEMP] = quantize(data.mlxObjectTemp, 0.1, PACKED_TEMP_OFFSET, 10);
+    sample->value[PACKED_AMBIENT_TEMP] = quantize(data.mlxAmbientTemp, 0.1, PACKED_TEMP_OFFSET, 10);
+    sample->value[PACKED_HUM] = min((sensors & SENSOR_BME680) ? data.bme680Hum : data.sfa30Hum, (uint8_t)100);
+    sample->value[PACKED_HCHO_PPB] = quantize(data.sfa30HCHO, 0.1, 0, 14);
+    sample->value[PACKED_IAQ_INDEX] = min(data.bme680Iaq, (uint16_t)1023);
+    sample->value[PACKED_ECO2] = min(data.bme680eCO2, (uint16_t)2047);
+    sample->value[PACKED_VOC] = quantize(data.bme680VOC, 0.01, 0, 10);
+}
+
+
+// fields of a version 1 payload
+static void packFields(BitWriter &bits, const sensorReadings_t &data, uint8_t present,
+        const packedSample_t &sample, uint8_t version, uint8_t ack) {
+    bits.put(PACKED_MAGIC | version, 8);
+    bits.put(present, 8);
+    for (uint8_t i = 0; i < PACKED_FIELDS; i++) {
+        if (present & fieldGroup[i])
+            bits.put(sample.value[i], fieldBits[i]);
+        if (i == PACKED_IAQ_INDEX && (present & PACKED_IAQ))
+            bits.put(min(data.bme680IaqAccuracy, (uint8_t)3), 2);
+    }
+    if (present & PACKED_BATTERY) {
+        bits.put(constrain(int(M5.Axp.GetBatteryLevel()), 0, 100), 7);
+        bits.put(usbPowered() ? 1 : 0, 1);
+    }
+    if (present & PACKED_TIME)
+        bits.put(data.timestamp / 1000, 32);
+    bits.put(min(SysTime.getRuntimeMinutes(), (uint32_t)0xFFFFF), 20);
+    bits.put(data.sequence & 0xFFFF, 16);
+    if (present & PACKED_ACK)
+        bits.put(ack, 8);
+}
+
+
+// returns number of bits needed to store deltas of a field as two's complement
+static uint8_t deltaWidth(const packedSample_t &base, const packedSample_t *history,
+        uint8_t count, uint8_t field) {
+    const packedSample_t *newer = &base;
+    int32_t delta, range = 0;
+    uint8_t width;
+    bool changed = false;
+
+    for (uint8_t i = 0; i < count; i++) {
+        delta = history[i].value[field] - newer->value[field];
+        changed = changed || delta != 0;
+        range = max(range, delta < 0 ? ~delta : delta);
+        newer = &history[i];
+    }
+    if (!changed)
+        return 0;
+    for (width = 1; range > 0; width++)
+        range >>= 1;
+    return width;
+}
+
+
+// encode readings of available sensors, returns payload length or 0 if buffer is too small
+size_t packReadings(const sensorReadings_t &data, uint8_t sensors, uint8_t *buf, size_t size,
+        uint8_t ack) {
+    BitWriter bits(buf, size);
+    packedSample_t sample;
+
+    packSample(data, sensors, &sample);
+    packFields(bits, data, presence(data, sensors, ack), sample, PACKED_VERSION, ack);
+    return bits.overflowed() ? 0 : bits.length();
+}
+
+
+// bits needed for the largest gap between samples, gaps are clamped to 15 bits
+static uint8_t gapWidth(const uint16_t *gaps, uint8_t count) {
+    uint16_t range = 0;
+    uint8_t width;
+
+    for (uint8_t i = 0; i < count; i++)
+        range = max(range, min(gaps[i], (uint16_t)0x7FFF));
+    for (width = 0; range > 0; width++)
+        range >>= 1;
+    return width;
+}
+
+
+// encode most recent readings followed by up to 'count' older samples (newest first)
+// as deltas, 'gaps' holds the secs between each older sample and the next newer one,
+// 'count' is set to the number of samples which fit into the buffer,
+// returns payload length or 0 if buffer is too small even without history
+size_t packBatch(const sensorReadings_t &data, uint8_t sensors, const packedSample_t *history,
+        const uint16_t *gaps, uint8_t *count, uint8_t *buf, size_t size, uint8_t ack) {
+    BitWriter bits(buf, size);
+    packedSample_t base;
+    uint8_t present = presence(data, sensors, ack), width[PACKED_FIELDS], gapBits;
+
+    packSample(data, sensors, &base);
+    *count = min(*count, (uint8_t)PACKED_BATCH_SAMPLES);
+    while (true) {
+        bits.reset();
+        packFields(bits, data, present, base, PACKED_BATCH_VERSION, ack);
+        gapBits = gapWidth(gaps, *count);
+        bits.put(*count, 4);
+        bits.put(gapBits, 4);
+        for (uint8_t i = 0; i < PACKED_FIELDS; i++) {
+            if (present & fieldGroup[i]) {
+                width[i] = deltaWidth(base, history, *count, i);
+                bits.put(width[i], 4);
+            }
+        }
+        for (uint8_t s = 0; s < *count; s++) {
+            bits.put(min(gaps[s], (uint16_t)0x7FFF), gapBits);
+            for (uint8_t i = 0; i < PACKED_FIELDS; i++) {
+                if ((present & fieldGroup[i]) && width[i] > 0)
+                    bits.putSigned(history[s].value[i] - (s > 0 ? history[s-1] : base).value[i], width[i]);
+            }
+        }
+        if (!bits.overflowed() || *count == 0)
+            break;
+        (*count)--;  // drop oldest sample
+    }
+    return bits.overflowed() ? 0 : bits.length();
+}
@@ -24,6 +24,7 @@
 #include "utils.h"
 #include "rtc.h"
 #include "display.h"
+#include "deadband.h"
 
 CayenneLPP lpp(LORAWAN_LPP_SIZE);
 ASR6501 LoRaWAN;
@@ -32,32 +33,52 @@ UBaseType_t stackWmJoinTask, stackWmQueueTask;
 #endif
 
 
-ASR6501::ASR6501() {
+ASR6501::ASR6501() : dutyCycle(LORAWAN_DUTY_CYCLE_PERMILLE, LORAWAN_DUTY_BUCKET_MS) {
     this->deviceState = NONE;
-    this->msgQueue = xQueueCreate(1, sizeof(sensorReadings_t));
+    this->busId = -1;
+    this->dataRate = LORAWAN_REFERENCE_DR;
+    this->payloadLen = 0;
+    this->lastSentValid = false;
+    this->historyLen = 0;
+    memset(this->historyAt, 0, sizeof(this->historyAt));
+    this->historyStep = LORAWAN_BATCH_STEP_SECS;
+    this->downlinkQueue = NULL;
+    this->ack = 0;
+    this->linkFailures = 0;
 }
 
 
-ASR6501::ASR6501(HardwareSerial* serialPort, uint8_t rxPin, uint8_t txPin) {
+ASR6501::ASR6501(HardwareSerial* serialPort, uint8_t rxPin, uint8_t txPin) :
+        dutyCycle(LORAWAN_DUTY_CYCLE_PERMILLE, LORAWAN_DUTY_BUCKET_MS) {
     this->begin(serialPort, rxPin, txPin);
     this->deviceState = NONE;
-    this->msgQueue = xQueueCreate(1, sizeof(sensorReadings_t));
+    this->busId = -1;
+    this->dataRate = LORAWAN_REFERENCE_DR;
+    this->payloadLen = 0;
+    this->lastSentValid = false;
+    this->historyLen = 0;
+    memset(this->historyAt, 0, sizeof(this->historyAt));
+    this->historyStep = LORAWAN_BATCH_STEP_SECS;
+    this->downlinkQueue = NULL;
+    this->ack = 0;
+    this->linkFailures = 0;
     this->joinTaskHandle = NULL;
     this->queueTaskHandle = NULL;
-    this->SerialLock = NULL;
     this->serial = NULL;
 }
 
 
 ASR6501::~ASR6501() {
     this->deviceState = NONE;
-    vQueueDelete(this->msgQueue);
-    if (this->SerialLock != NULL)
-        vSemaphoreDelete(this->SerialLock);
+    Bus.unsubscribe(this->busId);
+    this->busId = -1;
     if (this->joinTaskHandle != NULL)
         vTaskDelete(this->joinTaskHandle);
     if (this->queueTaskHandle != NULL)
         vTaskDelete(this->queueTaskHandle);
+    this->at.end();
+    if (this->downlinkQueue != NULL)
+        vQueueDelete(this->downlinkQueue);
     if (this->serial != NULL)
         this->serial->end();
     lpp.~CayenneLPP();
@@ -90,71 +111,193 @@ lorawanState ASR6501::status() {
 }
 
 
-// send command to serial LoRaWAN adapter and returns response as string
-const char* ASR6501::sendCmd(const char* cmd, uint16_t timeout) {
-    static char buf[128], c;
-    bool dataRead = false;
-    time_t startRead;
-    lorawanState prevState; 
-    uint8_t i = 0;
-
-    if (xSemaphoreTake(this->SerialLock, SEMAPHORE_BLOCKTIME_MS) == pdTRUE) {
-        prevState = this->deviceState;
-        this->deviceState = COMMAND;
-
+// send command to serial LoRaWAN adapter, returns true if it has been acknowledged
+// with 'OK', the response is optionally copied to 'resp' (see ATParser::command())
+bool ASR6501::sendCmd(const char* cmd, char* resp, size_t size, uint16_t timeout) {
+    atResult result;
 #ifdef LORAWAN_DEBUG_SERIAL_CMDS
-        Serial.printf(">>> %s\n", cmd);
-#endif
-        snprintf(buf, sizeof(buf), "%s\r\n", cmd);
-        this->serial->print(buf);
-        vTaskDelay(100/portTICK_PERIOD_MS);
-
-        memset(buf, 0, sizeof(buf));
-        startRead = millis(); i = 0;
-        while (!dataRead && tsDiff(startRead) <= timeout) {
-            while (this->serial->available() > 0) {
-                if (i < sizeof(buf)) {
-                    c = this->serial->read();
-                    if (c == 13) c = 32; // CR -> space
-                    if (c >= 32 && c <= 126) { // only printable chars
-                        buf[i++] = c;
-                        dataRead = (i >= 5) ? true : false; // AT+XX...=...
-                    }
-                } else {
-                    break;
-                }
-                vTaskDelay(1/portTICK_PERIOD_MS);
-            }
-            esp_task_wdt_reset();
-            vTaskDelay(100/portTICK_PERIOD_MS);
-        }
-        xSemaphoreGive(this->SerialLock);
-        this->deviceState = prevState;
+    static const char *results[] = { "OK", "ERROR", "timeout", "busy" };
+    time_t startCmd = millis();
 
+    Serial.printf(">>> %s\n", cmd);
+#endif
+    result = this->at.command(cmd, resp, size, timeout);
 #ifdef LORAWAN_DEBUG_SERIAL_CMDS
-        if (i > 0)
-            Serial.printf("<<< %s (%d bytes, %ld ms)\n", buf, i, tsDiff(startRead));
-        else
-            Serial.printf("<<< [timeout] (%ld ms)\n", tsDiff(startRead));
+    Serial.printf("<<< %s [%s] (%ld ms)\n", (resp != NULL && size > 0) ? resp : "",
+        results[result], tsDiff(startCmd));
 #endif
-        return buf;
-
-    } else {
+    if (result == AT_BUSY)
         Serial.println("LoRaWAN: serial connection busy");
-        return NULL;
+    return result == AT_OK;
+}
+
+
+// query current data rate, might have been changed by ADR
+void ASR6501::readDataRate() {
+    char resp[64];
+    const char *value;
+    int dr;
+
+    if (this->sendCmd("AT+CDATARATE?", resp, sizeof(resp)) &&
+            (value = strstr(resp, "+CDATARATE:")) != NULL &&
+            sscanf(value, "+CDATARATE:%d", &dr) == 1 && dr >= 0 && dr <= LORAWAN_MAX_DR) {
+        if (dr != this->dataRate)
+            Serial.printf("LoRaWAN: data rate DR%d (SF%d)\n", dr, 12 - dr);
+        this->dataRate = dr;
+    }
+}
+
+
+// unsolicited result of join procedure started with 'AT+CJOIN'
+void ASR6501::onJoin(const char* line, void* _this) {
+    ASR6501 *lora = static_cast<ASR6501*>(_this);
+
+    if (strstr(line, "+CJOIN:OK") != NULL) {
+        Serial.println("LoRaWAN: joined network");
+        queueStatusMsg("LoRaWAN joined", 60, false);
+        lora->deviceState = JOINED;
+    } else if (lora->deviceState == JOINING) {
+        // never reached, M5 LoRaWAN adapter tries to join forever...
+        lora->deviceState = JOINFAIL;
+    }
+    if (lora->joinTaskHandle != NULL)
+        xTaskNotifyGive(lora->joinTaskHandle);
+}
+
+
+// status reported without being queried, e.g. '+CSTATUS:04' after first join
+void ASR6501::onStatus(const char* line, void* _this) {
+    ASR6501 *lora = static_cast<ASR6501*>(_this);
+    const char *code = strpbrk(line, "0123456789");
+
+    if (code == NULL)
+        return;
+    Serial.printf("LoRaWAN: status %s\n", code);
+    if (atoi(code) == 4 && lora->deviceState == JOINING) {
+        lora->deviceState = JOINED;
+        if (lora->joinTaskHandle != NULL)
+            xTaskNotifyGive(lora->joinTaskHandle);
+    }
+}
+
+
+// 'ERR+SENT:<count>' if a confirmed uplink hasn't been acknowledged
+void ASR6501::onSendFailed(const char* line, void* _this) {
+    Serial.printf("LoRaWAN: uplink not confirmed (%s)\n", line);
+    queueStatusMsg("LoRaWAN no ack", 65, true);
+}
+
+
+// downlink 'OK+RECV:<type>,<port>,<len>,<data>', type 0x02 is a bare ack, commands
+// are handed over to queueTask() since they are answered with further AT commands
+void ASR6501::onDownlink(const char* line, void* _this) {
+    ASR6501 *lora = static_cast<ASR6501*>(_this);
+    lorawanDownlink_t downlink;
+    unsigned int type, port, len, value;
+    int data = 0;
+
+    if (sscanf(line, "OK+RECV:%x,%x,%x,%n", &type, &port, &len, &data) != 3 || len == 0)
+        return;
+    Serial.printf("LoRaWAN: received downlink on port %u (%u bytes)\n", port, len);
+    if (port != LORAWAN_COMMAND_PORT || lora->downlinkQueue == NULL)
+        return;
+
+    // hex data, a malformed or oversized downlink is passed on empty (invalid)
+    for (downlink.len = 0; data > 0 && downlink.len < min(len, (unsigned int)LORAWAN_DOWNLINK_SIZE) &&
+            sscanf(line + data + downlink.len * 2, "%2x", &value) == 1; downlink.len++)
+        downlink.data[downlink.len] = value;
+    if (downlink.len != len)
+        downlink.len = 0;
+    if (xQueueSend(lora->downlinkQueue, &downlink, 0) != pdTRUE)
+        Serial.println("LoRaWAN: downlink queue full, commands dropped");
+}
+
+
+// answer to link check requested with last uplink
+// '+CLINKCHECK: <status> <margin> <gateways> <rssi> <snr>'
+void ASR6501::onLinkCheck(const char* line, void* _this) {
+    ASR6501 *lora = static_cast<ASR6501*>(_this);
+    int status, margin, gateways, rssi, snr;
+
+    if (sscanf(line, "+CLINKCHECK:%d %d %d %d %d", &status, &margin, &gateways, &rssi, &snr) != 5 ||
+            status != 0) {
+        Serial.println("LoRaWAN: link check failed");
+        return;
     }
+    lora->linkFailures = 0;
+    lora->linkMargin = margin;
+    lora->linkGateways = gateways;
+    lora->linkRssi = rssi;
+    lora->linkSnr = snr;
+    Serial.printf("LoRaWAN: link margin %d dB, %d gateway(s), RSSI %d dBm, SNR %d dB\n",
+        margin, gateways, rssi, snr);
 }
 
 
-const char* ASR6501::sendCmd(const char* cmd) {
-    return this->sendCmd(cmd, LORAWAN_COMMAND_TIMEOUT_MS);
+// execute commands received with a downlink (see lorawan.h), returns ack bits
+// of the executed commands, parsing stops at an unknown or truncated command
+uint8_t ASR6501::runCommands(const uint8_t *cmd, uint8_t len) {
+    uint8_t ack = 0, opcode, i = 0;
+    bool ok;
+
+    if (len == 0)
+        return LORAWAN_ACK_ERROR;
+
+    while (i < len) {
+        opcode = cmd[i++];
+        ok = true;
+        switch (opcode) {
+            case LORAWAN_CMD_READINGS_INTERVAL:
+                if (i + 2 > len)
+                    return ack | LORAWAN_ACK_ERROR;
+                prefs.readingsIntervalSecs = (cmd[i] << 8) | cmd[i+1];
+                i += 2;
+                savePrefs(false);  // limits interval to valid range
+                Serial.printf("LoRaWAN: readings interval set to %d secs\n", prefs.readingsIntervalSecs);
+                break;
+            case LORAWAN_CMD_UPLINK_INTERVAL:
+                if (i + 2 > len)
+                    return ack | LORAWAN_ACK_ERROR;
+                prefs.lorawanIntervalSecs = (cmd[i] << 8) | cmd[i+1];
+                i += 2;
+                savePrefs(false);
+                Serial.printf("LoRaWAN: uplink interval set to %d secs\n", prefs.lorawanIntervalSecs);
+                break;
+            case LORAWAN_CMD_CONFIRM:
+                if (i + 1 > len)
+                    return ack | LORAWAN_ACK_ERROR;
+                prefs.lorawanConfirm = cmd[i++] != 0;
+                savePrefs(false);
+                Serial.printf("LoRaWAN: %s confirmed uplinks\n", prefs.lorawanConfirm ? "enable" : "disable");
+                ok = this->applySettings(SET_CONFIRM, SET_TRIALS) && this->sendCmd("AT+CSAVE");
+                if (ok)
+                    nvs.putUInt(LORAWAN_FINGERPRINT_KEY, this->fingerprint());
+                break;
+            case LORAWAN_CMD_READ_NOW:
+                Serial.println("LoRaWAN: readings requested");
+                Sensors::requestReading();
+                break;
+            case LORAWAN_CMD_SAVE_BSEC:
+                ok = Sensors::available() & SENSOR_BME680;
+                if (ok)
+                    bme680.requestStateSave();
+                break;
+            default:
+                Serial.printf("LoRaWAN: unknown downlink command 0x%02X\n", opcode);
+                return ack | LORAWAN_ACK_ERROR;
+        }
+        ack |= ok ? (1 << (opcode - 1)) : LORAWAN_ACK_ERROR;
+    }
+    return ack;
 }
 
 
 // returns true if connected to ASR 6501 serial LoRaWAN adapter
 bool ASR6501::connected() {
-    if (strstr(this->sendCmd("AT+CGMI?"), "ASR") != NULL &&
-        strstr(this->sendCmd("AT+CGMM?"), "6501") != NULL) {
+    char resp[64];
+
+    if (this->sendCmd("AT+CGMI?", resp, sizeof(resp)) && strstr(resp, "ASR") != NULL &&
+        this->sendCmd("AT+CGMM?", resp, sizeof(resp)) && strstr(resp, "6501") != NULL) {
         return true;
     } else {
         this->deviceState = ERROR;
@@ -176,27 +319,158 @@ const char* ASR6501::getDevEUI() {
 }
 
 
-// configure device for Over-The-Air-Authentication (OTAA)
-bool ASR6501::setOTAA(const char* appEUI, const char* appKey) {
-    char cmd[48];
+// returns adapter setting as command, settings are applied in order of their index
+const char* ASR6501::setting(uint8_t index) {
+    static char cmd[LORAWAN_SETTING_SIZE];
+
+    switch (index) {
+        case SET_JOINMODE:
+            return "AT+CJOINMODE=0";  // OTAA
+        case SET_DEVEUI:
+            snprintf(cmd, sizeof(cmd), "AT+CDEVEUI=%s", this->getDevEUI());
+            return cmd;
+        case SET_APPEUI:
+            snprintf(cmd, sizeof(cmd), "AT+CAPPEUI=%s", prefs.lorawanAppEUI);
+            return cmd;
+        case SET_APPKEY:
+            snprintf(cmd, sizeof(cmd), "AT+CAPPKEY=%s", prefs.lorawanAppKey);
+            return cmd;
+        case SET_CLASS:
+            return "AT+CCLASS=2";  // 0: Class A, 1: Class B, 2: Class C
+        case SET_ADR:
+            return "AT+CADR=1";
+        case SET_WORKMODE:
+            return "AT+CWORKMODE=2";
+        case SET_BANDMASK:
+            return "AT+CFREQBANDMASK=0001";  // 868 MHz, channels 0-7
+        case SET_RX2:
+            return "AT+CRXP=0,0,869525000";  // RX2: 869.525MHz on SF9BW125
+        case SET_CONFIRM:
+            return prefs.lorawanConfirm ? "AT+CCONFIRM=1" : "AT+CCONFIRM=0";
+        case SET_TRIALS:
+            return prefs.lorawanConfirm ? "AT+CNBTRIALS=1,3" : "AT+CNBTRIALS=0,1";
+        default:
+            return NULL;
+    }
+}
 
-    if (strlen(appEUI) != 16 || strlen(appKey) != 32) {
-        Serial.print("invalid appeui/appkey size...");
-        return false;
+
+// send settings 'first' to 'last' to adapter
+bool ASR6501::applySettings(uint8_t first, uint8_t last) {
+    for (uint8_t i = first; i <= last; i++) {
+        if (!this->sendCmd(this->setting(i)))
+            return false;
     }
+    return true;
+}
 
-    if (strstr(this->sendCmd("AT+CJOINMODE=0"), "OK") == NULL)
-        return false;
-    snprintf(cmd, 28, "AT+CDEVEUI=%s", this->getDevEUI());
-    if (strstr(this->sendCmd(cmd), "OK") == NULL)
-        return false;
-    snprintf(cmd, 28,"AT+CAPPEUI=%s", appEUI);
-    if (strstr(this->sendCmd(cmd), "OK") == NULL)
-        return false;
-    snprintf(cmd, 44, "AT+CAPPKEY=%s", appKey);
-    if (strstr(this->sendCmd(cmd), "OK") == NULL)
+
+// CRC32 of all adapter settings, saved to NVS once they have been applied
+uint32_t ASR6501::fingerprint() {
+    const char *cmd;
+    uint32_t crc = 0;
+
+    for (uint8_t i = 0; i < LORAWAN_SETTINGS; i++) {
+        cmd = this->setting(i);
+        crc = calcCRC32(cmd, strlen(cmd), crc);
+    }
+    return crc;
+}
+
+
+// returns true if the settings applied last (fingerprint in NVS) are still the
+// current ones and the adapter still holds them, e.g. after an ESP32 reset
+bool ASR6501::configured() {
+    char query[LORAWAN_SETTING_SIZE], expected[LORAWAN_SETTING_SIZE], resp[96];
+    const char *cmd, *value;
+
+    if (nvs.getUInt(LORAWAN_FINGERPRINT_KEY) != this->fingerprint())
         return false;
 
+    for (uint8_t i = 0; i < LORAWAN_SETTINGS; i++) {
+        // 'AT+CCLASS=2' is read back with 'AT+CCLASS?' as '+CCLASS:2'
+        cmd = this->setting(i);
+        value = strchr(cmd, '=');
+        snprintf(query, sizeof(query), "%.*s?", int(value - cmd), cmd);
+        snprintf(expected, sizeof(expected), "%.*s:%s", int(value - cmd - 2), cmd + 2, value + 1);
+        if (!this->sendCmd(query, resp, sizeof(resp)) || strcasestr(resp, expected) == NULL) {
+            Serial.printf("LoRaWAN: adapter setting %s has changed\n", query);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// restore adapter defaults, configure OTAA, class, ADR, channels and confirmed
+// uplinks, the settings' fingerprint is saved to NVS if successful
+bool ASR6501::configure() {
+    nvs.remove(LORAWAN_FINGERPRINT_KEY);
+    nvs.remove(LORAWAN_SESSION_KEY);
+
+    M5.Lcd.setCursor(20, 65);
+    M5.Lcd.print("Restore defaults...");
+    Serial.print("LoRaWAN: restore defaults, reboot...");
+    if (this->sendCmd("AT+CRESTORE") &&
+        this->sendCmd("AT+CSAVE") &&
+        this->sendCmd("AT+IREBOOT=0")) {
+        M5.Lcd.print("OK");
+        Serial.println("OK");
+    } else {
+        return this->setupFailed("ERROR");
+    }
+    delay(500);
+
+    M5.Lcd.setCursor(20, 95);
+    M5.Lcd.print("Configure OTAA...");
+    Serial.print("LoRaWAN: configure OTAA...");
+    if (strlen(prefs.lorawanAppEUI) != 16 || strlen(prefs.lorawanAppKey) != 32) {
+        Serial.print("invalid appeui/appkey size...");
+        return this->setupFailed("ERROR");
+    } else if (this->applySettings(SET_JOINMODE, SET_APPKEY)) {
+        M5.Lcd.print("OK");
+        Serial.println("OK");
+    } else {
+        return this->setupFailed("ERROR");
+    }
+    delay(500);
+
+    M5.Lcd.setCursor(20, 125);
+    M5.Lcd.print("Enable ADR, class C...");
+    Serial.print("LoRaWAN: enable ADR, set class C mode...");
+    if (this->applySettings(SET_CLASS, SET_ADR)) {
+        M5.Lcd.print("OK");
+        Serial.println("OK");
+    } else {
+        return this->setupFailed("ERROR");
+    }
+    delay(500);
+
+    M5.Lcd.setCursor(20, 155);
+    M5.Lcd.print("Set 8 channels, RX2...");
+    Serial.print("LoRaWAN: configure 8 channels, RX2 window...");
+    if (this->applySettings(SET_WORKMODE, SET_RX2)) {
+        M5.Lcd.print("OK");
+        Serial.println("OK");
+    } else {
+        return this->setupFailed("ERROR");
+    }
+    delay(500);
+
+    M5.Lcd.setCursor(20, 185);
+    M5.Lcd.printf("%s confirm data...", prefs.lorawanConfirm ? "Enable" : "Disable");
+    Serial.printf("LoRaWAN: %s confirm data transmission...", prefs.lorawanConfirm ? "enable" : "disable");
+    if (this->applySettings(SET_CONFIRM, SET_TRIALS)) {
+        M5.Lcd.print("OK");
+        Serial.println("OK");
+    } else {
+        return this->setupFailed("ERROR");
+    }
+    delay(500);
+
+    if (!this->sendCmd("AT+CSAVE"))
+        return this->setupFailed("ERROR");
+    nvs.putUInt(LORAWAN_FINGERPRINT_KEY, this->fingerprint());
     return true;
 }
 
@@ -207,27 +481,30 @@ void ASR6501::join() {
         return;
 
     Serial.printf("LoRaWAN: joining network with DevEUI %s...\n", this->getDevEUI());
+    ulTaskNotifyTake(pdTRUE, 0);  // discard stale join results
     // the M5 LoRaWAN module doesn't seem to care about settings for number of max. retries
     // if join fails it keeps trying forever instead of bailing out with '+CJOIN:FAIL'
-    if (strstr(this->sendCmd("AT+CJOIN=1,0,8,3"), "OK") != NULL) {
-        this->deviceState = JOINING;
-    } else {
+    this->deviceState = JOINING;
+    if (!this->sendCmd("AT+CJOIN=1,0,8,3")) {
         Serial.println("LoRaWAN: command 'AT+CJOIN' failed");
         this->deviceState = ERROR;
     }
 }
 
 
-// returns true if device is joined to LoRaWAN network
+// returns true if device is joined to LoRaWAN network, i.e. the adapter
+// is sending (01), has sent (02, 03, 07, 08) or has just joined (04)
 bool ASR6501::joined() {
-    static char resp[64];
+    char resp[64];
+    const char *value;
+    int status;
 
     if (this->deviceState == JOINING || this->deviceState == JOINFAIL)
         return false;
 
-    strlcpy(resp, this->sendCmd("AT+CSTATUS?"), sizeof(resp));
-    if (strstr(resp, "+CSTATUS:") != NULL) {
-        if (strstr(resp, "03") != NULL || strstr(resp, "07") != NULL || strstr(resp, "08") != NULL) {
+    if (this->sendCmd("AT+CSTATUS?", resp, sizeof(resp)) && (value = strstr(resp, "+CSTATUS:")) != NULL &&
+            sscanf(value, "+CSTATUS:%d", &status) == 1) {
+        if ((status >= 1 && status <= 4) || status == 7 || status == 8) {
             this->deviceState = JOINED;
             return true;
         } else {
@@ -242,12 +519,55 @@ bool ASR6501::joined() {
 }
 
 
+// read device address assigned with last join as 8 digit hex string
+bool ASR6501::readDevAddr(char *devAddr) {
+    char resp[64];
+    const char *value;
+
+    return this->sendCmd("AT+CDEVADDR?", resp, sizeof(resp)) &&
+        (value = strstr(resp, "+CDEVADDR:")) != NULL &&
+        sscanf(value, "+CDEVADDR:%8[0-9A-Fa-f]", devAddr) == 1 && strlen(devAddr) == 8;
+}
+
+
+// let adapter keep the joined session (warm boot) and note its
+// device address in NVS to recognize it with resumeSession()
+void ASR6501::saveSession() {
+    lorawanSession_t session;
+
+    session.fingerprint = this->fingerprint();
+    if (this->sendCmd("AT+CSAVE") && this->readDevAddr(session.devAddr)) {
+        nvs.putBytes(LORAWAN_SESSION_KEY, &session, sizeof(session));
+        Serial.printf("LoRaWAN: saved session with DevAddr %s\n", session.devAddr);
+    } else {
+        nvs.remove(LORAWAN_SESSION_KEY);
+        Serial.println("LoRaWAN: failed to save session");
+    }
+}
+
+
+// returns true if the session saved with saveSession() is still active, i.e. the
+// adapter reports being joined ('AT+CSTATUS?') with the same device address,
+// otherwise the saved session is discarded and the device state set to 'IDLE'
+bool ASR6501::resumeSession() {
+    lorawanSession_t session;
+    char devAddr[9];
+
+    if (nvs.getBytes(LORAWAN_SESSION_KEY, &session, sizeof(session)) == sizeof(session) &&
+            session.fingerprint == this->fingerprint() && this->joined() &&
+            this->readDevAddr(devAddr) && !strcasecmp(devAddr, session.devAddr)) {
+        Serial.printf("LoRaWAN: resuming session with DevAddr %s\n", devAddr);
+        return true;
+    }
+    nvs.remove(LORAWAN_SESSION_KEY);
+    this->deviceState = IDLE;
+    return false;
+}
+
+
 // background task to (re)join LoRaWAN network
 void ASR6501::joinTask() {
-    static char buf[64], c;
-    bool dataRead = false;
-    time_t startRead = 0;
-    uint8_t i = 0, retryWait = 0;
+    uint8_t retryWait = 0;
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
     uint16_t loopCounter = 0;
 #endif
@@ -265,8 +585,9 @@ void ASR6501::joinTask() {
             } else if (!retryWait++) {
                 Serial.printf("LoRaWAN: join failed, retry in %d seconds\n", LORAWAN_JOIN_RETRY_SECS);
                 queueStatusMsg("LoRaWAN nojoin", 65, true);
-                if (strstr(this->sendCmd("AT+CSAVE"), "OK") == NULL ||
-                    strstr(this->sendCmd("AT+IREBOOT=0"), "OK") == NULL)
+                nvs.remove(LORAWAN_SESSION_KEY);
+                if (!this->sendCmd("AT+CSAVE") ||
+                    !this->sendCmd("AT+IREBOOT=0"))
                     this->deviceState = ERROR;
             }
 
@@ -274,34 +595,11 @@ void ASR6501::joinTask() {
             this->join(); // takes about 5 secs
 
         } else if (this->deviceState == JOINING) {
-            memset(buf, 0, sizeof(buf)); 
-            startRead = millis();
-            while (!dataRead && tsDiff(startRead) <= (LORAWAN_JOIN_TIMEOUT_SECS * 1000)) {
-                while (this->serial->available() > 0) {
-                    c = this->serial->read();
-                    if (i < sizeof(buf) && c >= 32 && c <= 126) {  // only printable chars
-                        buf[i++] = c;
-                        dataRead = true;
-                        if (strstr(buf, "+CJOIN:OK") != NULL) {
-                            Serial.println("LoRaWAN: joined network");
-                            queueStatusMsg("LoRaWAN joined", 60, false);
-                            this->deviceState = JOINED;
-                            break;
-
-                        // never reached, M5 LoRaWAN adapter tries to join forever...
-                        } else if (strstr(buf, "+CJOIN:FAIL") != NULL) {
-                            this->deviceState = JOINFAIL;
-                            retryWait = 0;
-                            break;
-                        }
-                    }
-                    if (this->serial->available() <= 5)
-                        vTaskDelay(2/portTICK_PERIOD_MS);
-                }
-                esp_task_wdt_reset();
-                vTaskDelay(500/portTICK_PERIOD_MS);
-            }
-            if (tsDiff(startRead) >= (LORAWAN_JOIN_TIMEOUT_SECS * 1000)) {
+            // woken up by onJoin() as soon as the adapter reports the join result
+            ulTaskNotifyTake(pdTRUE, (LORAWAN_JOIN_TIMEOUT_SECS * 1000)/portTICK_PERIOD_MS);
+            if (this->deviceState == JOINED) {
+                this->saveSession();
+            } else {
                 this->deviceState = JOINFAIL;
                 retryWait = 0;
             }
@@ -322,37 +620,172 @@ void ASR6501::joinTaskWrapper(void* _this) {
 }
 
 
-// background task to check send queue and transmit data every 'lorawanIntervalSecs'
-// based on FIFO send queue will only the most recent sensor readings
+// uplink interval in secs, 'lorawanIntervalSecs' applies to LORAWAN_REFERENCE_DR,
+// at other data rates it's scaled with the uplink's airtime to keep the average
+// airtime constant, but never shorter than the duty cycle allows, i.e. the
+// uplink's airtime plus the off-time required after it
+uint32_t ASR6501::uplinkInterval(uint32_t airtime) {
+    uint32_t reference = loraAirtimeMs(LORAWAN_REFERENCE_DR, this->payloadLen);
+    uint32_t interval;
+
+    interval = (uint64_t)prefs.lorawanIntervalSecs * airtime / reference;
+    interval = constrain(interval, LORAWAN_MIN_INTERVAL_SECS, LORAWAN_MAX_INTERVAL_SECS);
+    return max(interval, (airtime * 1000 / LORAWAN_DUTY_CYCLE_PERMILLE + 999) / 1000);
+}
+
+
+// returns true if readings are in an alarm range
+bool ASR6501::alarm(const sensorReadings_t &data) {
+    uint8_t sensors = Sensors::available();
+
+    if ((sensors & SENSOR_MLX90614) && data.mlxObjectTemp >= TEMP_THRESHOLD_RED)
+        return true;
+    if ((sensors & SENSOR_SFA30) && data.sfa30HCHO >= LORAWAN_ALARM_HCHO_PPB)
+        return true;
+    if ((sensors & SENSOR_BME680) && data.bme680IaqAccuracy >= 1 && data.bme680Iaq >= LORAWAN_ALARM_IAQ)
+        return true;
+    return false;
+}
+
+
+// returns true if readings should be sent before the uplink interval has passed,
+// i.e. they have entered or left an alarm range or a sensor field has changed by
+// its deadband threshold since the last uplink
+bool ASR6501::urgent(const sensorReadings_t &data) {
+    const sensorField_t *field;
+    uint8_t sensors = Sensors::available();
+    int64_t threshold;
+
+    if (!this->lastSentValid)
+        return false;
+    if (this->alarm(data) != this->alarm(this->lastSent))
+        return true;
+
+    for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+        field = &SensorSchema[i];
+        threshold = Deadband.threshold(field);
+        if (field->sensor == 0 || threshold <= 0 || !fieldAvailable(field, sensors, data) ||
+                !fieldAvailable(field, sensors, this->lastSent))
+            continue;
+        if (abs(fieldValue(field, data) - fieldValue(field, this->lastSent)) >= threshold)
+            return true;
+    }
+    return false;
+}
+
+
+// background task to check send queue and transmit data, the uplink interval is
+// adapted to the current data rate (see uplinkInterval()), changed readings and
+// alarms are sent early, uplinks are held back while the duty cycle's airtime
+// budget is used up, subscribed to readings bus with a queue holding only the
+// most recent sensor readings, downlink commands are executed here as well
 void ASR6501::queueTask() {
-    static char cmd[128], payload[96];
-    time_t lastRun = 0;
+    static char cmd[LORAWAN_BATCH_SIZE*2+32], payload[LORAWAN_BATCH_SIZE*2+1];
+    sensorReadings_t data, next;
+    lorawanDownlink_t downlink;
+    time_t lastRun = 0, dataAt = 0;
+    uint32_t airtime, interval = 0, received = 0, requested = 0;
+    uint16_t uplinks = 0;
+    uint8_t done, maxLen;
+    bool pending = false, urgent = false, deferred = false, readNow = false, immediate = false;
+    bool linkCheck;
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
     uint16_t loopCounter = 0;
 #endif
 
     while (true) {
-        if (this->deviceState == JOINED && this->deviceState != SENDING && 
-                tsDiff(lastRun) > (prefs.lorawanIntervalSecs * 1000)) {
-            lastRun = millis();
-            if (xQueueReceive(this->msgQueue, &readings, 0) == pdTRUE) {
-                strlcpy(payload, this->encodeLPP(readings), sizeof(payload));
-                if (strlen(payload) > 1) {
-                    deviceState = SENDING;
-                    Serial.printf("LoRaWAN: sending payload%s...", 
-                        prefs.lorawanConfirm ? " (confirmed)" : "");
-                    snprintf(cmd, sizeof(cmd), "AT+DTRX=%d,3,%d,%s", 
-                        prefs.lorawanConfirm ? 1 : 0, strlen(payload), payload);
-                    if (strstr(this->sendCmd(cmd), "OK+SEND:") != NULL) {
-                        Serial.println("OK");
-                        queueStatusMsg("LoRaWAN uplink", 65, false);
-                    } else {
-                        Serial.printf("ERROR");
-                        queueStatusMsg("LoRaWAN failed", 65, true);
+        // a session which isn't answered anymore (e.g. device was removed from
+        // network server while the saved session was resumed) needs a rejoin
+        if (this->deviceState == JOINED && this->linkFailures >= LORAWAN_LINKCHECK_FAILURES) {
+            Serial.printf("LoRaWAN: %d link checks failed, rejoining network\n", this->linkFailures);
+            nvs.remove(LORAWAN_SESSION_KEY);
+            this->linkFailures = 0;
+            this->deviceState = IDLE;
+        }
+
+        // acknowledged with next uplink, requested readings are sent right away
+        while (xQueueReceive(this->downlinkQueue, &downlink, 0) == pdTRUE) {
+            done = this->runCommands(downlink.data, downlink.len);
+            this->ack |= done;
+            if (done & (1 << (LORAWAN_CMD_READ_NOW - 1))) {
+                readNow = true;
+                requested = received;
+            }
+        }
+
+        // readings not sent yet are kept as history for batch uplinks
+        while (Bus.receive(this->busId, &next, 0)) {
+            if (pending && prefs.lorawanBatch)
+                this->addHistory(data, dataAt);
+            data = next;
+            dataAt = millis();
+            received = data.sequence;
+            pending = true;
+            urgent = urgent || this->urgent(data);
+            immediate = immediate || (readNow && received != requested);
+        }
+
+        if (this->deviceState == JOINED && pending) {
+            linkCheck = (uplinks % LORAWAN_LINKCHECK_UPLINKS) == 0;
+            airtime = loraAirtimeMs(this->dataRate, this->payloadLen + (linkCheck ? 1 : 0));
+            if (interval != this->uplinkInterval(airtime)) {
+                interval = this->uplinkInterval(airtime);
+                // spread history over uplink interval on low data rates
+                this->historyStep = min(max((uint32_t)LORAWAN_BATCH_STEP_SECS,
+                    interval / (PACKED_BATCH_SAMPLES + 1)), (uint32_t)255);
+                Serial.printf("LoRaWAN: uplink interval %d secs (DR%d, %d ms airtime)\n",
+                    interval, this->dataRate, airtime);
+            }
+
+            if (lastRun == 0 || immediate || tsDiff(lastRun) > (interval * 1000) ||
+                    (urgent && tsDiff(lastRun) > (LORAWAN_MIN_INTERVAL_SECS * 1000))) {
+                if (this->dutyCycle.waitMs(airtime) > 0) {
+                    if (!deferred)
+                        Serial.printf("LoRaWAN: duty cycle exhausted, uplink deferred by %d secs\n",
+                            this->dutyCycle.waitMs(airtime) / 1000 + 1);
+                    deferred = true;
+
+                } else {
+                    maxLen = loraMaxPayload(this->dataRate) - (linkCheck ? 1 : 0);
+                    if (prefs.lorawanBatch)
+                        strlcpy(payload, this->encodeBatch(data, dataAt, maxLen), sizeof(payload));
+                    else
+                        strlcpy(payload, prefs.lorawanPacked ? this->encodePacked(data, maxLen) :
+                            this->encodeLPP(data, maxLen), sizeof(payload));
+                    this->payloadLen = strlen(payload) / 2;
+                    airtime = loraAirtimeMs(this->dataRate, this->payloadLen + (linkCheck ? 1 : 0));
+                    if (strlen(payload) <= 1) {
+                        pending = urgent = false;  // drop readings which failed to encode
+                    } else if (this->dutyCycle.consume(airtime)) {
+                        lastRun = millis();
+                        pending = urgent = deferred = readNow = immediate = false;
+                        this->lastSent = data;
+                        this->lastSentValid = true;
+                        this->historyLen = 0;
+                        if (linkCheck) {
+                            this->linkFailures++;  // reset by answer, see onLinkCheck()
+                            this->sendCmd("AT+CLINKCHECK=1");
+                        }
+                        uplinks++;
+
+                        deviceState = SENDING;
+                        Serial.printf("LoRaWAN: sending payload%s...", 
+                            prefs.lorawanConfirm ? " (confirmed)" : "");
+                        snprintf(cmd, sizeof(cmd), "AT+DTRX=%d,3,%zu,%s", 
+                            prefs.lorawanConfirm ? 1 : 0, strlen(payload), payload);
+                        if (this->sendCmd(cmd)) {
+                            Serial.println("OK");
+                            this->ack = 0;
+                            queueStatusMsg("LoRaWAN uplink", 65, false);
+                        } else {
+                            Serial.printf("ERROR");
+                            queueStatusMsg("LoRaWAN failed", 65, true);
+                        }
+                        vTaskDelay(500/portTICK_PERIOD_MS);
+                        this->readDataRate();
+                        // set state back to 'JOINED' if device is online or 'IDLE' if offline
+                        this->joined();
                     }
-                    vTaskDelay(500/portTICK_PERIOD_MS);
-                    // set state back to 'JOINED' if device is online or 'IDLE' if offline
-                    this->joined();
                 }
             }
         }
@@ -362,8 +795,12 @@ void ASR6501::queueTask() {
             loopCounter = 0;
         }
 #endif
-        if (lowBattery)
+        if (lowBattery) {
+            // keep session across deep sleep
+            if (this->deviceState == JOINED)
+                this->saveSession();
             vTaskDelete(NULL);
+        }
         vTaskDelay(1000/portTICK_PERIOD_MS);
     }
 }
@@ -374,37 +811,126 @@ void ASR6501::queueTaskWrapper(void* _this) {
 }
 
 
-// encodes sensor data as CayenneLPP and returns payload as hex string
-const char* ASR6501::encodeLPP(sensorReadings_t data) {
-    static char payload[96];
+// encodes sensor data as CayenneLPP and returns payload as hex string, optional
+// channels (runtime, battery, timestamp) are left out if they exceed 'maxLen'
+const char* ASR6501::encodeLPP(sensorReadings_t data, uint8_t maxLen) {
+    static char payload[128];
+    uint8_t trim = 0;
+
+    fillLPP(lpp, data, Sensors::available(), trim, this->ack);
+    while (lpp.getSize() > maxLen && trim < LORAWAN_LPP_TRIM_MAX)
+        fillLPP(lpp, data, Sensors::available(), ++trim, this->ack);
+
+    if (lpp.getError() || lpp.getSize() > maxLen || ((lpp.getSize() * 2) >= sizeof(payload)-1)) {
+        Serial.println("LoRaWAN: CayenneLPP encoding failed");
+        queueStatusMsg("LoRaWAN encoding", 45, true);
+        return "-";  // empty
+    }
+    if (trim > 0)
+        Serial.printf("LoRaWAN: payload limited to %d bytes, left out optional channels\n", maxLen);
+
+    memset(payload, 0, sizeof(payload));
+    array2string(lpp.getBuffer(), lpp.getSize(), payload);
+    Serial.printf("LoRaWAN: encoded sensor data (%s, %d bytes)\n", payload, lpp.getSize());
+
+    return payload;
+}
+
 
+// add readings of 'sensors' (SENSOR_* flags) to CayenneLPP buffer, skipping the
+// last 'trim' optional channels (timestamp, battery, runtime), the ack is always sent
+void fillLPP(CayenneLPP &lpp, const sensorReadings_t &data, uint8_t sensors, uint8_t trim, uint8_t ack) {
     lpp.reset();
-    if (mlx90614.status())
+    if (sensors & SENSOR_MLX90614)
         lpp.addTemperature(1, data.mlxObjectTemp);
-    if (bme680.status() || sfa30.status())
-        lpp.addRelativeHumidity(2, bme680.status() ? data.bme680Hum : data.sfa30Hum);
-    if (sfa30.status())
+    if (sensors & (SENSOR_BME680 | SENSOR_SFA30))
+        lpp.addRelativeHumidity(2, (sensors & SENSOR_BME680) ? data.bme680Hum : data.sfa30Hum);
+    if (sensors & SENSOR_SFA30)
         lpp.addConcentration(3, data.sfa30HCHO*10); // ppb*10
-    if (bme680.status() > 1) {
+    if ((sensors & SENSOR_BME680) && data.bme680IaqAccuracy >= 1) {
         lpp.addGenericSensor(4, data.bme680Iaq);
         lpp.addConcentration(5, data.bme680eCO2); // ppm
         lpp.addConcentration(6, data.bme680VOC*10); // ppm*10
     }
-    lpp.addGenericSensor(7, SysTime.getRuntimeMinutes());
-    if (M5.Axp.GetBatVoltage() >= 1.0) {
+    if (trim < 3)
+        lpp.addGenericSensor(7, SysTime.getRuntimeMinutes());
+    if (trim < 2 && M5.Axp.GetBatVoltage() >= 1.0) {
         lpp.addPercentage(8, int(M5.Axp.GetBatteryLevel()));
         lpp.addDigitalInput(9, usbPowered());
     }
+    if (trim < 1 && data.timestamp > 0)
+        lpp.addUnixTime(10, data.timestamp / 1000);
+    lpp.addGenericSensor(11, data.sequence & 0xFFFF);  // lower 16 bits, exact as float
+    if (ack)
+        lpp.addDigitalOutput(12, ack);
+}
 
-    if (lpp.getError() || ((lpp.getSize() * 2) >= sizeof(payload)-1)) {
-        Serial.println("LoRaWAN: CayenneLPP encoding failed");
+
+// encodes sensor data bit-packed (see lorapack.h) and returns payload as hex string
+const char* ASR6501::encodePacked(const sensorReadings_t &data, uint8_t maxLen) {
+    static char payload[128];
+    uint8_t buf[LORAWAN_LPP_SIZE];
+    size_t len;
+
+    len = packReadings(data, Sensors::available(), buf, min(sizeof(buf), (size_t)maxLen), this->ack);
+    if (len == 0 || (len * 2) >= sizeof(payload)-1) {
+        Serial.println("LoRaWAN: packed encoding failed");
         queueStatusMsg("LoRaWAN encoding", 45, true);
         return "-";  // empty
     }
-    
+
     memset(payload, 0, sizeof(payload));
-    array2string(lpp.getBuffer(), lpp.getSize(), payload);
-    Serial.printf("LoRaWAN: encoded sensor data (%s, %d bytes)\n", payload, lpp.getSize());
+    array2string(buf, len, payload);
+    Serial.printf("LoRaWAN: encoded sensor data (%s, %zu bytes)\n", payload, len);
+
+    return payload;
+}
+
+
+// keep quantized readings received at 'receivedAt' as history for next batch
+// uplink, samples pass the deadband filter first, so they are at least (not
+// exactly) 'historyStep' secs apart, the oldest sample is dropped if history is full
+void ASR6501::addHistory(const sensorReadings_t &data, time_t receivedAt) {
+    if (this->historyLen > 0 && (receivedAt - this->historyAt[0]) < (this->historyStep * 1000))
+        return;
+    if (this->historyLen < PACKED_BATCH_SAMPLES)
+        this->historyLen++;
+    memmove(&this->history[1], &this->history[0], (this->historyLen - 1) * sizeof(packedSample_t));
+    memmove(&this->historyAt[1], &this->historyAt[0], (this->historyLen - 1) * sizeof(time_t));
+    packSample(data, Sensors::available(), &this->history[0]);
+    this->historyAt[0] = receivedAt;
+}
+
+
+// encodes most recent sensor data (received at 'receivedAt') together with history
+// as bit-packed batch (see lorapack.h) limited to 'maxLen' bytes and returns payload
+// as hex string, gaps between samples are derived from their rounded age to
+// avoid accumulating rounding errors
+const char* ASR6501::encodeBatch(const sensorReadings_t &data, time_t receivedAt, uint8_t maxLen) {
+    static char payload[LORAWAN_BATCH_SIZE*2+1];
+    uint8_t buf[LORAWAN_BATCH_SIZE];
+    uint16_t gaps[PACKED_BATCH_SAMPLES];
+    uint8_t count = this->historyLen;
+    uint32_t age, newer = 0;
+    size_t len;
+
+    for (uint8_t i = 0; i < count; i++) {
+        age = (receivedAt - this->historyAt[i] + 500) / 1000;
+        gaps[i] = min(age - newer, (uint32_t)UINT16_MAX);
+        newer = age;
+    }
+    len = packBatch(data, Sensors::available(), this->history, gaps, &count,
+        buf, min(sizeof(buf), (size_t)maxLen), this->ack);
+    if (len == 0) {
+        Serial.println("LoRaWAN: batch encoding failed");
+        queueStatusMsg("LoRaWAN encoding", 45, true);
+        return "-";  // empty
+    }
+
+    memset(payload, 0, sizeof(payload));
+    array2string(buf, len, payload);
+    Serial.printf("LoRaWAN: encoded sensor data with %d of %d older samples (%s, %zu bytes)\n",
+        count, this->historyLen, payload, len);
 
     return payload;
 }
@@ -448,7 +974,17 @@ bool ASR6501::begin(HardwareSerial* serialPort, uint8_t rxPin, uint8_t txPin) {
     if (this->deviceState != NONE)
         serial->end();
     this->serial->begin(115200, SERIAL_8N1, rxPin, txPin);
-    this->SerialLock = xSemaphoreCreateMutex();
+    if (this->downlinkQueue == NULL)
+        this->downlinkQueue = xQueueCreate(LORAWAN_DOWNLINK_QUEUE, sizeof(lorawanDownlink_t));
+    if (!this->at.begin(this->serial) || this->downlinkQueue == NULL)
+        return this->setupFailed("LoRaWAN: AT parser failed");
+    if (this->deviceState == NONE) {  // unsolicited results from adapter
+        this->at.onURC("+CJOIN:", this->onJoin, this);
+        this->at.onURC("+CSTATUS", this->onStatus, this);
+        this->at.onURC("ERR+SENT", this->onSendFailed, this);
+        this->at.onURC("OK+RECV:", this->onDownlink, this);
+        this->at.onURC("+CLINKCHECK:", this->onLinkCheck, this);
+    }
 
     M5.Lcd.clearDisplay(BLUE);
     M5.Lcd.setTextColor(WHITE);
@@ -465,103 +1001,38 @@ bool ASR6501::begin(HardwareSerial* serialPort, uint8_t rxPin, uint8_t txPin) {
     }
     delay(500);
 
-    M5.Lcd.setCursor(20, 65);
-    M5.Lcd.print("Restore defaults...");
-    Serial.print("LoRaWAN: restore defaults, reboot...");
-    if (strstr(this->sendCmd("AT+CRESTORE"), "OK") != NULL &&
-        strstr(this->sendCmd("AT+CSAVE"), "OK") != NULL &&
-        strstr(this->sendCmd("AT+IREBOOT=0"), "OK")) {
-        M5.Lcd.print("OK");
-        Serial.println("OK");
-    } else {
-        return this->setupFailed("ERROR");
-    }
-    delay(500);
-
-    M5.Lcd.setCursor(20, 95);
-    M5.Lcd.print("Configure OTAA...");
-    Serial.print("LoRaWAN: configure OTAA...");
-    if (this->setOTAA(prefs.lorawanAppEUI, prefs.lorawanAppKey)) {  
-        M5.Lcd.print("OK");
-        Serial.println("OK");
-    } else {
-        return this->setupFailed("ERROR");
-    }
-    delay(500);
-
-    M5.Lcd.setCursor(20, 125);
-    M5.Lcd.print("Enable ADR, class C...");
-    Serial.print("LoRaWAN: enable ADR, set class C mode...");
-    if (strstr(this->sendCmd("AT+CCLASS=2"), "OK") != NULL &&  // 0: Class A, 1: Class B, 2: Class C
-        strstr(this->sendCmd("AT+CADR=1"), "OK") != NULL) {  // ADR
-        M5.Lcd.print("OK");
-        Serial.println("OK");
-    } else {
-        return this->setupFailed("ERROR");
-    }
-    delay(500);
-
-    // 868 MHz, channels 0-7, RX2: 869.525MHz on SF9BW125
-    M5.Lcd.setCursor(20, 155);
-    M5.Lcd.print("Set 8 channels, RX2...");
-    Serial.print("LoRaWAN: configure 8 channels, RX2 window...");
-    if (strstr(this->sendCmd("AT+CWORKMODE=2"), "OK") != NULL &&
-        strstr(this->sendCmd("AT+CFREQBANDMASK=0001"), "OK") != NULL &&
-        strstr(this->sendCmd("AT+CRXP=0,0,869525000"), "OK") != NULL) {
-        M5.Lcd.print("OK");
-        Serial.println("OK");
-    } else {
-        return this->setupFailed("ERROR");
-    }
-    delay(500);
-
-    M5.Lcd.setCursor(20, 185);
-    M5.Lcd.printf("%s confirm data...", prefs.lorawanConfirm ? "Enable" : "Disable");
-    Serial.printf("LoRaWAN: %s confirm data transmission...", prefs.lorawanConfirm ? "enable" : "disable");
-    if (prefs.lorawanConfirm) {
-        if (strstr(this->sendCmd("AT+CCONFIRM=1"), "OK") != NULL &&
-            strstr(this->sendCmd("AT+CNBTRIALS=1,3"), "OK") != NULL) {
-            M5.Lcd.print("OK");
-            Serial.println("OK");
-        } else {
-            return this->setupFailed("ERROR");
+    // a full setup includes a join, skip it if the adapter has kept its settings
+    // and session (e.g. after a brown-out of the ESP32 or deep sleep)
+    if (this->configured()) {
+        M5.Lcd.setCursor(20, 65);
+        M5.Lcd.print("Settings unchanged");
+        Serial.println("LoRaWAN: adapter settings unchanged, setup skipped");
+        this->deviceState = IDLE;
+        if (this->resumeSession()) {
+            Serial.println("LoRaWAN: session still active, join skipped");
+            queueStatusMsg("LoRaWAN joined", 60, false);
         }
+    } else if (this->configure()) {
+        this->deviceState = IDLE;
     } else {
-        if (strstr(this->sendCmd("AT+CCONFIRM=0"), "OK") != NULL &&
-            strstr(this->sendCmd("AT+CNBTRIALS=0,1"), "OK") != NULL) {
-            M5.Lcd.print("OK");
-            Serial.println("OK");
-        } else {
-            return this->setupFailed("ERROR");
-        }
+        return false;
     }
-    delay(500);
-
-    if (strstr(this->sendCmd("AT+CSAVE"), "OK") == NULL)
-        return this->setupFailed("ERROR");
-    this->deviceState = IDLE;
 
     M5.Lcd.setCursor(20, 215);
-    M5.Lcd.print("Joining network...");
+    M5.Lcd.print(this->deviceState == JOINED ? "Joined network" : "Joining network...");
 
     // join LoRaWAN network, deviceState is 'JOINED' if successful and 'IDLE' if failed
     xTaskCreatePinnedToCore(this->joinTaskWrapper,
         "joinTask", 2560, this, 10, &this->joinTaskHandle, 0);
 
     // start checking send queue for sensor data
+    // a batch needs each sample, without it only the most recent one is sent
+    if (prefs.lorawanBatch)
+        this->busId = Bus.subscribe("lorawan", LORAWAN_BATCH_QUEUE, DROP_OLDEST);
+    else
+        this->busId = Bus.subscribe("lorawan", 1, LATEST_ONLY);
     xTaskCreatePinnedToCore(this->queueTaskWrapper,
         "queueTask", 2560, this, 10, &this->queueTaskHandle, 1);
 
     return true;
 }
-
-
-// place current sensor reading in send queue
-bool ASR6501::queue(sensorReadings_t data) {
-    if (this->deviceState == JOINED) {
-        Serial.println("LoRaWAN: queuing sensor data");
-        return (xQueueOverwrite(this->msgQueue, (void*)&data) == pdTRUE);
-    } else {
-        return false;
-    }
-}
\ No newline at end of file
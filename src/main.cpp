@@ -24,6 +24,8 @@
 #include "mqtt.h"
 #include "rtc.h"
 #include "sensors.h"
+#include "bus.h"
+#include "deadband.h"
 #include "prefs.h"
 #include "ble.h"
 #include "lorawan.h"
@@ -55,6 +57,7 @@ void setup() {
     displayPowerStatus(true);
 
     WifiUplink.begin();
+    Deadband.configure(prefs.deadband);  // after changes in the config portal
     SysTime.begin();
     if (!Publisher.begin())
         Publisher.~MQTT();
@@ -71,45 +74,54 @@ void setup() {
 
 void loop() {
     static time_t lastReading = 0, lastMqttPublish = 0;
+    sensorReadings_t sample;
+    bool requested;
 
     M5.update();
-    bme680.read(); // calculates readings every 3 seconds and calibrates sensors
 
-    // read sensor data every READING_INTERVAL_SEC
-    if (tsDiff(lastReading) > (prefs.readingsIntervalSecs * 1000)) {
+    // read sensor data every READING_INTERVAL_SEC or if requested by a consumer
+    requested = Sensors::readingRequested();
+    if (requested || tsDiff(lastReading) > (prefs.readingsIntervalSecs * 1000)) {
         lastReading = millis();
         mlx90614.read();
         sfa30.read();
+        bme680.read(); // latest outputs of the BSEC task (every 3 or 300 secs)
+        bme680.checkPower(); // BSEC sampling profile
         displayPowerStatus(false);
 
+        // publish complete set of readings for all consumers
+        readings.timestamp = SysTime.getEpochMillis();
+        readings.sequence++;
+        Snapshot.publish(&readings);
+        Snapshot.read(&sample);
+
         // display and publish sensor readings on significant changes
-        // or if mqtt publishing interval has passed
-        if (mlx90614.changed() || sfa30.changed() || bme680.changed() || Publisher.schedule()) {
+        // or if nothing has been published for 'mqttIntervalSecs'
+        if (Deadband.check(sample) || requested) {
 
             // display full screen warning message every BATTERY_LEVEL_INTERVAL_SECS
             // when battery level is below BATTERY_WARNING_LEVEL
             lowBatteryCheck();
 
-            mlx90614.display();  // sets initial LCD screen layout
-            mlx90614.console();
+            mlx90614.display(sample);  // sets initial LCD screen layout
+            mlx90614.console(sample);
 
-            sfa30.display();
-            sfa30.console();
+            sfa30.display(sample);
+            sfa30.console(sample);
 
-            bme680.display();
-            bme680.console();
+            bme680.display(sample);
+            bme680.console(sample);
 
             updateStatusBar();
 
-            // send off current sensor data (MQTT, BLE, LoRaWAN)
-            GATT.notify(readings);
-            Publisher.queue(readings);
-            LoRaWAN.queue(readings);
+            // hand current sensor data to all subscribed transports (MQTT, BLE, LoRaWAN)
+            Bus.publish(&sample);
         }
     }
 
     // update Date/Time in status line on bottom of the screen
     updateStatusBar();
+    Bus.console();
 
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
     printFreeHeap();
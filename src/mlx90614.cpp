@@ -75,34 +75,19 @@ bool MLX90614::read() {
 }
 
 
-// returns true if temperature of object in focus has changed significantly
-bool MLX90614::changed() {
-    static float lastObjTemp = 0.0;
-    bool changed = false;
-
-    if (!this->status())
-        return false;
-    if (abs(lastObjTemp - readings.mlxObjectTemp) >= TEMP_PUBLISH_THRESHOLD)
-        changed = true;
-    lastObjTemp = readings.mlxObjectTemp;
-
-    return changed;
-}
-
-
 // display MLX90614 readings on M5 Tough's OLED display
-void MLX90614::display() {
+void MLX90614::display(const sensorReadings_t &data) {
     uint16_t color = BLUE;
 
-    if (readings.mlxObjectTemp <= TEMP_THRESHOLD_CYAN)
+    if (data.mlxObjectTemp <= TEMP_THRESHOLD_CYAN)
         color = NAVY;
-    else if (readings.mlxObjectTemp >= TEMP_THRESHOLD_RED)
+    else if (data.mlxObjectTemp >= TEMP_THRESHOLD_RED)
         color = RED;
-    else if (readings.mlxObjectTemp >= TEMP_THRESHOLD_ORANGE)
+    else if (data.mlxObjectTemp >= TEMP_THRESHOLD_ORANGE)
         color = ORANGE;
-    else if (readings.mlxObjectTemp >= TEMP_THRESHOLD_GREEN)
+    else if (data.mlxObjectTemp >= TEMP_THRESHOLD_GREEN)
         color = DARKGREEN;
-    else if (readings.mlxObjectTemp >= TEMP_THRESHOLD_CYAN)
+    else if (data.mlxObjectTemp >= TEMP_THRESHOLD_CYAN)
         color = DARKCYAN;
 
     M5.Lcd.fillRect(0, 0, 320, 205, color);
@@ -110,7 +95,7 @@ void MLX90614::display() {
     M5.Lcd.setFreeFont(&FreeSansBold36pt7b);
     M5.Lcd.setCursor(65, 70);
     if (this->status()) {
-        M5.Lcd.print(readings.mlxObjectTemp, 1);
+        M5.Lcd.print(data.mlxObjectTemp, 1);
     } else {
         M5.Lcd.setCursor(85, 70);
         M5.Lcd.print("n/a");
@@ -123,23 +108,23 @@ void MLX90614::display() {
     M5.Lcd.print("Ambiant: ");
     if (!bme680.status()) { // prefer BME680 for ambient temperature reading
         if (this->status())
-            M5.Lcd.print(readings.mlxAmbientTemp, 1);
+            M5.Lcd.print(data.mlxAmbientTemp, 1);
         else
             M5.Lcd.print("n/a");
     } else {
-        M5.Lcd.print(readings.bme680Temp, 1);
+        M5.Lcd.print(data.bme680Temp, 1);
     }
 }
 
 
 // print sensor status/readings on serial console
-void MLX90614::console() {
+void MLX90614::console(const sensorReadings_t &data) {
     Serial.print("MLX90614: ");
     if (this->status()) {
         Serial.print("objectTemperature(");
-        Serial.print(readings.mlxObjectTemp, 1);
+        Serial.print(data.mlxObjectTemp, 1);
         Serial.print(" C), ambientTemperature(");
-        Serial.print(readings.mlxAmbientTemp, 1);
+        Serial.print(data.mlxAmbientTemp, 1);
         Serial.println(" C)");
     } else {
         Serial.println("sensor not ready!");
@@ -28,50 +28,146 @@
 #include "display.h"
 
 MQTT Publisher;
+
+// readings announced via Home Assistant MQTT discovery
+static const haSensor_t HASensors[] = {
+    { "objectTemp", "Object Temperature", "°C", "temperature" },
+    { "ambientTemp", "Ambient Temperature", "°C", "temperature" },
+    { "hcho", "Formaldehyde", "ppb", NULL },
+    { "humidity", "Humidity", "%", "humidity" },
+    { "gasResistance", "Gas Resistance", "kΩ", NULL },
+    { "iaqAccuracy", "IAQ Accuracy", NULL, NULL },
+    { "iaq", "Indoor Air Quality", NULL, "aqi" },
+    { "VOC", "VOC", "ppm", "volatile_organic_compounds_parts" },
+    { "eCO2", "eCO2", "ppm", "carbon_dioxide" }
+};
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
-UBaseType_t stackMqttPublishTask;
+UBaseType_t stackMqttPublishTask, stackMqttConnTask;
 #endif
 
 
-MQTT::MQTT() {
-    this->msgQueue = xQueueCreate(1, sizeof(sensorReadings_t));
-    this->mqtt.setClient(this->espClient);
+MQTT::MQTT() : ackClient(espClient) {
+    this->busId = -1;
+    this->mqtt.setClient(this->ackClient);
+    this->clientLock = xSemaphoreCreateMutex();
+    this->brokerResolved = false;
+    this->sessionUp = false;
+    this->connectCount = 0;
+    this->disconnectCount = 0;
+    this->connectFails = 0;
+    this->clientId[0] = '\0';
     this->publishTaskHandle = NULL;
-    this->lastPublished = 0;
+    this->connTaskHandle = NULL;
+    this->retryTime = 0;
+    this->oversized = false;
+    this->batchStarted = 0;
+    this->batchCount = 0;
+    this->inflightCount = 0;
+    this->inflightRecords = 0;
+    this->inflightSession = 0;
+    this->backlogDropped = 0;
+    this->packetId = 0;
+    this->ackCount = 0;
+    this->ackLatencyMax = 0;
+    this->ackLatencySum = 0;
+    this->resendCount = 0;
+    this->lastKeyframe = 0;
+    this->deltaState.valid = 0;
+    this->fieldsState.valid = 0;
+    this->discoverySession = 0;
+    this->fieldsSession = 0;
+    this->statusTopic[0] = '\0';
+    this->lastReadingsValid = false;
+    this->bdSeq = 0;
+    this->sparkplugSeq = 0;
 }
 
 
 MQTT::~MQTT() {
-    vQueueDelete(this->msgQueue);
-    this->msgQueue = NULL;
+    Bus.unsubscribe(this->busId);
+    this->busId = -1;
     if (this->publishTaskHandle != NULL)
         vTaskDelete(this->publishTaskHandle);
+    if (this->connTaskHandle != NULL)
+        vTaskDelete(this->connTaskHandle);
     if (this->mqtt.connected())
         this->mqtt.disconnect();
     this->espClient.~WiFiClient();
 }
 
 
-// connect to MQTT broker with random client id
+// resolve broker's hostname once and keep its address, PubSubClient
+// would otherwise query the DNS server on every connection attempt
+bool MQTT::resolveBroker() {
+    if (this->brokerResolved)
+        return true;
+    if (!this->brokerIP.fromString(prefs.mqttBroker) &&
+            !WiFi.hostByName(prefs.mqttBroker, this->brokerIP)) {
+        Serial.printf("MQTT: failed to resolve %s\n", prefs.mqttBroker);
+        return false;
+    }
+    this->mqtt.setServer(this->brokerIP, prefs.mqttBrokerPort);
+    this->brokerResolved = true;
+    return true;
+}
+
+
+// connect to MQTT broker with client id derived from system id,
+// the broker can thus take over the previous session after a reset
 bool MQTT::connect(bool startup) {
-  static char clientid[16];
-  
-  if (!mqtt.connected()) {
-    // generate pseudo random client id
-    snprintf(clientid, sizeof(clientid), "M5Tough_%lx", random(0xffff));
-    Serial.printf("MQTT: connecting to MQTT Broker %s as %s...", prefs.mqttBroker, clientid);
-
-#ifdef MQTT_USER
-    if (mqtt.connect(clientid, prefs.mqttUsername, prefs.mqttPassword)) {
-#else
-    if (mqtt.connect(clientid)) {
-#endif
-      Serial.println("OK");
-      return true;
+    char deathTopic[SPARKPLUG_TOPIC_SIZE], deathPayload[SPARKPLUG_DEATH_SIZE];
+    const char *willTopic = NULL, *willMsg = "offline";
+    uint8_t willQos = 0;
+    bool connected;
+
+    if (mqtt.connected())
+        return true;
+
+    if (!this->clientId[0])
+        snprintf(this->clientId, sizeof(this->clientId), "M5Tough_%s", getSystemID());
+    Serial.printf("MQTT: connecting to MQTT Broker %s as %s...", prefs.mqttBroker, this->clientId);
+
+    // broker publishes retained 'offline' to availability topic if connection is lost
+    if (prefs.mqttFieldTopics && !this->statusTopic[0])
+        snprintf(this->statusTopic, sizeof(this->statusTopic), "%s/status", prefs.mqttTopic);
+    if (this->statusTopic[0])
+        willTopic = this->statusTopic;
+
+    // Sparkplug host applications are notified by NDEATH instead, bdSeq
+    // changes with each CONNECT, 0 is skipped since the will is passed
+    // as string and its payload must not contain any zero bytes
+    this->bdSeq = this->bdSeq < 255 ? this->bdSeq + 1 : 1;
+    if (prefs.mqttSparkplug && this->encodeDeath(deathPayload, sizeof(deathPayload)) > 0) {
+        sparkplugTopic(deathTopic, sizeof(deathTopic), prefs.sparkplugGroup, "NDEATH", this->clientId);
+        willTopic = deathTopic;
+        willMsg = deathPayload;
+        willQos = 1;
+    }
 
-    } else {
-      Serial.printf("failed (error %d)\n", mqtt.state());
-      if (startup) {
+    if (!this->resolveBroker())
+        connected = false;
+    else
+        connected = mqtt.connect(this->clientId,
+            prefs.mqttEnableAuth ? prefs.mqttUsername : NULL,
+            prefs.mqttEnableAuth ? prefs.mqttPassword : NULL,
+            willTopic, willQos, !prefs.mqttSparkplug, willMsg);
+
+    if (connected) {
+        Serial.println("OK");
+        if (this->statusTopic[0])
+            mqtt.publish(this->statusTopic, "online", true);
+        if (prefs.mqttSparkplug && !this->publishBirth())
+            Serial.println("MQTT: failed to publish Sparkplug NBIRTH");
+        this->connectCount++;
+        this->connectFails = 0;
+        this->sessionUp = true;
+        return true;
+    }
+
+    Serial.printf("failed (error %d)\n", mqtt.state());
+    if (++this->connectFails >= MQTT_DNS_RETRY_FAILS)
+        this->brokerResolved = false;  // broker might have moved
+    if (startup) {
         M5.Lcd.clearDisplay(RED);
         M5.Lcd.setTextColor(WHITE);
         M5.Lcd.setCursor(55,85);
@@ -81,19 +177,86 @@ bool MQTT::connect(bool startup) {
         M5.Lcd.setTextDatum(MC_DATUM);
         M5.Lcd.drawString(prefs.mqttBroker, 160, 160, 4);
         delay(3000);
-      }
-      return false;
     }
-  }
+    return false;
+}
 
-  return true;
+
+// take the client lock for publishing, connectionTask holds it while a
+// (re)connect blocks for seconds, so give up after MQTT_LOCK_WAIT_MS
+bool MQTT::lockClient() {
+    return xSemaphoreTake(this->clientLock, MQTT_LOCK_WAIT_MS / portTICK_PERIOD_MS) == pdTRUE;
+}
+
+
+// background task keeping the connection to the broker alive, services
+// keep-alive pings and reconnects with exponential backoff and jitter to
+// spread reconnects of many devices after a broker restart
+void MQTT::connectionTask() {
+    uint32_t backoff = MQTT_BACKOFF_MIN_MS;
+    uint32_t nextAttempt = millis();
+    UBaseType_t stackLowest = MQTT_STACK_MIN_FREE;
+#ifdef MEMORY_DEBUG_INTERVAL_SECS
+    uint16_t loopCounter = 0;
+#endif
+
+    while (true) {
+        xSemaphoreTake(this->clientLock, portMAX_DELAY);
+        if (mqtt.connected()) {
+            mqtt.loop();
+        } else {
+            if (this->sessionUp) {
+                this->sessionUp = false;
+                this->disconnectCount++;
+                backoff = MQTT_BACKOFF_MIN_MS;
+                nextAttempt = millis() + random(backoff);
+                Serial.printf("MQTT: connection lost (state %d)\n", mqtt.state());
+            }
+            if (WiFi.isConnected() && (int32_t)(millis() - nextAttempt) >= 0) {
+                if (this->connect(false)) {
+                    backoff = MQTT_BACKOFF_MIN_MS;
+                } else {
+                    // wait between backoff/2 and backoff, double backoff for next attempt
+                    nextAttempt = millis() + backoff/2 + random(backoff/2);
+                    Serial.printf("MQTT: next attempt in %d secs\n", (int)(nextAttempt - millis()) / 1000);
+                    backoff = min(backoff * 2, (uint32_t)MQTT_BACKOFF_MAX_MS);
+                }
+            }
+        }
+        xSemaphoreGive(this->clientLock);
+        checkStackWatermark("mqttConnTask", MQTT_STACK_MIN_FREE, &stackLowest);
+#ifdef MEMORY_DEBUG_INTERVAL_SECS
+        if (loopCounter++ >= (MEMORY_DEBUG_INTERVAL_SECS * 1000 / MQTT_LOOP_INTERVAL_MS)) {
+            stackMqttConnTask = printFreeStackWatermark("mqttConnTask");
+            loopCounter = 0;
+        }
+#endif
+        if (lowBattery)
+            vTaskDelete(NULL);
+        vTaskDelay(MQTT_LOOP_INTERVAL_MS/portTICK_PERIOD_MS);
+    }
+}
+
+
+void MQTT::connectionTaskWrapper(void* _this) {
+    static_cast<MQTT*>(_this)->connectionTask();
+}
+
+
+uint32_t MQTT::connects() {
+    return this->connectCount;
+}
+
+
+uint32_t MQTT::disconnects() {
+    return this->disconnectCount;
 }
 
 
 // setup MQTT client and try to connect to MQTT broker
 bool MQTT::begin() {
     mqtt.setServer(prefs.mqttBroker, prefs.mqttBrokerPort);
-    mqtt.setBufferSize(384);
+    mqtt.setKeepAlive(MQTT_KEEPALIVE_SECS);
 
     M5.Lcd.clearDisplay(BLUE);
     M5.Lcd.setTextColor(WHITE);
@@ -105,8 +268,15 @@ bool MQTT::begin() {
         delay(1500);
     }
 
-    // start checking the MQTT message queue to publish sensor readings
-    if (xTaskCreatePinnedToCore(this->publishTaskWrapper, "mqttTask", 3072,
+    // readings are buffered in flash while the broker is unreachable
+    Backlog.begin();
+    this->busId = Bus.subscribe("mqtt", MQTT_QUEUE_DEPTH, DROP_OLDEST);
+
+    // keep connection alive and check the MQTT message queue to publish sensor readings
+    if (this->busId < 0 || this->clientLock == NULL ||
+            xTaskCreatePinnedToCore(this->connectionTaskWrapper, "mqttConnTask", MQTT_CONN_TASK_STACK,
+                this, 10, &this->connTaskHandle, 0) != pdTRUE ||
+            xTaskCreatePinnedToCore(this->publishTaskWrapper, "mqttTask", MQTT_TASK_STACK,
                 this, 10, &this->publishTaskHandle, 0) != pdTRUE) {
         Serial.println("MQTT: failed to start background task, service disabled");
         M5.Lcd.clearDisplay(RED);
@@ -126,93 +296,691 @@ bool MQTT::begin() {
 }
 
 
-// returns true if sensor readings have been published
-bool MQTT::publish(sensorReadings_t data) {
-    StaticJsonDocument<384> JSON;
-    static char topic[64], buf[336], statusMsg[32];
+// returns true if field has to be sent with a delta payload, i.e. its value
+// or availability has changed since last sent, fields not bound to a sensor
+// (timestamp, sequence number) are always sent
+bool MQTT::fieldChanged(uint8_t index, uint8_t sensors, const sensorReadings_t &data, const deltaState_t *state) {
+    const sensorField_t *field = &SensorSchema[index];
+    bool known = state->valid & (1UL << index);
+    int64_t delta;
+
+    if (!fieldAvailable(field, sensors, data))
+        return known;
+    if (!known || field->sensor == 0)
+        return true;
+    delta = abs(fieldValue(field, data) - state->value[index]);
+    return (delta > 0 && delta >= Deadband.threshold(field));
+}
 
-    if (!WiFi.isConnected())
-        return false;
 
-    JSON.clear();
-    JSON["systemId"] = getSystemID();
-    if (mlx90614.status()) {
-        JSON["objectTemp"] = int(data.mlxObjectTemp*10)/10.0;
-        JSON["ambientTemp"] = int(data.mlxAmbientTemp*10)/10.0;
-    }
-    if (sfa30.status())
-        JSON["hcho"] = int(data.sfa30HCHO*10)/10.0;
-    if (bme680.status()) {
-        JSON["humidity"] = data.bme680Hum; // 0-100%
-        JSON["gasResistance"] = data.bme680GasResistance; // kOhms
-        JSON["iaqAccuracy"] = data.bme680IaqAccuracy; // 0-3
-        if (data.bme680IaqAccuracy >= 1) {
-            JSON["iaq"] = data.bme680Iaq; // 0-500
-            JSON["VOC"] = int(data.bme680VOC*10)/10.0; // ppm
-            JSON["eCO2"] = data.bme680eCO2; // ppm
-        }
-    }
-    JSON["rssi"] = WiFi.RSSI();
-    JSON["wifiCons"] = WifiUplink.wifiReconnectSuccess + WifiUplink.wifiReconnectFail;
+// add available fields of a single set of sensor readings, only changed
+// fields (or null if a field became unavailable) unless keyframe is set,
+// sent values are recorded in state if given
+void MQTT::addReadings(JsonWriter &json, uint8_t sensors, const sensorReadings_t &data,
+        deltaState_t *state, bool keyframe) {
+    const sensorField_t *field;
+
+    for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+        field = &SensorSchema[i];
+        if (!keyframe && !this->fieldChanged(i, sensors, data, state))
+            continue;
+        if (fieldAvailable(field, sensors, data)) {
+            json.addNumber(field->key, fieldValue(field, data), field->decimals);
+            if (state != NULL) {
+                state->value[i] = fieldValue(field, data);
+                state->valid |= (1UL << i);
+            }
+        } else if (!keyframe) {
+            json.addNull(field->key);
+            state->valid &= ~(1UL << i);
+        }
+    }
+}
+
+
+// add current device status
+void MQTT::addStatus(JsonWriter &json) {
+    json.addNumber("rssi", WiFi.RSSI());
+    json.addNumber("wifiCons", WifiUplink.wifiReconnectSuccess + WifiUplink.wifiReconnectFail);
+    json.addNumber("mqttCons", this->connectCount);
+    json.addNumber("mqttDiscons", this->disconnectCount);
+    if (this->qos() > 0) {
+        json.addNumber("acks", this->ackCount);
+        json.addNumber("ackAvgMs", this->ackCount ? this->ackLatencySum / this->ackCount : 0);
+        json.addNumber("ackMaxMs", this->ackLatencyMax);
+        json.addNumber("resends", this->resendCount);
+    }
     if (M5.Axp.GetBatVoltage() >= 1.0) {
-        JSON["batLevel"] = int(M5.Axp.GetBatteryLevel());
-        JSON["usbPower"] = usbPowered() ? 1 : 0;
+        json.addNumber("batLevel", int(M5.Axp.GetBatteryLevel()));
+        json.addNumber("usbPower", usbPowered() ? 1 : 0);
     }
-    JSON["runtime"] = SysTime.getRuntimeMinutes();
+    json.addNumber("runtime", SysTime.getRuntimeMinutes());
 
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
-    JSON["heap"] = ESP.getFreeHeap();
-    JSON["joinTask"] = stackWmJoinTask;
-    JSON["queueTask"] = stackWmQueueTask;
-    JSON["wifiTask"] = stackWmWifiTask;
-    JSON["ntpTask"] = stackWmNtpTask;
-    JSON["mqttTask"] = stackMqttPublishTask;
+    json.addNumber("heap", ESP.getFreeHeap());
+    json.addNumber("joinTask", stackWmJoinTask);
+    json.addNumber("queueTask", stackWmQueueTask);
+    json.addNumber("wifiTask", stackWmWifiTask);
+    json.addNumber("ntpTask", stackWmNtpTask);
+    json.addNumber("mqttTask", stackMqttPublishTask);
+    json.addNumber("mqttConnTask", stackMqttConnTask);
 #endif
-    JSON["version"] = FIRMWARE_VERSION;
-
-    memset(buf, 0, sizeof(buf));
-    size_t s = serializeJson(JSON, buf);
-    if (this->connect(false)) {
-        snprintf(topic, sizeof(topic)-1, "%s", MQTT_TOPIC);
-        if (mqtt.publish(topic, buf, s)) {
-            Serial.printf("MQTT: published %d bytes to %s on %s\n", s,
-                prefs.mqttTopic, prefs.mqttBroker);
+}
+
+
+// serialize readings as JSON to given buffer, returns length or 0 if
+// buffer is too small, a single set of readings is encoded as flat object,
+// several sets either as array of samples or columnar with one array per
+// field (null if a value is missing) sharing systemId, version and status,
+// if a delta state is given only fields changed since then are encoded
+// (flagged with "delta") unless state is empty (keyframe), state is updated
+size_t MQTT::encode(const sensorReadings_t *data, uint8_t count, uint8_t sensors, char *buf, size_t size,
+        deltaState_t *state) {
+    JsonWriter json(buf, size);
+    const sensorField_t *field;
+    bool keyframe = (state == NULL || state->valid == 0);
+    bool changed;
+
+    json.beginObject();
+    json.addString("systemId", getSystemID());
+    if (!keyframe)
+        json.addNumber("delta", 1);
+    if (count == 1) {
+        this->addReadings(json, sensors, data[0], state, keyframe);
+        if (keyframe) {
+            this->addStatus(json);
+            json.addString("version", FIRMWARE_VERSION);
+        }
+    } else {
+        if (keyframe) {
+            this->addStatus(json);
+            json.addString("version", FIRMWARE_VERSION);
+        }
+        if (prefs.mqttBatchColumnar) {
+            for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+                field = &SensorSchema[i];
+                if (!fieldEnabled(field, sensors))
+                    continue;
+                // delta payloads carry the whole column if any value has changed
+                changed = keyframe;
+                for (uint8_t j = 0; j < count && !changed; j++)
+                    changed = this->fieldChanged(i, sensors, data[j], state);
+                if (!changed)
+                    continue;
+                json.beginArray(field->key);
+                for (uint8_t j = 0; j < count; j++) {
+                    if (fieldAvailable(field, sensors, data[j]))
+                        json.addNumber(NULL, fieldValue(field, data[j]), field->decimals);
+                    else
+                        json.addNull();
+                }
+                json.endArray();
+                if (state != NULL && fieldAvailable(field, sensors, data[count-1])) {
+                    state->value[i] = fieldValue(field, data[count-1]);
+                    state->valid |= (1UL << i);
+                } else if (state != NULL) {
+                    state->valid &= ~(1UL << i);
+                }
+            }
+        } else {
+            json.beginArray("samples");
+            for (uint8_t j = 0; j < count; j++) {
+                json.beginObject();
+                this->addReadings(json, sensors, data[j], state, keyframe);
+                json.endObject();
+            }
+            json.endArray();
+        }
+    }
+    json.endObject();
+
+    return json.overflowed() ? 0 : json.length();
+}
+
+
+// serialize readings as Sparkplug B NDATA payload with the next sequence
+// number, metrics are referenced by their alias declared with NBIRTH, a
+// single sample's timestamp is sent as payload timestamp, metrics of several
+// samples carry their own, returns length or 0 if buffer is too small, if
+// a delta state is given only changed fields are encoded (see encode())
+size_t MQTT::encodeSparkplug(const sensorReadings_t *data, uint8_t count, uint8_t sensors, uint8_t *buf,
+        size_t size, deltaState_t *state) {
+    SparkplugPayload payload(buf, size, (count == 1 && data[0].timestamp > 0) ?
+        data[0].timestamp : SysTime.getEpochMillis());
+    const sensorField_t *field;
+    bool keyframe = (state == NULL || state->valid == 0);
+
+    for (uint8_t j = 0; j < count; j++) {
+        for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+            field = &SensorSchema[i];
+            if (!sparkplugMetric(i) || !fieldEnabled(field, sensors))
+                continue;
+            if (!keyframe && !this->fieldChanged(i, sensors, data[j], state))
+                continue;
+            if (fieldAvailable(field, sensors, data[j])) {
+                payload.addField(i, data[j], true, false, count > 1 ? data[j].timestamp : 0);
+                if (state != NULL) {
+                    state->value[i] = fieldValue(field, data[j]);
+                    state->valid |= (1UL << i);
+                }
+            } else if (!keyframe) {
+                payload.addField(i, data[j], false, false, count > 1 ? data[j].timestamp : 0);
+                state->valid &= ~(1UL << i);
+            }
+        }
+    }
+    return payload.finish((uint8_t)(this->sparkplugSeq + 1));
+}
+
+
+// serialize readings as SenML pack (JSON or CBOR) with one record per
+// field and sample grouped by field, fields without unit first (see
+// SenmlWriter), the system id prefixes the field names and the first
+// sample's timestamp is sent as base time, records of following samples
+// carry their time relative to it, the sequence number isn't sent since
+// consumers would take it as a sensor, returns length or 0 if buffer is too
+// small, if a delta state is given only changed fields are encoded (see encode())
+size_t MQTT::encodeSenml(const sensorReadings_t *data, uint8_t count, uint8_t sensors, uint8_t *buf,
+        size_t size, bool cbor, deltaState_t *state) {
+    static char baseName[16];
+    SenmlWriter senml(buf, size, cbor);
+    const sensorField_t *field;
+    bool keyframe = (state == NULL || state->valid == 0);
+
+    snprintf(baseName, sizeof(baseName), "%s:", getSystemID());
+    senml.begin(baseName, data[0].timestamp);
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+            field = &SensorSchema[i];
+            if (field->sensor == 0)  // timestamp and sequence number aren't measurements
+                continue;
+            if ((SenmlWriter::unit(field->key) != NULL) != (pass > 0))
+                continue;
+            for (uint8_t j = 0; j < count; j++) {
+                if (!keyframe && !this->fieldChanged(i, sensors, data[j], state))
+                    continue;
+                if (fieldAvailable(field, sensors, data[j])) {
+                    senml.addRecord(field->key, fieldValue(field, data[j]), field->decimals,
+                        (data[0].timestamp > 0 && data[j].timestamp > 0) ? data[j].timestamp - data[0].timestamp : 0);
+                    if (state != NULL) {
+                        state->value[i] = fieldValue(field, data[j]);
+                        state->valid |= (1UL << i);
+                    }
+                } else if (state != NULL) {
+                    state->valid &= ~(1UL << i);
+                }
+            }
+        }
+    }
+    return senml.end();
+}
+
+
+// returns true if sensor readings have been published, sent
+// with QoS 1 and given packet id unless packetId is 0
+bool MQTT::publish(const sensorReadings_t *data, uint8_t count, uint16_t packetId, bool duplicate) {
+    static char topic[SPARKPLUG_TOPIC_SIZE];
+    deltaState_t state = this->deltaState;
+    size_t len = 0;
+    bool published = false, keyframe;
+
+    this->oversized = false;
+    if (!WiFi.isConnected())
+        return false;
+
+    // send all fields and status periodically so consumers can resynchronize
+    if (tsDiff(this->lastKeyframe) >= (prefs.mqttKeyframeSecs * 1000))
+        state.valid = 0;
+    keyframe = (state.valid == 0);
+
+    // connection is (re)established by connectionTask, never block here,
+    // readings are kept in the backlog if it is still connecting
+    if (!this->lockClient())
+        return false;
+    if (mqtt.connected()) {
+        // encoded while holding the lock since NBIRTH resets the sequence number
+        if (prefs.mqttSparkplug) {
+            len = this->encodeSparkplug(data, count, Sensors::available(), (uint8_t*)this->payload,
+                sizeof(this->payload), prefs.mqttDeltaPayload ? &state : NULL);
+            sparkplugTopic(topic, sizeof(topic), prefs.sparkplugGroup, "NDATA", this->clientId);
+        } else if (prefs.mqttSenml != SENML_OFF) {
+            len = this->encodeSenml(data, count, Sensors::available(), (uint8_t*)this->payload,
+                sizeof(this->payload), prefs.mqttSenml == SENML_CBOR, prefs.mqttDeltaPayload ? &state : NULL);
+            snprintf(topic, sizeof(topic)-1, "%s", prefs.mqttTopic);
+        } else {
+            len = this->encode(data, count, Sensors::available(), this->payload, sizeof(this->payload),
+                prefs.mqttDeltaPayload ? &state : NULL);
+            snprintf(topic, sizeof(topic)-1, "%s", prefs.mqttTopic);
+        }
+        if (len == 0) {
+            Serial.printf("MQTT: payload exceeds buffer size, %d readings dropped\n", count);
+            this->oversized = true;
+        } else if (packetId > 0)
+            published = this->ackClient.beginPublish(topic, packetId, len, duplicate) &&
+                this->ackClient.write((uint8_t*)this->payload, len) == len;
+        else
+            published = mqtt.beginPublish(topic, len, false) &&
+                mqtt.write((uint8_t*)this->payload, len) == len && mqtt.endPublish();
+        if (published) {
+            if (prefs.mqttSparkplug)
+                this->sparkplugSeq++;
+            if (count > 1)
+                Serial.printf("MQTT: published %d readings (%zu bytes) to %s on %s\n", count, len,
+                    topic, prefs.mqttBroker);
+            else
+                Serial.printf("MQTT: published %zu bytes to %s on %s\n", len,
+                    topic, prefs.mqttBroker);
             queueStatusMsg("MQTT publish", 80, false);
-            return true;
         }
     }
+    xSemaphoreGive(this->clientLock);
 
-    return false;
+    // a keyframe is sent next if a delta payload might have been lost
+    if (published && keyframe)
+        this->lastKeyframe = millis();
+    this->deltaState = published ? state : (deltaState_t){ { 0 }, 0 };
+
+    return published;
 }
 
 
-// returns true if waiting time to queue a new message has been reached
-bool MQTT::schedule() {
-    return (tsDiff(lastPublished) > (prefs.mqttIntervalSecs * 1000));
+// NDEATH payload registered as will, returns length (0 if buffer
+// is too small), payload is zero-terminated and has no zero bytes
+size_t MQTT::encodeDeath(char *buf, size_t size) {
+    SparkplugPayload payload((uint8_t*)buf, size-1, SysTime.getEpochMillis());
+    size_t len;
+
+    payload.addBdSeq(this->bdSeq);
+    len = payload.finish(-1);
+    buf[len] = '\0';
+    return len;
 }
 
 
-// background task to publish queued messages
-void MQTT::publishTask() {
-    time_t mqttRetryTime = 0;
+// declare all metrics of available sensors with name, alias, data type
+// and last value after connecting, resets NDATA sequence number
+bool MQTT::publishBirth() {
+    static uint8_t birth[SPARKPLUG_BIRTH_SIZE];
+    static char topic[SPARKPLUG_TOPIC_SIZE];
+    SparkplugPayload payload(birth, sizeof(birth), SysTime.getEpochMillis());
+    uint8_t sensors = Sensors::available();
+    const sensorField_t *field;
+    size_t len;
+
+    payload.addBdSeq(this->bdSeq);
+    for (uint8_t i = 0; i < SensorSchemaFields; i++) {
+        field = &SensorSchema[i];
+        if (!sparkplugMetric(i) || !fieldEnabled(field, sensors))
+            continue;
+        payload.addField(i, this->lastReadings,
+            this->lastReadingsValid && fieldAvailable(field, sensors, this->lastReadings), true,
+            this->lastReadings.timestamp);
+    }
+    this->sparkplugSeq = 0;
+    len = payload.finish(this->sparkplugSeq);
+    if (len == 0)
+        return false;
+
+    sparkplugTopic(topic, sizeof(topic), prefs.sparkplugGroup, "NBIRTH", this->clientId);
+    if (!mqtt.beginPublish(topic, len, false) || mqtt.write(birth, len) != len || !mqtt.endPublish())
+        return false;
+    Serial.printf("MQTT: published Sparkplug NBIRTH (%zu bytes, bdSeq %d)\n", len, this->bdSeq);
+    return true;
+}
+
+
+// announce retained field topics of available sensors via Home Assistant
+// MQTT discovery, should be sent once per session, returns false on failure
+bool MQTT::publishDiscovery() {
+    static char topic[96], id[32];
+    const sensorField_t *field;
+    const haSensor_t *ha;
+    bool published = true;
+    size_t len;
+
+    for (uint8_t i = 0; i < sizeof(HASensors) / sizeof(haSensor_t) && published; i++) {
+        ha = &HASensors[i];
+        field = NULL;
+        for (uint8_t j = 0; j < SensorSchemaFields; j++) {
+            if (!strcmp(SensorSchema[j].key, ha->key))
+                field = &SensorSchema[j];
+        }
+        if (field == NULL || !fieldEnabled(field, Sensors::available()))
+            continue;
+
+        JsonWriter json(this->payload, sizeof(this->payload));
+        json.beginObject();
+        json.addString("name", ha->name);
+        snprintf(id, sizeof(id), "m5tough_%s_%s", getSystemID(), ha->key);
+        json.addString("unique_id", id);
+        snprintf(topic, sizeof(topic), "%s/%s", prefs.mqttTopic, ha->key);
+        json.addString("state_topic", topic);
+        json.addString("availability_topic", this->statusTopic);
+        if (ha->unit != NULL)
+            json.addString("unit_of_measurement", ha->unit);
+        if (ha->deviceClass != NULL)
+            json.addString("device_class", ha->deviceClass);
+        json.addString("state_class", "measurement");
+        json.beginObject("device");
+        json.beginArray("identifiers");
+        snprintf(id, sizeof(id), "m5tough_%s", getSystemID());
+        json.addString(NULL, id);
+        json.endArray();
+        snprintf(id, sizeof(id), "M5Tough %s", getSystemID());
+        json.addString("name", id);
+        json.addString("manufacturer", MANUFACTURER);
+        json.addString("model", FIRMWARE_NAME);
+        json.addString("sw_version", FIRMWARE_VERSION);
+        json.endObject();
+        json.endObject();
+        if (json.overflowed())
+            return false;
+
+        len = json.length();
+        snprintf(topic, sizeof(topic), "%s/sensor/m5tough_%s/%s/config",
+            MQTT_DISCOVERY_PREFIX, getSystemID(), ha->key);
+        if (!this->lockClient())
+            return false;
+        published = mqtt.connected() && mqtt.beginPublish(topic, len, true) &&
+            mqtt.write((uint8_t*)this->payload, len) == len && mqtt.endPublish();
+        xSemaphoreGive(this->clientLock);
+    }
+
+    if (published)
+        Serial.printf("MQTT: sent Home Assistant discovery to %s\n", MQTT_DISCOVERY_PREFIX);
+    return published;
+}
+
+
+// publish readings which have changed beyond their deadband to retained
+// topics '<base topic>/<key>', a topic is cleared if a reading becomes
+// unavailable, all readings are published again with a new session
+void MQTT::publishFields(const sensorReadings_t &data) {
+    static char topic[64], value[24];
+    uint8_t sensors = Sensors::available();
+    const sensorField_t *field;
+    size_t len;
+
+    // skipped fields are sent with the next readings since fieldsState is unchanged
+    if (!this->lockClient())
+        return;
+    if (this->fieldsSession != this->connectCount) {
+        this->fieldsSession = this->connectCount;
+        this->fieldsState.valid = 0;
+    }
+    for (uint8_t i = 0; i < SensorSchemaFields && mqtt.connected(); i++) {
+        field = &SensorSchema[i];
+        if (field->sensor == 0 || !this->fieldChanged(i, sensors, data, &this->fieldsState))
+            continue;
+        len = 0;
+        if (fieldAvailable(field, sensors, data)) {
+            JsonWriter json(value, sizeof(value));
+            json.addNumber(NULL, fieldValue(field, data), field->decimals);
+            len = json.length();
+        }
+        snprintf(topic, sizeof(topic), "%s/%s", prefs.mqttTopic, field->key);
+        if (!mqtt.publish(topic, (uint8_t*)value, len, true))
+            break;
+        if (len > 0) {
+            this->fieldsState.value[i] = fieldValue(field, data);
+            this->fieldsState.valid |= (1UL << i);
+        } else {
+            this->fieldsState.valid &= ~(1UL << i);
+        }
+    }
+    xSemaphoreGive(this->clientLock);
+}
+
+
+// QoS level readings are published with, Sparkplug B requires QoS 0
+// for NDATA, only NDEATH (last will) is sent with QoS 1
+uint8_t MQTT::qos() {
+    return prefs.mqttSparkplug ? 0 : prefs.mqttQos;
+}
+
+
+// max. number of readings per message, SenML JSON batches have to
+// be smaller to fit into the payload buffer
+uint8_t MQTT::batchLimit() {
+    if (prefs.mqttSenml == SENML_JSON && !prefs.mqttSparkplug)
+        return min(prefs.mqttBatchSize, (uint8_t)MQTT_SENML_BATCH_MAX);
+    return prefs.mqttBatchSize;
+}
+
+
+// read up to batchLimit() buffered readings into resend buffer starting
+// at given backlog offset and covering no more than 'limit' records,
+// corrupted records are skipped, returns number of records processed
+uint32_t MQTT::readBacklog(uint32_t offset, uint32_t limit, uint8_t *count) {
+    uint32_t processed = 0;
+
+    *count = 0;
+    while (*count < this->batchLimit() && processed < limit) {
+        if (Backlog.read(offset + processed, &this->resend[*count]))
+            (*count)++;
+        processed++;
+    }
+    return processed;
+}
+
+
+// publish up to MQTT_BACKLOG_MESSAGES messages with buffered readings
+// in chronological order, readings which can't be encoded are dropped,
+// returns false if publishing failed
+bool MQTT::publishBacklog() {
+    uint32_t processed;
+    uint8_t count;
+
+    for (uint8_t msg = 0; msg < MQTT_BACKLOG_MESSAGES && Backlog.pending() > 0; msg++) {
+        processed = this->readBacklog(0, Backlog.pending(), &count);
+        if (count > 0 && !this->publish(this->resend, count) && !this->oversized)
+            return false;
+        Backlog.release(processed);
+    }
+    Serial.printf("MQTT: %u readings left in backlog\n", Backlog.pending());
+    return true;
+}
+
+
+// match PUBACKs picked up by connectionTask with messages in flight
+// and release acknowledged readings from backlog in order
+void MQTT::matchAcks() {
+    uint16_t packetId;
+    uint32_t ackTime, latency;
+
+    // PUBACKs are matched next time if connectionTask is connecting
+    if (this->lockClient()) {
+        while (this->ackClient.nextAck(&packetId, &ackTime)) {
+            for (uint8_t i = 0; i < this->inflightCount; i++) {
+                if (this->inflight[i].packetId != packetId || this->inflight[i].acked)
+                    continue;
+                latency = ackTime - this->inflight[i].sentAt;
+                this->inflight[i].acked = true;
+                this->ackCount++;
+                this->ackLatencySum += latency;
+                this->ackLatencyMax = max(this->ackLatencyMax, latency);
+                Serial.printf("MQTT: message %u acknowledged after %u ms\n", packetId, latency);
+                break;
+            }
+        }
+        xSemaphoreGive(this->clientLock);
+    }
+
+    while (this->inflightCount > 0 && this->inflight[0].acked) {
+        Backlog.release(this->inflight[0].records);
+        this->inflightRecords -= this->inflight[0].records;
+        this->inflightCount--;
+        memmove(&this->inflight[0], &this->inflight[1], this->inflightCount * sizeof(inflightMsg_t));
+    }
+}
+
+
+// remove 'records' oldest readings, which have been dropped from a full
+// backlog, from the window of messages in flight, messages without any
+// readings left are removed, returns number of readings removed from window
+uint32_t MQTT::dropInflight(inflightMsg_t *inflight, uint8_t *count, uint32_t records) {
+    uint32_t removed = 0, n;
+
+    while (*count > 0 && records > 0) {
+        n = min(records, (uint32_t)inflight[0].records);
+        inflight[0].records -= n;
+        removed += n;
+        records -= n;
+        if (inflight[0].records > 0)
+            break;
+        (*count)--;
+        memmove(&inflight[0], &inflight[1], *count * sizeof(inflightMsg_t));
+    }
+    return removed;
+}
+
+
+// QoS 1 publishing straight from the backlog, up to 'mqttInflightWindow'
+// messages are sent without waiting for their PUBACK, unacknowledged messages
+// are sent again (with same packet id) after a reconnect or MQTT_ACK_TIMEOUT_MS,
+// returns false if publishing failed
+bool MQTT::publishWindow() {
+    uint32_t session = this->connectCount;
+    uint32_t processed, offset = 0;
+    inflightMsg_t *msg;
+    uint8_t count;
+
+    // backlog offsets of messages in flight refer to its oldest reading
+    processed = Backlog.dropped() - this->backlogDropped;
+    if (processed > 0) {
+        this->inflightRecords -= dropInflight(this->inflight, &this->inflightCount, processed);
+        this->backlogDropped += processed;
+    }
+
+    this->matchAcks();
+    if (this->retryPending())
+        return true;
+
+    if (this->inflightCount > 0 && (this->inflightSession != session ||
+            tsDiff(this->inflight[0].sentAt) > MQTT_ACK_TIMEOUT_MS)) {
+        this->deltaState.valid = 0;  // consumers might have missed delta payloads
+        for (uint8_t i = 0; i < this->inflightCount; i++) {
+            msg = &this->inflight[i];
+            if (!msg->acked) {
+                this->readBacklog(offset, msg->records, &count);
+                msg->sentAt = millis();
+                if (!this->publish(this->resend, count, msg->packetId, true)) {
+                    if (!this->oversized)
+                        return false;
+                    msg->acked = true;  // dropped, released by matchAcks()
+                }
+                this->resendCount++;
+            }
+            offset += msg->records;
+        }
+        Serial.printf("MQTT: resent %d unacknowledged messages\n", this->inflightCount);
+        this->inflightSession = session;
+    }
+
+    offset = this->inflightRecords;
+    while (this->inflightCount < prefs.mqttInflightWindow && offset < Backlog.pending()) {
+        processed = this->readBacklog(offset, Backlog.pending() - offset, &count);
+        msg = &this->inflight[this->inflightCount];
+        msg->packetId = this->packetId < 0xFFFF ? this->packetId + 1 : 1;
+        msg->records = processed;
+        msg->sentAt = millis();
+        msg->acked = (count == 0);  // only corrupted records, nothing to send
+        if (count > 0 && !this->publish(this->resend, count, msg->packetId, false)) {
+            if (!this->oversized)
+                return false;
+            msg->acked = true;
+        }
+        this->packetId = msg->packetId;
+        this->inflightCount++;
+        this->inflightRecords += processed;
+        this->inflightSession = session;
+        offset += processed;
+    }
+    return true;
+}
+
+
+void MQTT::publishFailed() {
     static char statusMsg[32];
+
+    Serial.printf("MQTT: failed to publish to %s on %s (error %d), retry in %d secs\n",
+        prefs.mqttTopic, prefs.mqttBroker, mqtt.state(), MQTT_RETRY_SECS);
+    snprintf(statusMsg, sizeof(statusMsg), "MQTT failed (error %d)", mqtt.state());
+    queueStatusMsg(statusMsg, 30, true);
+    this->retryTime = millis();
+}
+
+
+// true while waiting MQTT_RETRY_SECS after a failed publish
+bool MQTT::retryPending() {
+    return this->retryTime > 0 && tsDiff(this->retryTime) < (MQTT_RETRY_SECS * 1000);
+}
+
+
+// publish collected readings, they are appended to the backlog if the broker
+// is unreachable, older readings are still pending or if they are published
+// with QoS 1 and have to be kept until the broker acknowledged them,
+// readings which don't fit into a payload are dropped
+void MQTT::flushBatch() {
+    if (this->qos() == 0 && Backlog.pending() == 0 && !this->retryPending()) {
+        if (this->publish(this->batch, this->batchCount)) {
+            this->retryTime = 0;
+            this->batchCount = 0;
+            return;
+        }
+        if (this->oversized) {
+            this->batchCount = 0;  // would never fit, don't keep it in backlog
+            return;
+        }
+        this->publishFailed();
+    }
+    for (uint8_t i = 0; i < this->batchCount; i++) {
+        if (!Backlog.append(&this->batch[i]))
+            Serial.println("MQTT: failed to buffer readings, dropped");
+    }
+    this->batchCount = 0;
+}
+
+
+// background task collecting readings from the bus, which are
+// published once 'mqttBatchSize' readings have been collected
+// or the oldest one has been waiting for 'mqttBatchSecs'
+void MQTT::publishTask() {
+    sensorReadings_t data;
+    UBaseType_t stackLowest = MQTT_STACK_MIN_FREE;
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
     uint16_t loopCounter = 0;
 #endif
 
     while (true) {
-        if ((mqttRetryTime <= millis()) && (xQueueReceive(this->msgQueue, &readings, 0) == pdTRUE)) {
-            if (!this->publish(readings)) {
-                Serial.printf("MQTT: failed to publish to %s on %s (error %d), retry in %d secs\n",
-                    prefs.mqttTopic, prefs.mqttBroker, mqtt.state(), MQTT_RETRY_SECS);
-                snprintf(statusMsg, sizeof(statusMsg), "MQTT failed (error %d)", mqtt.state());
-                queueStatusMsg(statusMsg, 30, true);
-                mqttRetryTime = millis() + (MQTT_RETRY_SECS * 1000);
-            } else {
-                this->lastPublished = millis();
-                mqttRetryTime = 0;
+        while (Bus.receive(this->busId, &data, 0)) {
+            if (prefs.mqttSparkplug && this->lockClient()) {
+                this->lastReadings = data;
+                this->lastReadingsValid = true;
+                xSemaphoreGive(this->clientLock);
             }
+            if (prefs.mqttFieldTopics)
+                this->publishFields(data);
+            if (this->batchCount == 0)
+                this->batchStarted = millis();
+            this->batch[this->batchCount++] = data;
+            if (this->batchCount >= this->batchLimit())
+                this->flushBatch();
         }
+        if (this->batchCount > 0 && tsDiff(this->batchStarted) >= (prefs.mqttBatchSecs * 1000))
+            this->flushBatch();
+        if (prefs.mqttDiscovery && this->discoverySession != this->connectCount && this->sessionUp) {
+            if (this->publishDiscovery())
+                this->discoverySession = this->connectCount;
+        }
+        if (this->qos() > 0) {
+            if (!this->publishWindow())
+                this->publishFailed();
+        } else if (Backlog.pending() > 0 && !this->retryPending()) {
+            if (!this->publishBacklog())
+                this->publishFailed();
+        }
+        checkStackWatermark("mqttTask", MQTT_STACK_MIN_FREE, &stackLowest);
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
         if (loopCounter++ >= MEMORY_DEBUG_INTERVAL_SECS) {
             stackMqttPublishTask = printFreeStackWatermark("mqttTask");
@@ -221,7 +989,8 @@ void MQTT::publishTask() {
 #endif
         if (lowBattery)
             vTaskDelete(NULL);
-        vTaskDelay(1000/portTICK_PERIOD_MS);
+        // check for acknowledgements more often while messages are in flight
+        vTaskDelay((this->inflightCount > 0 ? MQTT_LOOP_INTERVAL_MS : 1000)/portTICK_PERIOD_MS);
     }
 }
 
@@ -229,12 +998,3 @@ void MQTT::publishTask() {
 void MQTT::publishTaskWrapper(void* _this) {
     static_cast<MQTT*>(_this)->publishTask();
 }
-
-
-// place current sensor reading in MQTT publish queue
-bool MQTT::queue(sensorReadings_t data) {
-    if (this->msgQueue == NULL)
-        return false;
-    Serial.println("MQTT: queuing sensor data");
-    return (xQueueOverwrite(this->msgQueue, (void*)&data) == pdTRUE);
-}
\ No newline at end of file
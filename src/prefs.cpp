@@ -24,6 +24,7 @@
 #include "utils.h"
 #include "rtc.h"
 #include "wlan.h"
+#include "bme680.h"
 
 // use NVS to store settings to survive
 // a system reset (cold start) or reflash
@@ -31,12 +32,12 @@ Preferences nvs;
 
 // instantiate app settings and set default values
 appPrefs_t prefs = {
-    { 0 },
     SENSOR_READING_INTERVAL_SECS,
     MQTT_BROKER_HOST,
     MQTT_BROKER_PORT,
     MQTT_TOPIC,
     MQTT_PUBLISH_INTERVAL_SECS,
+    DEADBAND_CONFIG,
 #if defined(MQTT_USERNAME) && defined(MQTT_PASSWORD)
     true,
     MQTT_USERNAME,
@@ -46,6 +47,38 @@ appPrefs_t prefs = {
     "",
     "",
 #endif
+    MQTT_BATCH_SIZE,
+    MQTT_BATCH_SECS,
+#ifdef MQTT_BATCH_COLUMNAR
+    true,
+#else
+    false,
+#endif
+    MQTT_QOS,
+    MQTT_INFLIGHT_WINDOW,
+#ifdef MQTT_DELTA_PAYLOAD
+    true,
+#else
+    false,
+#endif
+    MQTT_KEYFRAME_SECS,
+#if defined(MQTT_FIELD_TOPICS) || defined(MQTT_HA_DISCOVERY)
+    true,
+#else
+    false,
+#endif
+#ifdef MQTT_HA_DISCOVERY
+    true,
+#else
+    false,
+#endif
+#ifdef MQTT_SPARKPLUG
+    true,
+#else
+    false,
+#endif
+    SPARKPLUG_GROUP_ID,
+    MQTT_SENML,
     NTP_SERVER_ADDRESS,
 #ifdef BLE_SERVER
     true,
@@ -63,6 +96,8 @@ appPrefs_t prefs = {
 #endif
     LORAWAN_INTERVAL_SECS,
     LORAWAN_CONFIRM,
+    LORAWAN_PACKED,
+    LORAWAN_BATCH,
 #ifdef CLEAR_NVS_ON_UPDATE
     true,
 #else
@@ -71,6 +106,30 @@ appPrefs_t prefs = {
     { 0 }
 };
 
+// settings as saved by firmware releases before PREFS_LAYOUT (layout 0),
+// frozen copy of their appPrefs_t, the BSEC state (length byte and blob)
+// is kept in its own NVS slots by bme680.cpp now, do not change
+typedef struct {
+    uint8_t bsecState[BSEC_MAX_STATE_BLOB_SIZE+1];
+    uint16_t readingsIntervalSecs;
+    char mqttBroker[PARAMETER_SIZE+1];
+    uint16_t mqttBrokerPort;
+    char mqttTopic[PARAMETER_SIZE+1];
+    uint16_t mqttIntervalSecs;
+    bool mqttEnableAuth;
+    char mqttUsername[PARAMETER_SIZE+1];
+    char mqttPassword[PARAMETER_SIZE+1];
+    char ntpServer[PARAMETER_SIZE+1];
+    bool bleServer;
+    bool lorawanEnable;
+    char lorawanAppEUI[17];
+    char lorawanAppKey[33];
+    uint16_t lorawanIntervalSecs;
+    bool lorawanConfirm;
+    bool clearNVSUpdate;
+    uint8_t sha256[32];
+} prefsLayout0_t;
+
 // check if a new firmware has just been flashed
 static void checkFirmwareUpdate() {
     uint8_t sha256[32], sha256Prev[32];
@@ -105,22 +164,64 @@ static void checkFirmwareUpdate() {
 }
 
 
-// load system settings from NVS if previously saved
+// convert settings saved by an older firmware to the current layout,
+// fields missing in the old layout keep their default values, settings
+// saved before PREFS_LAYOUT was introduced (layout 0) are told apart
+// by their size, returns false if the layout is unknown
+static bool migratePrefs(uint8_t layout, size_t size) {
+    prefsLayout0_t old;
+
+    if (layout == 0 && size == sizeof(old)) {
+        nvs.getBytes("appPrefs", &old, sizeof(old));
+        prefs.readingsIntervalSecs = old.readingsIntervalSecs;
+        strlcpy(prefs.mqttBroker, old.mqttBroker, sizeof(prefs.mqttBroker));
+        prefs.mqttBrokerPort = old.mqttBrokerPort;
+        strlcpy(prefs.mqttTopic, old.mqttTopic, sizeof(prefs.mqttTopic));
+        prefs.mqttIntervalSecs = old.mqttIntervalSecs;
+        prefs.mqttEnableAuth = old.mqttEnableAuth;
+        strlcpy(prefs.mqttUsername, old.mqttUsername, sizeof(prefs.mqttUsername));
+        strlcpy(prefs.mqttPassword, old.mqttPassword, sizeof(prefs.mqttPassword));
+        strlcpy(prefs.ntpServer, old.ntpServer, sizeof(prefs.ntpServer));
+        prefs.bleServer = old.bleServer;
+        prefs.lorawanEnable = old.lorawanEnable;
+        strlcpy(prefs.lorawanAppEUI, old.lorawanAppEUI, sizeof(prefs.lorawanAppEUI));
+        strlcpy(prefs.lorawanAppKey, old.lorawanAppKey, sizeof(prefs.lorawanAppKey));
+        prefs.lorawanIntervalSecs = old.lorawanIntervalSecs;
+        prefs.lorawanConfirm = old.lorawanConfirm;
+        prefs.clearNVSUpdate = old.clearNVSUpdate;
+        if (old.bsecState[0] == BSEC_MAX_STATE_BLOB_SIZE)
+            BME680::importState(&old.bsecState[1]);
+        return true;
+    }
+    return false;
+}
+
+
+// load system settings from NVS if previously saved, settings of
+// an older layout are migrated, unknown ones are discarded
 void startPrefs() {
     size_t prefSize;
-    
+    uint8_t layout;
+
     nvs.begin("prefs", false);
     checkFirmwareUpdate();
     if (nvs.getBool("saved")) {
+        layout = nvs.getUChar("prefsLayout", 0);
         prefSize = nvs.getBytesLength("appPrefs");
-        byte bufPrefs[prefSize];
-        nvs.getBytes("appPrefs", bufPrefs, prefSize);
-        memcpy(&prefs, bufPrefs, prefSize);
-        Serial.println(F("NVS: restored settings"));
-    } else {
-        Serial.println(F("NVS: reset to compile time default settings"));
-        savePrefs(false);
+        if (layout == PREFS_LAYOUT && prefSize == sizeof(prefs)) {
+            nvs.getBytes("appPrefs", &prefs, sizeof(prefs));
+            Serial.println(F("NVS: restored settings"));
+            return;
+        }
+        if (layout < PREFS_LAYOUT && migratePrefs(layout, prefSize)) {
+            Serial.printf("NVS: migrated settings from layout %d\n", layout);
+            savePrefs(false);
+            return;
+        }
+        Serial.printf("NVS: discarding settings of unknown layout %d (%zu bytes)\n", layout, prefSize);
     }
+    Serial.println(F("NVS: reset to compile time default settings"));
+    savePrefs(false);
 }
 
 
@@ -134,8 +235,55 @@ void savePrefs(bool restart) {
     if (prefs.mqttIntervalSecs < 10)
         prefs.mqttIntervalSecs = 10;
 
-    if (prefs.mqttIntervalSecs > 120)
-        prefs.mqttIntervalSecs = 120;
+    if (prefs.mqttIntervalSecs > 3600)
+        prefs.mqttIntervalSecs = 3600;
+
+    // applied by setup(), savePrefs() might be called from other tasks
+    if (!DeadbandFilter::validate(prefs.deadband))
+        strlcpy(prefs.deadband, DEADBAND_CONFIG, sizeof(prefs.deadband));
+
+    if (prefs.mqttBatchSize < 1)
+        prefs.mqttBatchSize = 1;
+
+    if (prefs.mqttBatchSize > MQTT_BATCH_MAX)
+        prefs.mqttBatchSize = MQTT_BATCH_MAX;
+
+    if (prefs.mqttBatchSecs < 10)
+        prefs.mqttBatchSecs = 10;
+
+    if (prefs.mqttBatchSecs > 600)
+        prefs.mqttBatchSecs = 600;
+
+    if (prefs.mqttQos > 1)
+        prefs.mqttQos = 1;
+
+    if (prefs.mqttInflightWindow < 1)
+        prefs.mqttInflightWindow = 1;
+
+    if (prefs.mqttInflightWindow > MQTT_INFLIGHT_MAX)
+        prefs.mqttInflightWindow = MQTT_INFLIGHT_MAX;
+
+    if (prefs.mqttKeyframeSecs < 60)
+        prefs.mqttKeyframeSecs = 60;
+
+    if (prefs.mqttKeyframeSecs > 3600)
+        prefs.mqttKeyframeSecs = 3600;
+
+    if (prefs.mqttDiscovery)
+        prefs.mqttFieldTopics = true;
+
+    // NDEATH replaces the availability topic as last will
+    if (prefs.mqttSparkplug) {
+        prefs.mqttFieldTopics = false;
+        prefs.mqttDiscovery = false;
+    }
+
+    if (prefs.mqttSenml > SENML_CBOR)
+        prefs.mqttSenml = SENML_OFF;
+
+    // group id is a single topic level
+    if (!strlen(prefs.sparkplugGroup) || strpbrk(prefs.sparkplugGroup, "/+#") != NULL)
+        strlcpy(prefs.sparkplugGroup, SPARKPLUG_GROUP_ID, sizeof(prefs.sparkplugGroup));
 
     if (prefs.readingsIntervalSecs < 3)
         prefs.readingsIntervalSecs = 3;
@@ -150,6 +298,7 @@ void savePrefs(bool restart) {
         prefs.lorawanIntervalSecs = 300;
 
     nvs.putBytes("appPrefs", &prefs, sizeof(prefs));
+    nvs.putUChar("prefsLayout", PREFS_LAYOUT);
     nvs.putBool("saved", true);
     if (restart) {
         Serial.println(F("Save settings and restarting device..."));
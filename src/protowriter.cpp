@@ -0,0 +1,137 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "protowriter.h"
+
+
+ProtoWriter::ProtoWriter(uint8_t *buf, size_t size) {
+    this->buf = buf;
+    this->size = size;
+    this->reset();
+}
+
+
+void ProtoWriter::reset() {
+    this->len = 0;
+    this->depth = 0;
+    this->overflow = false;
+}
+
+
+// embedded message, a single byte is reserved for its length
+// which is moved to make room if the message exceeds 127 bytes
+void ProtoWriter::beginMessage(uint8_t field) {
+    this->putTag(field, PROTO_LENGTH);
+    this->put(0);
+    if (this->depth < PROTO_MAX_DEPTH) {
+        this->start[this->depth++] = this->len;
+    } else {
+        this->overflow = true;
+    }
+}
+
+
+void ProtoWriter::endMessage() {
+    size_t msgStart, msgLen, prefix = 1;
+    uint8_t *ptr;
+
+    if (this->depth == 0 || this->overflow)
+        return;
+    msgStart = this->start[--this->depth];
+    msgLen = this->len - msgStart;
+    for (size_t n = msgLen >> 7; n > 0; n >>= 7)
+        prefix++;
+    if (prefix > 1) {
+        if (this->len + prefix - 1 > this->size) {
+            this->overflow = true;
+            return;
+        }
+        memmove(this->buf + msgStart + prefix - 1, this->buf + msgStart, msgLen);
+        this->len += prefix - 1;
+    }
+    ptr = this->buf + msgStart - 1;
+    do {
+        *ptr = (msgLen & 0x7F) | (msgLen > 0x7F ? 0x80 : 0);
+        msgLen >>= 7;
+        ptr++;
+    } while (msgLen > 0);
+}
+
+
+void ProtoWriter::addVarint(uint8_t field, uint64_t value) {
+    this->putTag(field, PROTO_VARINT);
+    this->putVarint(value);
+}
+
+
+// 32-bit IEEE 754, always little-endian on the wire
+void ProtoWriter::addFloat(uint8_t field, float value) {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    this->putTag(field, PROTO_FIXED32);
+    for (uint8_t i = 0; i < 4; i++)
+        this->put((bits >> (i * 8)) & 0xFF);
+}
+
+
+void ProtoWriter::addString(uint8_t field, const char *value) {
+    size_t n = strlen(value);
+
+    this->putTag(field, PROTO_LENGTH);
+    this->putVarint(n);
+    while (n-- > 0)
+        this->put(*value++);
+}
+
+
+// returns length of encoded message, incomplete while
+// an embedded message is still open
+size_t ProtoWriter::length() {
+    return this->len;
+}
+
+
+bool ProtoWriter::overflowed() {
+    return this->overflow || this->depth > 0;
+}
+
+
+void ProtoWriter::putTag(uint8_t field, uint8_t wireType) {
+    this->putVarint(((uint32_t)field << 3) | wireType);
+}
+
+
+void ProtoWriter::putVarint(uint64_t value) {
+    while (value > 0x7F) {
+        this->put((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    this->put(value);
+}
+
+
+void ProtoWriter::put(uint8_t b) {
+    if (this->len < this->size) {
+        this->buf[this->len++] = b;
+    } else {
+        this->overflow = true;
+    }
+}
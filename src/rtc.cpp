@@ -190,6 +190,17 @@ char* SystemTime::getDateString() {
 }
 
 
+// returns current UTC time in milliseconds or 0 if time has not been set yet
+uint64_t SystemTime::getEpochMillis() {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec < 1672531200)  // 2023/01/01
+        return 0;
+    return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
 // returns runtime in minutes
 uint32_t SystemTime::getRuntimeMinutes() {
     static time_t lastMillis = 0;
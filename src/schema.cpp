@@ -0,0 +1,90 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "schema.h"
+
+#define FIELD(member) offsetof(sensorReadings_t, member)
+
+// field names and order as published via MQTT
+const sensorField_t SensorSchema[] = {
+    { "ts", FIELD_UINT64, FIELD(timestamp), 0, 0, NONZERO },  // UTC ms
+    { "seq", FIELD_UINT32, FIELD(sequence), 0, 0, ALWAYS },
+    { "objectTemp", FIELD_FLOAT, FIELD(mlxObjectTemp), 1, SENSOR_MLX90614, ALWAYS },
+    { "ambientTemp", FIELD_FLOAT, FIELD(mlxAmbientTemp), 1, SENSOR_MLX90614, ALWAYS },
+    { "hcho", FIELD_FLOAT, FIELD(sfa30HCHO), 1, SENSOR_SFA30, ALWAYS },  // ppb
+    { "humidity", FIELD_UINT8, FIELD(bme680Hum), 0, SENSOR_BME680, ALWAYS },  // 0-100%
+    { "gasResistance", FIELD_UINT16, FIELD(bme680GasResistance), 0, SENSOR_BME680, ALWAYS },  // kOhms
+    { "iaqAccuracy", FIELD_UINT8, FIELD(bme680IaqAccuracy), 0, SENSOR_BME680, ALWAYS },  // 0-3
+    { "iaq", FIELD_UINT16, FIELD(bme680Iaq), 0, SENSOR_BME680, IAQ_VALID },  // 0-500
+    { "VOC", FIELD_FLOAT, FIELD(bme680VOC), 1, SENSOR_BME680, IAQ_VALID },  // ppm
+    { "eCO2", FIELD_UINT16, FIELD(bme680eCO2), 0, SENSOR_BME680, IAQ_VALID }  // ppm
+};
+
+const uint8_t SensorSchemaFields = sizeof(SensorSchema) / sizeof(sensorField_t);
+static_assert(sizeof(SensorSchema) / sizeof(sensorField_t) <= SCHEMA_MAX_FIELDS, "increase SCHEMA_MAX_FIELDS");
+
+static const int32_t decimalScale[] = { 1, 10, 100, 1000, 10000 };
+
+
+// returns true if the sensor required for this field is available
+bool fieldEnabled(const sensorField_t *field, uint8_t sensors) {
+    return (field->sensor == 0) || (field->sensor & sensors);
+}
+
+
+// returns true if field has a valid value in given set of readings
+bool fieldAvailable(const sensorField_t *field, uint8_t sensors, const sensorReadings_t &data) {
+    if (!fieldEnabled(field, sensors))
+        return false;
+    switch (field->condition) {
+        case NONZERO:
+            return fieldValue(field, data) != 0;
+        case IAQ_VALID:
+            return data.bme680IaqAccuracy >= 1;
+        default:
+            return true;
+    }
+}
+
+
+// returns value as fixed-point integer with field's number of decimals
+int64_t fieldValue(const sensorField_t *field, const sensorReadings_t &data) {
+    const uint8_t *ptr = (const uint8_t*)&data + field->offset;
+
+    switch (field->type) {
+        case FIELD_FLOAT:
+            return (int64_t)(*(const float*)ptr * decimalScale[field->decimals]);
+        case FIELD_UINT8:
+            return *ptr;
+        case FIELD_UINT16:
+            return *(const uint16_t*)ptr;
+        case FIELD_UINT32:
+            return *(const uint32_t*)ptr;
+        case FIELD_UINT64:
+            return *(const uint64_t*)ptr;
+    }
+    return 0;
+}
+
+
+// returns factor between field's fixed-point and its real value
+int32_t fieldScale(const sensorField_t *field) {
+    return decimalScale[field->decimals];
+}
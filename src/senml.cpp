@@ -0,0 +1,134 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "senml.h"
+
+// CBOR labels (RFC 8428, section 6)
+#define SENML_LABEL_BN -2
+#define SENML_LABEL_BT -3
+#define SENML_LABEL_BU -4
+#define SENML_LABEL_V 2
+#define SENML_LABEL_T 6
+
+typedef struct {
+    const char *name;
+    const char *unit;
+} senmlUnit_t;
+
+// units of SensorSchema fields as registered for SenML
+static const senmlUnit_t SenmlUnits[] = {
+    { "objectTemp", "Cel" },
+    { "ambientTemp", "Cel" },
+    { "hcho", "ppb" },
+    { "humidity", "%RH" },
+    { "VOC", "ppm" },
+    { "eCO2", "ppm" }
+};
+
+
+// SenML unit of a SensorSchema field or NULL if it has none
+const char* SenmlWriter::unit(const char *name) {
+    for (uint8_t i = 0; i < sizeof(SenmlUnits) / sizeof(senmlUnit_t); i++) {
+        if (!strcmp(SenmlUnits[i].name, name))
+            return SenmlUnits[i].unit;
+    }
+    return NULL;
+}
+
+
+SenmlWriter::SenmlWriter(uint8_t *buf, size_t size, bool cbor) : json((char*)buf, size), cbor(buf, size) {
+    this->useCbor = cbor;
+    this->baseName = NULL;
+    this->field = NULL;
+    this->baseTime = 0;
+}
+
+
+// base name is prepended to all field names, base time in ms since epoch, omitted if 0
+void SenmlWriter::begin(const char *baseName, uint64_t baseTime) {
+    this->baseName = baseName;
+    this->field = NULL;
+    this->baseTime = baseTime;
+    if (this->useCbor)
+        this->cbor.beginArray();
+    else
+        this->json.beginArray();
+}
+
+
+// add fixed-point value with time in ms relative to base time (omitted if 0),
+// a new base name (and base unit) is set if the field differs from the last record
+void SenmlWriter::addRecord(const char *name, int64_t value, uint8_t decimals, int64_t time) {
+    const char *unit = SenmlWriter::unit(name);
+    bool first = (this->field == NULL), group = (first || strcmp(this->field, name));
+
+    if (group) {
+        snprintf(this->name, sizeof(this->name), "%s%s", this->baseName != NULL ? this->baseName : "", name);
+        this->field = name;
+    }
+    if (this->useCbor) {
+        this->cbor.beginMap();
+        if (group) {
+            this->cbor.addInt(SENML_LABEL_BN);
+            this->cbor.addString(this->name);
+            if (first && this->baseTime > 0) {
+                this->cbor.addInt(SENML_LABEL_BT);
+                this->cbor.addNumber(this->baseTime, 3);
+            }
+            if (unit != NULL) {
+                this->cbor.addInt(SENML_LABEL_BU);
+                this->cbor.addString(unit);
+            }
+        }
+        this->cbor.addInt(SENML_LABEL_V);
+        this->cbor.addNumber(value, decimals);
+        if (time != 0) {
+            this->cbor.addInt(SENML_LABEL_T);
+            this->cbor.addNumber(time, 3);
+        }
+        this->cbor.endMap();
+    } else {
+        this->json.beginObject();
+        if (group) {
+            this->json.addString("bn", this->name);
+            if (first && this->baseTime > 0)
+                this->json.addNumber("bt", this->baseTime, 3);
+            if (unit != NULL)
+                this->json.addString("bu", unit);
+        }
+        this->json.addNumber("v", value, decimals);
+        if (time != 0 && time % 1000 == 0)
+            this->json.addNumber("t", time / 1000);
+        else if (time != 0)
+            this->json.addNumber("t", time, 3);
+        this->json.endObject();
+    }
+}
+
+
+// returns length of pack or 0 if buffer is too small
+size_t SenmlWriter::end() {
+    if (this->useCbor) {
+        this->cbor.endArray();
+        return this->cbor.overflowed() ? 0 : this->cbor.length();
+    }
+    this->json.endArray();
+    return this->json.overflowed() ? 0 : this->json.length();
+}
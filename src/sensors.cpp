@@ -28,9 +28,92 @@
 #include "sensors.h"
 
 sensorReadings_t readings;
+SensorSnapshot Snapshot;
+static std::atomic<bool> readingRequest(false);
 
 void Sensors::init() {
     mlx90614.setup();
     sfa30.setup();
     bme680.setup();
+}
+
+
+// returns SENSOR_* flags of all sensors found
+uint8_t Sensors::available() {
+    return (mlx90614.status() ? SENSOR_MLX90614 : 0) |
+        (sfa30.status() ? SENSOR_SFA30 : 0) |
+        (bme680.status() ? SENSOR_BME680 : 0);
+}
+
+
+// ask loop() to take and publish a set of readings right away,
+// e.g. on request by a LoRaWAN downlink, may be called from any task
+void Sensors::requestReading() {
+    readingRequest = true;
+}
+
+
+// returns true once after a reading has been requested
+bool Sensors::readingRequested() {
+    return readingRequest.exchange(false);
+}
+
+
+SensorSnapshot::SensorSnapshot() {
+    memset(this->buffer, 0, sizeof(this->buffer));
+    memset(this->published, 0, sizeof(this->published));
+    this->sequence = 0;
+}
+
+
+// copy complete set of readings to the inactive buffer and make it
+// the current one, must only be called from a single task (loop()),
+// sequence is odd while writing, buffer (sequence >> 1) & 1 is current
+void SensorSnapshot::publish(const sensorReadings_t *data) {
+    uint32_t seq = this->sequence.load(std::memory_order_relaxed);
+    uint8_t next = ((seq >> 1) + 1) & 1;
+
+    this->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->buffer[next] = *data;
+    this->published[next] = millis();
+    this->sequence.store(seq + 2, std::memory_order_release);
+}
+
+
+// copy most recent readings, retry if the producer has started or finished
+// writing meanwhile, the current buffer stays readable while the other one
+// is written, so readers never wait for a preempted producer,
+// returns version of the copy
+uint32_t SensorSnapshot::read(sensorReadings_t *data) {
+    uint32_t seq;
+
+    do {
+        seq = this->sequence.load(std::memory_order_acquire);
+        *data = this->buffer[(seq >> 1) & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq != this->sequence.load(std::memory_order_relaxed));
+
+    return seq >> 1;
+}
+
+
+// returns number of readings published so far
+uint32_t SensorSnapshot::version() {
+    return this->sequence.load(std::memory_order_acquire) >> 1;
+}
+
+
+// returns milliseconds passed since current readings were published
+time_t SensorSnapshot::age() {
+    uint32_t seq;
+    time_t published;
+
+    do {
+        seq = this->sequence.load(std::memory_order_acquire);
+        published = this->published[(seq >> 1) & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq != this->sequence.load(std::memory_order_relaxed));
+
+    return tsDiff(published);
 }
\ No newline at end of file
@@ -79,28 +79,13 @@ bool SFA30::read() {
 }
 
 
-// returns true if formaldehyde reading has changed significantly
-bool SFA30::changed() {
-    static float lastHCHO = 0.0;
-    bool changed = false;
-
-    if (!this->status())
-        return false;
-    if (abs(lastHCHO - readings.sfa30HCHO) >= HCHO_PUBLISH_TRESHOLD)
-        changed = true;
-    lastHCHO = readings.sfa30HCHO;
-
-    return changed;
-}
-
-
 // display SFA30 readings on M5 Tought's OLED display
-void SFA30::display() {
+void SFA30::display(const sensorReadings_t &data) {
     if (!this->status()) {
         M5.Lcd.setCursor(175, 105);
         M5.Lcd.print("Humidity: ");
         if (bme680.status() > 0)
-            M5.Lcd.print(readings.bme680Hum);
+            M5.Lcd.print(data.bme680Hum);
         else
             M5.Lcd.print("n/a");
         M5.Lcd.setCursor(15, 150);
@@ -109,26 +94,26 @@ void SFA30::display() {
         M5.Lcd.setCursor(175, 105);
         M5.Lcd.print("Humidity: ");
         if (bme680.status() > 0) // prefer BME680 humidity reading
-            M5.Lcd.print(readings.bme680Hum);
+            M5.Lcd.print(data.bme680Hum);
         else
-            M5.Lcd.print(readings.sfa30Hum);
+            M5.Lcd.print(data.sfa30Hum);
         M5.Lcd.setCursor(15, 150);
         M5.Lcd.print("HCHO: ");
-        M5.Lcd.print(readings.sfa30HCHO, 1);
+        M5.Lcd.print(data.sfa30HCHO, 1);
     }
 }
 
 
 // print sensor status/readings on serial console
-void SFA30::console() {
+void SFA30::console(const sensorReadings_t &data) {
     Serial.print("SFA30: ");
     if (this->status()) {
         Serial.print("Formaldehyde(");
-        Serial.print(readings.sfa30HCHO, 1);
+        Serial.print(data.sfa30HCHO, 1);
         Serial.print(" ppb), Humidity(");
-        Serial.print(readings.sfa30Hum);
+        Serial.print(data.sfa30Hum);
         Serial.print(" %), Temperature(");
-        Serial.print(readings.sfa30Temp, 1);
+        Serial.print(data.sfa30Temp, 1);
         Serial.println(" C)");
     } else {
         Serial.println("sensor not ready!");
@@ -0,0 +1,123 @@
+/***************************************************************************
+  Copyright (c) 2024 Lars Wessels
+
+  This file a part of the "RICE-M5Tough-SensorHub" source code.
+  https://github.com/lrswss/rice-m5tough-sensorhub
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+***************************************************************************/
+
+#include "sparkplug.h"
+
+// Payload and Payload.Metric field numbers (sparkplug_b.proto)
+#define PAYLOAD_TIMESTAMP 1
+#define PAYLOAD_METRIC 2
+#define PAYLOAD_SEQ 3
+#define METRIC_NAME 1
+#define METRIC_ALIAS 2
+#define METRIC_TIMESTAMP 3
+#define METRIC_DATATYPE 4
+#define METRIC_IS_NULL 7
+#define METRIC_INT_VALUE 10
+#define METRIC_LONG_VALUE 11
+#define METRIC_FLOAT_VALUE 12
+
+// Sparkplug B data types
+#define DATATYPE_UINT8 5
+#define DATATYPE_UINT16 6
+#define DATATYPE_UINT32 7
+#define DATATYPE_UINT64 8
+#define DATATYPE_FLOAT 9
+
+
+SparkplugPayload::SparkplugPayload(uint8_t *buf, size_t size, uint64_t timestamp) : proto(buf, size) {
+    if (timestamp > 0)
+        this->proto.addVarint(PAYLOAD_TIMESTAMP, timestamp);
+}
+
+
+// birth/death sequence number tying an NDEATH to its NBIRTH
+void SparkplugPayload::addBdSeq(uint8_t bdSeq) {
+    this->proto.beginMessage(PAYLOAD_METRIC);
+    this->proto.addString(METRIC_NAME, "bdSeq");
+    this->proto.addVarint(METRIC_DATATYPE, DATATYPE_UINT64);
+    this->proto.addVarint(METRIC_LONG_VALUE, bdSeq);
+    this->proto.endMessage();
+}
+
+
+// add field as metric (timestamp is omitted if 0), fixed-point values
+// are sent as float with the field's precision, or flagged as null
+void SparkplugPayload::addField(uint8_t index, const sensorReadings_t &data, bool available, bool birth,
+        uint64_t timestamp) {
+    const sensorField_t *field = &SensorSchema[index];
+    int64_t value = fieldValue(field, data);
+
+    this->proto.beginMessage(PAYLOAD_METRIC);
+    if (birth)
+        this->proto.addString(METRIC_NAME, field->key);
+    this->proto.addVarint(METRIC_ALIAS, index);
+    if (timestamp > 0)
+        this->proto.addVarint(METRIC_TIMESTAMP, timestamp);
+    if (birth) {
+        switch (field->type) {
+            case FIELD_FLOAT:
+                this->proto.addVarint(METRIC_DATATYPE, DATATYPE_FLOAT);
+                break;
+            case FIELD_UINT8:
+                this->proto.addVarint(METRIC_DATATYPE, DATATYPE_UINT8);
+                break;
+            case FIELD_UINT16:
+                this->proto.addVarint(METRIC_DATATYPE, DATATYPE_UINT16);
+                break;
+            case FIELD_UINT32:
+                this->proto.addVarint(METRIC_DATATYPE, DATATYPE_UINT32);
+                break;
+            case FIELD_UINT64:
+                this->proto.addVarint(METRIC_DATATYPE, DATATYPE_UINT64);
+                break;
+        }
+    }
+    if (!available)
+        this->proto.addVarint(METRIC_IS_NULL, 1);
+    else if (field->type == FIELD_FLOAT)
+        this->proto.addFloat(METRIC_FLOAT_VALUE, (float)value / fieldScale(field));
+    else if (field->type == FIELD_UINT64)
+        this->proto.addVarint(METRIC_LONG_VALUE, value);
+    else
+        this->proto.addVarint(METRIC_INT_VALUE, value);
+    this->proto.endMessage();
+}
+
+
+// append sequence number (omitted if negative, i.e. NDEATH),
+// returns length of payload or 0 if buffer is too small
+size_t SparkplugPayload::finish(int16_t seq) {
+    if (seq >= 0)
+        this->proto.addVarint(PAYLOAD_SEQ, seq);
+    return this->proto.overflowed() ? 0 : this->proto.length();
+}
+
+
+// the sample's timestamp is sent as payload or metric
+// timestamp, all other schema fields are published as metrics
+bool sparkplugMetric(uint8_t index) {
+    return SensorSchema[index].offset != offsetof(sensorReadings_t, timestamp);
+}
+
+
+// spBv1.0/<group id>/<message type>/<edge node id>
+void sparkplugTopic(char *buf, size_t size, const char *group, const char *type, const char *node) {
+    snprintf(buf, size, "%s/%s/%s/%s", SPARKPLUG_NAMESPACE, group, type, node);
+}
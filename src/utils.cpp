@@ -43,13 +43,15 @@ time_t tsDiff(time_t tsMillis) {
 
 
 // returns hardware system id (last 3 bytes of mac address)
-String getSystemID() {
+const char* getSystemID() {
+    static char sysid[8] = { 0 };
     uint8_t mac[8];
-    char sysid[8];
-    
-    esp_read_mac(mac, ESP_MAC_WIFI_STA);
-    sprintf(sysid, "%02X%02X%02X", mac[3], mac[4], mac[5]);
-    return String(sysid);
+
+    if (!sysid[0]) {
+        esp_read_mac(mac, ESP_MAC_WIFI_STA);
+        sprintf(sysid, "%02X%02X%02X", mac[3], mac[4], mac[5]);
+    }
+    return sysid;
 }
 
 
@@ -76,6 +78,20 @@ void array2string(const byte *arr, int len, char *buf) {
 }
 
 
+// CRC-32 (IEEE 802.3) used to validate records stored in flash
+uint32_t calcCRC32(const void *data, size_t len, uint32_t crc) {
+    const uint8_t *p = (const uint8_t*)data;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+
 // display usb power status and battery info (if availabl) at startup
 // and every BATTERY_LEVEL_INTERVAL_SECS in status message bar
 void displayPowerStatus(bool fullScreen) {
@@ -216,6 +232,19 @@ void lowBatteryCheck() {
 }
 
 
+// warn if the calling task's stack high water mark has dropped below 'minFree'
+// bytes and is lower than reported before ('lowest'), returns high water mark
+UBaseType_t checkStackWatermark(const char *taskName, UBaseType_t minFree, UBaseType_t *lowest) {
+    UBaseType_t wm = uxTaskGetStackHighWaterMark(NULL);
+
+    if (wm < minFree && wm < *lowest) {
+        Serial.printf("WARNING: %s stack low, %d bytes left\n", taskName, wm);
+        *lowest = wm;
+    }
+    return wm;
+}
+
+
 #ifdef MEMORY_DEBUG_INTERVAL_SECS
 void printFreeHeap() {
     static time_t lastMsgMillis = 0;
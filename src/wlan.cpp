@@ -229,7 +229,9 @@ void WLAN::wifiManager(bool forcePortal) {
     WiFiManager wm;
     const char* menu[] = { "wifi", "param", "sep", "update", "restart" };
     String apname = String(WIFI_PORTAL_SSID) + "-" + getSystemID();
-    char mqttPortStr[8], sensorIntervalStr[4], mqttIntervalStr[4], lorawanIntervalStr[4];
+    char mqttPortStr[8], sensorIntervalStr[4], mqttIntervalStr[5], lorawanIntervalStr[4];
+    char mqttBatchSizeStr[4], mqttBatchSecsStr[4], mqttQosStr[2], mqttInflightStr[2];
+    char mqttKeyframeStr[5], mqttSenmlStr[2];
     uint8_t connectTimeout = 0;
 
     memset(ssid, 0, sizeof(ssid));
@@ -249,9 +251,16 @@ void WLAN::wifiManager(bool forcePortal) {
     sprintf(sensorIntervalStr, "%d", prefs.readingsIntervalSecs);
     sprintf(mqttIntervalStr, "%d", prefs.mqttIntervalSecs);
     sprintf(lorawanIntervalStr, "%d", prefs.lorawanIntervalSecs);
+    sprintf(mqttBatchSizeStr, "%d", prefs.mqttBatchSize);
+    sprintf(mqttBatchSecsStr, "%d", prefs.mqttBatchSecs);
+    sprintf(mqttQosStr, "%d", prefs.mqttQos);
+    sprintf(mqttInflightStr, "%d", prefs.mqttInflightWindow);
+    sprintf(mqttKeyframeStr, "%d", prefs.mqttKeyframeSecs);
+    sprintf(mqttSenmlStr, "%d", prefs.mqttSenml);
 
     WiFiManagerParameter sensor_interval("sensor_interval", "Sensor Reading Interval (3-60 secs)", sensorIntervalStr, 2);
-    WiFiManagerParameter mqtt_interval("mqtt_interval", "MQTT Publish Interval (10-120 secs)", mqttIntervalStr, 3);
+    WiFiManagerParameter mqtt_interval("mqtt_interval", "Max. Publish Interval (10-3600 secs)", mqttIntervalStr, 4);
+    WiFiManagerParameter deadband("deadband", "Publish on Change (key:threshold/hysteresis/minSecs,...)", prefs.deadband, DEADBAND_CONFIG_SIZE);
     WiFiManagerParameter mqtt_broker("broker", "MQTT Broker", prefs.mqttBroker, PARAMETER_SIZE);
     sprintf(mqttPortStr, "%d", prefs.mqttBrokerPort);
     WiFiManagerParameter mqtt_port("port", "MQTT Broker Port", mqttPortStr, 5);
@@ -259,17 +268,32 @@ void WLAN::wifiManager(bool forcePortal) {
     WiFiManagerParameter mqtt_user("user", "MQTT Username", prefs.mqttUsername, PARAMETER_SIZE);
     WiFiManagerParameter mqtt_pass("pass", "MQTT Password", prefs.mqttPassword, PARAMETER_SIZE);
     WiFiManagerParameter mqtt_auth("auth", "MQTT Authentication", "1", 1, prefs.mqttEnableAuth ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter mqtt_batch_size("batch_size", "MQTT Readings per Message (1-20)", mqttBatchSizeStr, 2);
+    WiFiManagerParameter mqtt_batch_secs("batch_secs", "MQTT Batch Deadline (10-600 secs)", mqttBatchSecsStr, 3);
+    WiFiManagerParameter mqtt_batch_columnar("batch_columnar", "Columnar Batch Format", "1", 1, prefs.mqttBatchColumnar ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter mqtt_qos("qos", "MQTT QoS Level (0-1)", mqttQosStr, 1);
+    WiFiManagerParameter mqtt_inflight("inflight", "MQTT QoS 1 In-flight Window (1-8)", mqttInflightStr, 1);
+    WiFiManagerParameter mqtt_delta("delta", "Delta Payloads", "1", 1, prefs.mqttDeltaPayload ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter mqtt_keyframe("keyframe", "MQTT Keyframe Interval (60-3600 secs)", mqttKeyframeStr, 4);
+    WiFiManagerParameter mqtt_fields("fields", "Retained Topic per Reading", "1", 1, prefs.mqttFieldTopics ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter mqtt_discovery("discovery", "Home Assistant Discovery", "1", 1, prefs.mqttDiscovery ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter mqtt_sparkplug("sparkplug", "Sparkplug B Payloads", "1", 1, prefs.mqttSparkplug ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter sparkplug_group("sparkplug_group", "Sparkplug Group ID", prefs.sparkplugGroup, PARAMETER_SIZE);
+    WiFiManagerParameter mqtt_senml("senml", "SenML Payloads (0=off, 1=JSON, 2=CBOR)", mqttSenmlStr, 1);
     WiFiManagerParameter ntp_server("ntp", "NTP Server", prefs.ntpServer, PARAMETER_SIZE);
     WiFiManagerParameter ble_server("ble", "Enable BLE Server", "1", 1, prefs.bleServer ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
     WiFiManagerParameter lorawan_node("lorawan", "Enable LoRaWAN", "1", 1, prefs.lorawanEnable ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
     WiFiManagerParameter lorawan_interval("lorawan_interval", "LoRaWAN Transmit Interval (30-300 secs)", lorawanIntervalStr, 3);
     WiFiManagerParameter lorawan_confirm("lorawan_confirm", "Confirm Transmit", "1", 1, prefs.lorawanConfirm ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter lorawan_packed("lorawan_packed", "Compact Payload", "1", 1, prefs.lorawanPacked ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
+    WiFiManagerParameter lorawan_batch("lorawan_batch", "Batch Samples", "1", 1, prefs.lorawanBatch ? "type=\"checkbox\" checked" : "type=\"checkbox\"", WFM_LABEL_AFTER);
     WiFiManagerParameter lorawan_appeui("lorawan_appeui", "LoRaWAN AppEUI (16 hex chars)", prefs.lorawanAppEUI, 16);
     WiFiManagerParameter lorawan_appkey("lorawan_appkey", "LoRaWAN AppKey (32 hex chars)", prefs.lorawanAppKey, 32);
     WiFiManagerParameter html_br("<br>");
 
     wm.addParameter(&sensor_interval);
     wm.addParameter(&mqtt_interval);
+    wm.addParameter(&deadband);
     wm.addParameter(&mqtt_broker);
     wm.addParameter(&mqtt_port);
     wm.addParameter(&mqtt_topic);
@@ -278,6 +302,26 @@ void WLAN::wifiManager(bool forcePortal) {
     wm.addParameter(&mqtt_auth);
     wm.addParameter(&html_br);
     wm.addParameter(&html_br);
+    wm.addParameter(&mqtt_batch_size);
+    wm.addParameter(&mqtt_batch_secs);
+    wm.addParameter(&mqtt_batch_columnar);
+    wm.addParameter(&html_br);
+    wm.addParameter(&html_br);
+    wm.addParameter(&mqtt_qos);
+    wm.addParameter(&mqtt_inflight);
+    wm.addParameter(&mqtt_keyframe);
+    wm.addParameter(&mqtt_delta);
+    wm.addParameter(&html_br);
+    wm.addParameter(&mqtt_fields);
+    wm.addParameter(&html_br);
+    wm.addParameter(&mqtt_discovery);
+    wm.addParameter(&html_br);
+    wm.addParameter(&mqtt_sparkplug);
+    wm.addParameter(&html_br);
+    wm.addParameter(&sparkplug_group);
+    wm.addParameter(&mqtt_senml);
+    wm.addParameter(&html_br);
+    wm.addParameter(&html_br);
     wm.addParameter(&ntp_server);
     wm.addParameter(&html_br);
     wm.addParameter(&ble_server);
@@ -287,6 +331,10 @@ void WLAN::wifiManager(bool forcePortal) {
     wm.addParameter(&lorawan_interval);
     wm.addParameter(&lorawan_confirm);
     wm.addParameter(&html_br);
+    wm.addParameter(&lorawan_packed);
+    wm.addParameter(&html_br);
+    wm.addParameter(&lorawan_batch);
+    wm.addParameter(&html_br);
     wm.addParameter(&html_br);
     wm.addParameter(&lorawan_appeui);
     wm.addParameter(&lorawan_appkey);
@@ -322,17 +370,32 @@ void WLAN::wifiManager(bool forcePortal) {
     if (updateSettings) {
         prefs.readingsIntervalSecs = strtoumax(sensor_interval.getValue(), NULL, 10);
         prefs.mqttIntervalSecs = strtoumax(mqtt_interval.getValue(), NULL, 10);
+        strlcpy(prefs.deadband, deadband.getValue(), DEADBAND_CONFIG_SIZE+1);
         strlcpy(prefs.mqttBroker, mqtt_broker.getValue(), PARAMETER_SIZE+1);
         prefs.mqttBrokerPort = strtoumax(mqtt_port.getValue(), NULL, 10);
         strlcpy(prefs.mqttTopic, mqtt_topic.getValue(), PARAMETER_SIZE+1);
         prefs.mqttEnableAuth = *mqtt_auth.getValue();
         strlcpy(prefs.mqttUsername, mqtt_user.getValue(), PARAMETER_SIZE+1);
         strlcpy(prefs.mqttPassword, mqtt_pass.getValue(), PARAMETER_SIZE+1);
+        prefs.mqttBatchSize = strtoumax(mqtt_batch_size.getValue(), NULL, 10);
+        prefs.mqttBatchSecs = strtoumax(mqtt_batch_secs.getValue(), NULL, 10);
+        prefs.mqttBatchColumnar = *mqtt_batch_columnar.getValue();
+        prefs.mqttQos = strtoumax(mqtt_qos.getValue(), NULL, 10);
+        prefs.mqttInflightWindow = strtoumax(mqtt_inflight.getValue(), NULL, 10);
+        prefs.mqttDeltaPayload = *mqtt_delta.getValue();
+        prefs.mqttKeyframeSecs = strtoumax(mqtt_keyframe.getValue(), NULL, 10);
+        prefs.mqttFieldTopics = *mqtt_fields.getValue();
+        prefs.mqttDiscovery = *mqtt_discovery.getValue();
+        prefs.mqttSparkplug = *mqtt_sparkplug.getValue();
+        strlcpy(prefs.sparkplugGroup, sparkplug_group.getValue(), PARAMETER_SIZE+1);
+        prefs.mqttSenml = strtoumax(mqtt_senml.getValue(), NULL, 10);
         strlcpy(prefs.ntpServer, ntp_server.getValue(), PARAMETER_SIZE+1);
         prefs.bleServer = *ble_server.getValue();
         prefs.lorawanEnable = *lorawan_node.getValue();
         prefs.lorawanIntervalSecs = strtoumax(lorawan_interval.getValue(), NULL, 10);
         prefs.lorawanConfirm = *lorawan_confirm.getValue();
+        prefs.lorawanPacked = *lorawan_packed.getValue();
+        prefs.lorawanBatch = *lorawan_batch.getValue();
         strlcpy(prefs.lorawanAppEUI, lorawan_appeui.getValue(), 17);
         strlcpy(prefs.lorawanAppKey, lorawan_appkey.getValue(), 33);
         savePrefs(false);